@@ -0,0 +1,212 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.cpp
+//
+// Identification: src/buffer/arc_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/arc_replacer.h"
+
+#include <algorithm>
+
+#include "common/exception.h"
+#include "fmt/format.h"
+
+namespace bustub {
+
+void ARCReplacer::GhostList::Erase(page_id_t page_id) {
+  auto iter = index_.find(page_id);
+  if (iter != index_.end()) {
+    pages_.erase(iter->second);
+    index_.erase(iter);
+  }
+}
+
+void ARCReplacer::GhostList::PopOldest() {
+  index_.erase(pages_.front());
+  pages_.pop_front();
+}
+
+ARCReplacer::ARCReplacer(size_t num_frames) : node_store_(num_frames), capacity_(num_frames) {}
+
+void ARCReplacer::CheckFrameId(frame_id_t frame_id, const char *caller) const {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= node_store_.size()) {
+    throw Exception(fmt::format("{}: frame_id {} out of the bound {}", caller, frame_id, node_store_.size()));
+  }
+}
+
+void ARCReplacer::Untrack(frame_id_t frame_id, bool evicted) {
+  Node &node = node_store_[frame_id];
+  (node.in_t2_ ? t2_ : t1_).erase(node.pos_);
+
+  if (evicted) {
+    if (node.in_t2_) {
+      stats_.hot_evictions_++;
+    } else {
+      stats_.cold_evictions_++;
+    }
+    if (node.page_id_ != INVALID_PAGE_ID) {
+      (node.in_t2_ ? b2_ : b1_).Push(node.page_id_);
+    }
+    TrimGhostLists();
+  }
+
+  node = Node{};
+  curr_size_--;
+}
+
+void ARCReplacer::TrimGhostLists() {
+  // |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c. After a shrink, T1 and T2 alone may exceed the bounds
+  // until their extra frames are gone.
+  while (!b1_.pages_.empty() && t1_.size() + b1_.Size() > capacity_) {
+    b1_.PopOldest();
+  }
+  while (b1_.Size() + b2_.Size() > 0 && t1_.size() + t2_.size() + b1_.Size() + b2_.Size() > 2 * capacity_) {
+    (b2_.pages_.empty() ? b1_ : b2_).PopOldest();
+  }
+}
+
+auto ARCReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  std::vector<frame_id_t> candidates = Candidates(1);
+  if (candidates.empty()) {
+    return false;
+  }
+  *frame_id = candidates[0];
+  Untrack(*frame_id, true);
+  return true;
+}
+
+auto ARCReplacer::Evict(frame_id_t frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id, "Evict");
+  if (!node_store_[frame_id].evictable_) {
+    return false;
+  }
+  Untrack(frame_id, true);
+  return true;
+}
+
+void ARCReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type, page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id, "RecordAccess");
+  Node &node = node_store_[frame_id];
+  if (!node.tracked_) {
+    node.tracked_ = true;
+    node.page_id_ = page_id;
+    // a scan coming back to a page says nothing about the size T1 should have
+    if (access_type != AccessType::Scan && b1_.Contains(page_id)) {
+      p_ = std::min(capacity_, p_ + std::max<size_t>(b2_.Size() / b1_.Size(), 1));
+      node.in_t2_ = true;
+    } else if (access_type != AccessType::Scan && b2_.Contains(page_id)) {
+      p_ -= std::min(p_, std::max<size_t>(b1_.Size() / b2_.Size(), 1));
+      node.in_t2_ = true;
+    }
+    b1_.Erase(page_id);
+    b2_.Erase(page_id);
+    node.pos_ = node.in_t2_ ? t2_.insert(t2_.end(), frame_id) : t1_.insert(t1_.end(), frame_id);
+    return;
+  }
+
+  if (access_type == AccessType::Scan) {
+    // re-reading a page during a scan says nothing about how hot it is
+    stats_.ignored_scan_accesses_++;
+    return;
+  }
+  t2_.splice(t2_.end(), node.in_t2_ ? t2_ : t1_, node.pos_);
+  node.in_t2_ = true;
+}
+
+void ARCReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id, "SetEvictable");
+  Node &node = node_store_[frame_id];
+  if (!node.tracked_ || node.evictable_ == set_evictable) {
+    return;
+  }
+
+  node.evictable_ = set_evictable;
+  if (set_evictable) {
+    curr_size_++;
+  } else {
+    curr_size_--;
+  }
+}
+
+void ARCReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id, "Remove");
+  Node &node = node_store_[frame_id];
+  if (!node.tracked_) {
+    return;
+  }
+  if (!node.evictable_) {
+    throw Exception(fmt::format("Remove: paged[{}] is unevictable", frame_id));
+  }
+  Untrack(frame_id, false);
+}
+
+auto ARCReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return curr_size_;
+}
+
+void ARCReplacer::SetNumFrames(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (num_frames > node_store_.size()) {
+    node_store_.resize(num_frames);
+  }
+  capacity_ = num_frames;
+  p_ = std::min(p_, capacity_);
+  TrimGhostLists();
+}
+
+auto ARCReplacer::EvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return Candidates(max_frames);
+}
+
+auto ARCReplacer::Candidates(size_t max_frames) -> std::vector<frame_id_t> {
+  // replay the evictions: T1 shrinks with every victim taken from it, which may hand over to T2
+  std::vector<frame_id_t> candidates;
+  candidates.reserve(std::min(max_frames, curr_size_));
+  auto t1_iter = t1_.begin();
+  auto t2_iter = t2_.begin();
+  size_t t1_size = t1_.size();
+  auto next_evictable = [this](std::list<frame_id_t>::iterator *iter, const std::list<frame_id_t> &queue) {
+    while (*iter != queue.end() && !node_store_[**iter].evictable_) {
+      ++*iter;
+    }
+    return *iter != queue.end();
+  };
+  while (candidates.size() < max_frames) {
+    bool t1_left = next_evictable(&t1_iter, t1_);
+    bool t2_left = next_evictable(&t2_iter, t2_);
+    if (t1_left && (PreferT1(t1_size) || !t2_left)) {
+      candidates.push_back(*t1_iter++);
+      t1_size--;
+    } else if (t2_left) {
+      candidates.push_back(*t2_iter++);
+    } else {
+      break;
+    }
+  }
+  return candidates;
+}
+
+auto ARCReplacer::GetStats() -> ReplacerStats {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return stats_;
+}
+
+auto ARCReplacer::GetTargetT1Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return p_;
+}
+
+}  // namespace bustub
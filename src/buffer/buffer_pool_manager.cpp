@@ -12,146 +12,979 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdlib>
+#include <cstring>
+#include <future>  // NOLINT
+#include <iterator>
+#include <new>
+
 #include "common/exception.h"
+#include "common/logger.h"
 #include "common/macros.h"
 #include "storage/page/page_guard.h"
 
 static const bool DEBUG = false;
 namespace bustub {
 
+BufferPoolManager::Shard::Shard(size_t shard_index, size_t num_shards, size_t num_frames, size_t replacer_k,
+                                ReplacerPolicy replacer_policy)
+    : shard_index_(static_cast<frame_id_t>(shard_index)),
+      num_shards_(static_cast<frame_id_t>(num_shards)),
+      num_frames_(num_frames),
+      frame_capacity_(num_frames),
+      replacer_k_(replacer_k),
+      scan_ring_size_(std::clamp<size_t>(num_frames / 4, 1, SCAN_RING_SIZE)) {
+  page_tables_.emplace_back(std::make_unique<ConcurrentPageTable>(num_frames));
+  page_table_ = page_tables_.back().get();
+  replacer_ = MakeReplacer(replacer_policy, num_frames, replacer_k);
+  unlatched_replacer_ = replacer_.get();
+
+  // Initially, every frame of the shard is in the free list, claimed.
+  for (size_t i = 0; i < num_frames; ++i) {
+    free_list_.emplace_back(GlobalFrame(static_cast<frame_id_t>(i)));
+  }
+}
+
 BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
-                                     LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+                                     LogManager *log_manager, size_t num_shards, FrameAllocation frame_allocation,
+                                     ReplacerPolicy replacer_policy)
+    : pool_size_(pool_size),
+      replacer_policy_(replacer_policy),
+      frame_allocation_(frame_allocation),
+      disk_manager_(disk_manager),
+      disk_scheduler_(std::make_unique<DiskScheduler>(disk_manager)),
+      log_manager_(log_manager) {
   // TODO(students): remove this line after you have implemented the buffer pool manager
   // throw NotImplementedException(
   //     "BufferPoolManager is not implemented yet. If you have finished implementing BPM, please remove the throw "
   //     "exception line in `buffer_pool_manager.cpp`.");
 
+  // every shard owns at least one frame
+  num_shards = std::clamp<size_t>(num_shards, 1, std::max<size_t>(pool_size, 1));
+
+  // reserve the address range of the page metadata for the largest pool, it is made accessible as frames are added
+  pages_reserved_ = std::max<size_t>(pool_size, MAX_BUFFER_POOL_SIZE);
+  void *pages = mmap(nullptr, pages_reserved_ * sizeof(Page), PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                     -1, 0);
+  if (pages == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot reserve the page metadata");
+  }
+  pages_ = static_cast<Page *>(pages);
+
   // we allocate a consecutive memory space for the buffer pool
-  pages_ = new Page[pool_size_];
-  replacer_ = std::make_unique<LRUKReplacer>(pool_size, replacer_k);
+  AddFrames(pool_size);
+  LoadAllocationMap();
   if (DEBUG) {
     std::cout << "pool_size = " << pool_size << std::endl;
     std::cout << "replacer_k = " << replacer_k << std::endl;
+    std::cout << "replacer_policy = " << ReplacerPolicyName(replacer_policy) << std::endl;
+    std::cout << "num_shards = " << num_shards << std::endl;
+  }
+
+  // split the frames as evenly as possible, the first (pool_size % num_shards) shards get one extra frame
+  for (size_t i = 0; i < num_shards; ++i) {
+    size_t num_frames = pool_size / num_shards + (i < pool_size % num_shards ? 1 : 0);
+    shards_.emplace_back(std::make_unique<Shard>(i, num_shards, num_frames, replacer_k, replacer_policy));
+  }
+}
+
+BufferPoolManager::~BufferPoolManager() {
+  StopBackgroundWriter();
+
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_latch_);
+    enable_prefetch_ = false;
+  }
+  prefetch_cv_.notify_all();
+  for (auto &worker : prefetch_workers_) {
+    worker.join();
+  }
+
+  FreeFrames();
+}
+
+void BufferPoolManager::AddFrames(size_t num_frames) {
+  if (num_frames == 0) {
+    return;
+  }
+  size_t first_frame = frame_capacity_;
+
+  char *arena = nullptr;
+  size_t arena_size = num_frames * BUSTUB_PAGE_SIZE;
+  if (frame_allocation_ == FrameAllocation::HugePageArena) {
+    // round up to whole huge pages, otherwise the tail of the arena cannot be backed by one
+    size_t mapped_size = (arena_size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void *mapped = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+      LOG_WARN("mmap of the frame arena failed, falling back to a regular arena");
+      frame_allocation_ = FrameAllocation::Arena;
+    } else {
+#ifdef MADV_HUGEPAGE
+      madvise(mapped, mapped_size, MADV_HUGEPAGE);
+#endif
+      arena = static_cast<char *>(mapped);
+      frame_segments_.push_back({arena, mapped_size, true});
+    }
+  }
+  if (frame_allocation_ == FrameAllocation::Arena) {
+    arena = static_cast<char *>(std::aligned_alloc(BUSTUB_PAGE_SIZE, arena_size));
+    if (arena == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate the frame arena");
+    }
+    frame_segments_.push_back({arena, arena_size, false});
+  }
+
+  // the metadata array is allocated on its own, each page only points at its frame
+  size_t committed_size = (first_frame + num_frames) * sizeof(Page);
+  committed_size = (committed_size + BUSTUB_PAGE_SIZE - 1) / BUSTUB_PAGE_SIZE * BUSTUB_PAGE_SIZE;
+  if (committed_size > pages_committed_size_) {
+    char *start = reinterpret_cast<char *>(pages_) + pages_committed_size_;
+    if (mprotect(start, committed_size - pages_committed_size_, PROT_READ | PROT_WRITE) != 0) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate the page metadata");
+    }
+    pages_committed_size_ = committed_size;
+  }
+  for (size_t i = 0; i < num_frames; ++i) {
+    if (arena != nullptr) {
+      new (&pages_[first_frame + i]) Page(arena + i * BUSTUB_PAGE_SIZE);
+    } else {
+      new (&pages_[first_frame + i]) Page();
+    }
+    pages_[first_frame + i].pin_count_ = FRAME_CLAIMED;
+  }
+  frame_capacity_ += num_frames;
+}
+
+void BufferPoolManager::FreeFrames() {
+  for (size_t i = 0; i < frame_capacity_; ++i) {
+    pages_[i].~Page();
+  }
+  munmap(pages_, pages_reserved_ * sizeof(Page));
+
+  for (const FrameSegment &segment : frame_segments_) {
+    if (segment.mapped_) {
+      munmap(segment.data_, segment.size_);
+    } else {
+      std::free(segment.data_);
+    }
+  }
+}
+
+auto BufferPoolManager::Resize(size_t pool_size) -> bool {
+  std::scoped_lock<std::mutex> resize_lock(resize_latch_);
+  if (pool_size < shards_.size() || pool_size > pages_reserved_) {
+    return false;
+  }
+
+  if (pool_size > frame_capacity_) {
+    AddFrames(pool_size - frame_capacity_);
+  }
+  // the same split as in the constructor, so that the frames in use are exactly [0, pool_size)
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    size_t num_frames = pool_size / shards_.size() + (i < pool_size % shards_.size() ? 1 : 0);
+    std::unique_lock<std::mutex> lock = LockShard(*shards_[i]);
+    ResizeShard(*shards_[i], lock, num_frames);
+  }
+  pool_size_ = pool_size;
+  return true;
+}
+
+void BufferPoolManager::ResizeShard(Shard &shard, std::unique_lock<std::mutex> &lock, size_t num_frames) {
+  size_t old_num_frames = shard.num_frames_;
+  if (num_frames > shard.frame_capacity_) {
+    if (num_frames > shard.PageTable().MaxEntries()) {
+      auto page_table = std::make_unique<ConcurrentPageTable>(num_frames);
+      shard.PageTable().ForEach([&page_table](page_id_t page_id, frame_id_t frame_id) {
+        page_table->Insert(page_id, frame_id);
+      });
+      shard.page_tables_.emplace_back(std::move(page_table));
+      shard.page_table_.store(shard.page_tables_.back().get(), std::memory_order_release);
+    }
+    shard.frame_capacity_ = num_frames;
+  }
+  shard.replacer_->SetNumFrames(num_frames);
+
+  if (num_frames >= old_num_frames) {
+    // frames without a page are new or were retired, pages still held by frames that were about to be retired
+    // simply stay
+    for (size_t i = old_num_frames; i < num_frames; ++i) {
+      frame_id_t frame_id = shard.GlobalFrame(static_cast<frame_id_t>(i));
+      if (pages_[frame_id].GetPageId() == INVALID_PAGE_ID) {
+        shard.free_list_.push_back(frame_id);
+      }
+    }
+    shard.num_frames_ = num_frames;
+    return;
+  }
+
+  // from here on, frames beyond num_frames are not handed out anymore and UnpinPage() retires them when it releases
+  // their last pin. The ones that are free or unpinned now are retired right away.
+  shard.num_frames_ = num_frames;
+  for (auto it = shard.free_list_.begin(); it != shard.free_list_.end();) {
+    if (shard.IsRetiring(*it)) {
+      RetireFrameHelper(&pages_[*it]);
+      it = shard.free_list_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (size_t i = num_frames; i < old_num_frames; ++i) {
+    frame_id_t frame_id = shard.GlobalFrame(static_cast<frame_id_t>(i));
+    Page *page = &pages_[frame_id];
+    // the latch may be released to write back a page, so check that the frame was not given up meanwhile
+    if (!shard.IsRetiring(frame_id) || page->GetPageId() == INVALID_PAGE_ID || page->GetPinCount() != 0) {
+      continue;
+    }
+    if (ReleaseFrameHelper(shard, lock, frame_id)) {
+      RetireFrameHelper(page);
+    }
+  }
+}
+
+void BufferPoolManager::RetireFrameHelper(Page *page) {
+  // frames with their own allocation are few and only used by sanitizer builds, they keep their memory
+  if (!page->owns_data_) {
+    madvise(page->GetData(), BUSTUB_PAGE_SIZE, MADV_DONTNEED);
+  }
+}
+
+void BufferPoolManager::ReturnFrameHelper(Shard &shard, frame_id_t frame_id) {
+  if (shard.IsRetiring(frame_id)) {
+    RetireFrameHelper(&pages_[frame_id]);
+  } else {
+    shard.free_list_.push_front(frame_id);
+  }
+}
+
+void BufferPoolManager::StartBackgroundWriter(size_t clean_frames) {
+  std::scoped_lock<std::mutex> lock(bg_writer_latch_);
+  if (bg_writer_thread_ != nullptr) {
+    return;
+  }
+
+  bg_writer_clean_frames_ = clean_frames;
+  enable_bg_writer_ = true;
+  bg_writer_thread_ = new std::thread(&BufferPoolManager::RunBackgroundWriter, this);
+}
+
+void BufferPoolManager::StopBackgroundWriter() {
+  {
+    std::scoped_lock<std::mutex> lock(bg_writer_latch_);
+    if (bg_writer_thread_ == nullptr) {
+      return;
+    }
+    enable_bg_writer_ = false;
+  }
+  bg_writer_cv_.notify_all();
+
+  bg_writer_thread_->join();
+  delete bg_writer_thread_;
+  bg_writer_thread_ = nullptr;
+}
+
+void BufferPoolManager::RunBackgroundWriter() {
+  auto next_warmup_dump = std::chrono::steady_clock::now() + warmup_dump_interval;
+  std::unique_lock<std::mutex> lock(bg_writer_latch_);
+  while (enable_bg_writer_) {
+    lock.unlock();
+    for (auto &shard : shards_) {
+      CleanShard(*shard);
+    }
+    if (std::chrono::steady_clock::now() >= next_warmup_dump) {
+      DumpWarmupList();
+      next_warmup_dump = std::chrono::steady_clock::now() + warmup_dump_interval;
+    }
+    lock.lock();
+    bg_writer_cv_.wait_for(lock, bg_writer_interval, [this] { return !enable_bg_writer_; });
+  }
+  lock.unlock();
+
+  // the pages resident at shutdown are the best guess for the next start
+  DumpWarmupList();
+}
+
+void BufferPoolManager::CleanShard(Shard &shard) {
+  std::unique_lock<std::mutex> lock = LockShard(shard);
+  if (shard.free_list_.size() >= bg_writer_clean_frames_) {
+    return;
   }
 
-  // Initially, every page is in the free list.
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+  // pin the dirty candidates so they can neither be evicted nor deleted while the latch is released for the writes.
+  // Pins leave the replacer alone, so they keep their place in the eviction order.
+  std::vector<frame_id_t> batch;
+  for (frame_id_t local_frame_id :
+       shard.replacer_->EvictionCandidates(bg_writer_clean_frames_ - shard.free_list_.size())) {
+    Page *page = &pages_[shard.GlobalFrame(local_frame_id)];
+    if (!page->IsDirty() || page->GetPinCount() != 0) {
+      continue;
+    }
+
+    page->pin_count_++;
+    page->is_dirty_ = false;
+    page->written_rec_lsn_ = RecLSNHelper();
+    page->io_in_progress_ = true;
+    batch.push_back(shard.GlobalFrame(local_frame_id));
+    if (batch.size() == static_cast<size_t>(BG_WRITER_BATCH_SIZE)) {
+      break;
+    }
+  }
+  if (batch.empty()) {
+    return;
+  }
+
+  // queue the whole batch at once, so that the scheduler writes runs of consecutive pages together
+  lock.unlock();
+  std::vector<DiskRequest> requests;
+  std::vector<std::future<bool>> writes;
+  for (frame_id_t frame_id : batch) {
+    ForceLogHelper(&pages_[frame_id]);
+    auto promise = DiskScheduler::CreatePromise();
+    writes.push_back(promise.get_future());
+    requests.push_back({true, pages_[frame_id].GetData(), pages_[frame_id].GetPageId(), std::move(promise)});
+  }
+  disk_scheduler_->Schedule(std::move(requests));
+  for (auto &write : writes) {
+    write.get();
+  }
+  lock.lock();
+
+  for (frame_id_t frame_id : batch) {
+    Page *page = &pages_[frame_id];
+    page->rec_lsn_ = page->written_rec_lsn_;
+    page->io_in_progress_ = false;
+    page->io_done_.notify_all();
+    page->pin_count_--;
+    UnparkFrameHelper(shard, frame_id);
+  }
+  stats_.Add(BufferPoolStat::BackgroundWrite, batch.size());
+}
+
+auto BufferPoolManager::LockShard(Shard &shard) -> std::unique_lock<std::mutex> {
+  std::unique_lock<std::mutex> lock(shard.latch_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    auto start = std::chrono::steady_clock::now();
+    lock.lock();
+    auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    stats_.Add(BufferPoolStat::LatchWait);
+    stats_.Add(BufferPoolStat::LatchWaitNanos, waited.count());
+  }
+  return lock;
+}
+
+auto BufferPoolManager::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  stats_.Snapshot(&stats);
+  for (auto &shard : shards_) {
+    std::scoped_lock<std::mutex> lock(shard->latch_);
+    std::vector<ReplacerStats> replacers_stats{shard->replacer_->GetStats()};
+    for (const auto &retired : shard->retired_replacers_) {
+      replacers_stats.push_back(retired->GetStats());
+    }
+    for (const ReplacerStats &replacer_stats : replacers_stats) {
+      stats.cold_evictions_ += replacer_stats.cold_evictions_;
+      stats.hot_evictions_ += replacer_stats.hot_evictions_;
+      stats.ignored_scan_accesses_ += replacer_stats.ignored_scan_accesses_;
+    }
   }
+  return stats;
 }
 
-BufferPoolManager::~BufferPoolManager() { delete[] pages_; }
+void BufferPoolManager::SetReplacerPolicy(ReplacerPolicy replacer_policy) {
+  std::scoped_lock<std::mutex> policy_lock(replacer_policy_latch_);
+  for (auto &shard : shards_) {
+    std::unique_lock<std::mutex> lock = LockShard(*shard);
+    // frames about to be retired may still hold pages, so the new replacer covers every frame of the shard
+    std::unique_ptr<Replacer> replacer = MakeReplacer(replacer_policy, shard->frame_capacity_, shard->replacer_k_);
+    replacer->SetNumFrames(shard->num_frames_);
+    // the history of the old policy does not carry over, every resident page starts out as accessed once
+    shard->PageTable().ForEach([&](page_id_t page_id, frame_id_t frame_id) {
+      replacer->RecordAccess(shard->LocalFrame(frame_id), AccessType::Unknown, page_id);
+      replacer->SetEvictable(shard->LocalFrame(frame_id), true);
+      pages_[frame_id].parked_ = false;
+    });
 
-auto BufferPoolManager::FindFrameSlotHepler(frame_id_t *frame_id) -> bool {
+    shard->retired_replacers_.push_back(std::move(shard->replacer_));
+    shard->replacer_ = std::move(replacer);
+    shard->unlatched_replacer_ = shard->replacer_.get();
+  }
+  replacer_policy_ = replacer_policy;
+}
+
+auto BufferPoolManager::GetReplacerPolicy() -> ReplacerPolicy {
+  std::scoped_lock<std::mutex> policy_lock(replacer_policy_latch_);
+  return replacer_policy_;
+}
+
+auto BufferPoolManager::FindFrameSlotHepler(Shard &shard, std::unique_lock<std::mutex> &lock, frame_id_t *frame_id)
+    -> bool {
   // try to get available frame slot
+  while (true) {
+    if (!shard.free_list_.empty()) {
+      *frame_id = shard.free_list_.front();
+      shard.free_list_.pop_front();
+      return true;
+    }
+
+    if (EvictFrameHelper(shard, lock, frame_id)) {
+      if (!shard.IsRetiring(*frame_id)) {
+        return true;
+      }
+      // the victim's frame was given up by Resize() while it was in use
+      RetireFrameHelper(&pages_[*frame_id]);
+      continue;
+    }
+    // a frame may have been freed while the latch was released for a write-back
+    if (shard.free_list_.empty()) {
+      return false;
+    }
+  }
+}
+
+auto BufferPoolManager::EvictFrameHelper(Shard &shard, std::unique_lock<std::mutex> &lock, frame_id_t *frame_id)
+    -> bool {
+  bool record_pending = true;
+  while (true) {
+    std::vector<frame_id_t> candidates = shard.replacer_->EvictionCandidates(EVICTION_CANDIDATES);
+    if (candidates.empty()) {
+      return false;
+    }
+    // the ranking changes once pending hits are recorded, look again. Only once per set of candidates, so that pages
+    // being hit all the time cannot keep the victim from being picked.
+    if (record_pending && RecordPendingAccesses(shard, candidates)) {
+      record_pending = false;
+      continue;
+    }
+
+    bool released = false;
+    for (frame_id_t local_frame_id : candidates) {
+      *frame_id = shard.GlobalFrame(local_frame_id);
+      Page *page = &pages_[*frame_id];
+      if (page->GetPinCount() != 0) {
+        // park the frame until its last unpin, so that evictions do not look at it again meanwhile. The unpin checks
+        // the flag after dropping its pin, the pin count is checked again after setting it.
+        page->parked_ = true;
+        if (page->pin_count_.load() > 0) {
+          shard.replacer_->SetEvictable(local_frame_id, false);
+          continue;
+        }
+        page->parked_ = false;
+      }
+      if (ReleaseFrameHelper(shard, lock, *frame_id)) {
+        return true;
+      }
+      // somebody fetched the victim in the meantime, it stays resident. The latch may have been released, so the
+      // candidates are stale.
+      released = true;
+      break;
+    }
+    if (!released) {
+      // every candidate was parked, the next look sees others
+      record_pending = true;
+    }
+  }
+}
 
-  bool validate = false;
-  if (!free_list_.empty()) {
-    *frame_id = free_list_.front();
-    free_list_.pop_front();
-    validate = true;
-  } else if (replacer_->Evict(frame_id)) {
-    Page *page = &pages_[*frame_id];
-    // dirty page flush to disk first
+auto BufferPoolManager::RecordPendingAccesses(Shard &shard, const std::vector<frame_id_t> &local_frame_ids) -> bool {
+  bool recorded = false;
+  for (frame_id_t local_frame_id : local_frame_ids) {
+    Page *page = &pages_[shard.GlobalFrame(local_frame_id)];
+    uint32_t pending = page->pending_accesses_.exchange(0);
+    if (pending == 0) {
+      continue;
+    }
+    size_t first = page->first_pending_access_.load(std::memory_order_relaxed);
+    size_t last = std::max(first, page->last_pending_access_.load(std::memory_order_relaxed));
+    // only the last k hits can matter, the i-th one is taken to be its share of the way from the first to the last
+    for (size_t i = pending - std::min<size_t>(pending, shard.replacer_k_); i < pending; ++i) {
+      size_t timestamp =
+          pending == 1 ? last
+                       : first + static_cast<size_t>(static_cast<double>(last - first) * i / (pending - 1));
+      shard.replacer_->RecordAccessAt(local_frame_id, timestamp);
+    }
+    recorded = true;
+  }
+  return recorded;
+}
+
+void BufferPoolManager::UnparkFrameHelper(Shard &shard, frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  if (page->GetPinCount() != 0 || !page->parked_.exchange(false)) {
+    return;
+  }
+  frame_id_t local_frame_id = shard.LocalFrame(frame_id);
+  RecordPendingAccesses(shard, {local_frame_id});
+  shard.replacer_->SetEvictable(local_frame_id, true);
+}
+
+auto BufferPoolManager::FindScanFrameHelper(Shard &shard, std::unique_lock<std::mutex> &lock, frame_id_t *frame_id)
+    -> bool {
+  if (shard.scan_ring_.size() < shard.scan_ring_size_) {
+    if (!FindFrameSlotHepler(shard, lock, frame_id)) {
+      return false;
+    }
+    shard.scan_ring_.push_back(*frame_id);
+    return true;
+  }
+
+  size_t slot = shard.scan_ring_next_;
+  shard.scan_ring_next_ = (slot + 1) % shard.scan_ring_.size();
+
+  frame_id_t candidate = shard.scan_ring_[slot];
+  Page *page = &pages_[candidate];
+  if (page->in_scan_ring_ && page->GetPinCount() == 0 && page->GetPageId() != INVALID_PAGE_ID &&
+      !shard.IsRetiring(candidate)) {
+    if (ReleaseFrameHelper(shard, lock, candidate)) {
+      *frame_id = candidate;
+      return true;
+    }
+  }
+
+  // the frame is still in use or has been taken over by a regular page, replace it in the ring
+  if (!FindFrameSlotHepler(shard, lock, frame_id)) {
+    return false;
+  }
+  shard.scan_ring_[slot] = *frame_id;
+  return true;
+}
+
+auto BufferPoolManager::ReleaseFrameHelper(Shard &shard, std::unique_lock<std::mutex> &lock, frame_id_t frame_id)
+    -> bool {
+  Page *page = &pages_[frame_id];
+  while (true) {
+    // dirty page flush to disk first. The victim stays in the page table and pinned by us during the write, so
+    // requesters of it wait on the frame instead of reading a stale copy from disk.
     if (page->IsDirty()) {
-      disk_manager_->WritePage(page->GetPageId(), page->GetData());
+      page->pin_count_++;
       page->is_dirty_ = false;
+      page->written_rec_lsn_ = RecLSNHelper();
+      page->io_in_progress_ = true;
+      lock.unlock();
+      ForceLogHelper(page);
+      disk_scheduler_->ScheduleWrite(page->GetPageId(), page->GetData()).get();
+      stats_.Add(BufferPoolStat::ForegroundWrite);
+      lock.lock();
+      page->rec_lsn_ = page->written_rec_lsn_;
+      page->io_in_progress_ = false;
+      page->pin_count_--;
+      page->io_done_.notify_all();
     }
 
-    page_table_.erase(page->GetPageId());
-    validate = true;
+    if (!TryClaimFrame(page)) {
+      return false;
+    }
+    if (!page->IsDirty()) {
+      break;
+    }
+    // modified by a lock-free pin between the write-back and the claim, write it back again
+    UnclaimFrame(page, 0);
   }
 
-  return validate;
+  // the replacer keeps the history of a parked frame, which must not carry over to the next page
+  if (page->parked_.exchange(false)) {
+    shard.replacer_->SetEvictable(shard.LocalFrame(frame_id), true);
+  }
+  shard.replacer_->Evict(shard.LocalFrame(frame_id));
+  shard.PageTable().Erase(page->GetPageId());
+  page->page_id_ = INVALID_PAGE_ID;
+  page->in_scan_ring_ = false;
+  page->pending_accesses_ = 0;
+  stats_.Add(BufferPoolStat::Eviction);
+  return true;
 }
 
-auto BufferPoolManager::NewPage(page_id_t *page_id) -> Page * {
+auto BufferPoolManager::NewPage(page_id_t *page_id, PageExtent *extent) -> Page * {
   frame_id_t replacement_frame_id = -1;
 
-  std::unique_lock<std::mutex> lock(latch_);
-
-  if (!FindFrameSlotHepler(&replacement_frame_id)) {
+  // The page id decides which shard the page lives in, so it has to be allocated first. While that shard has no frame
+  // to spare, further ids are allocated until one maps to a shard that does, or every shard turned out to be full. The
+  // ids passed over are given back.
+  page_id_t new_page_id = INVALID_PAGE_ID;
+  Shard *shard = nullptr;
+  std::unique_lock<std::mutex> lock;
+  std::vector<bool> shard_full(shards_.size(), false);
+  size_t num_full_shards = 0;
+  std::vector<page_id_t> passed_over;
+  while (num_full_shards < shards_.size()) {
+    new_page_id = AllocatePage(extent);
+    size_t shard_idx = ShardIndexOf(new_page_id);
+    if (!shard_full[shard_idx]) {
+      lock = LockShard(*shards_[shard_idx]);
+      if (FindFrameSlotHepler(*shards_[shard_idx], lock, &replacement_frame_id)) {
+        shard = shards_[shard_idx].get();
+        break;
+      }
+      lock.unlock();
+      shard_full[shard_idx] = true;
+      num_full_shards++;
+    }
+    passed_over.push_back(new_page_id);
+  }
+  for (page_id_t page_id : passed_over) {
+    DeallocatePage(page_id);
+  }
+  if (shard == nullptr) {
+    stats_.Add(BufferPoolStat::NoFreeFrame);
     return nullptr;
   }
 
   // initial page data and metadata
   Page *page = &pages_[replacement_frame_id];
-  page->page_id_ = *page_id = AllocatePage();
-  page->pin_count_ = 1;
+  page->page_id_ = *page_id = new_page_id;
   page->is_dirty_ = false;
-  page_table_[*page_id] = replacement_frame_id;
+  page->rec_lsn_ = RecLSNHelper();
+  page->has_lsn_ = false;
+  page->in_scan_ring_ = false;
+  shard->PageTable().Insert(*page_id, replacement_frame_id);
 
   if (DEBUG) {
     std::cout << "PIN page " << *page_id << std::endl;
   }
 
   // update replacer metadata
-  replacer_->SetEvictable(replacement_frame_id, false);
-  replacer_->RecordAccess(replacement_frame_id);
+  shard->replacer_->RecordAccess(shard->LocalFrame(replacement_frame_id), AccessType::Unknown, new_page_id);
+  shard->replacer_->SetEvictable(shard->LocalFrame(replacement_frame_id), true);
+  UnclaimFrame(page, 1);
 
   return page;
 }
 
-auto BufferPoolManager::FetchPage(page_id_t page_id, [[maybe_unused]] AccessType access_type) -> Page * {
-  std::unique_lock<std::mutex> lock(latch_);
+auto BufferPoolManager::TryFetchResident(page_id_t page_id, AccessType access_type) -> Page * {
+  Shard &shard = ShardOf(page_id);
+  frame_id_t frame_id = shard.PageTable().Lookup(page_id);
+  if (frame_id == ConcurrentPageTable::NOT_FOUND) {
+    return nullptr;
+  }
 
-  auto iter = page_table_.find(page_id);
-  if (iter != page_table_.end()) {
-    frame_id_t frame_id = iter->second;
-    Page *page = &pages_[frame_id];
-    page->pin_count_++;
-    replacer_->SetEvictable(frame_id, false);
-    replacer_->RecordAccess(frame_id);
+  // the frame may be claimed, hold another page by now or still be on its way in; back off to the latched path then
+  Page *page = &pages_[frame_id];
+  if (page->pin_count_.fetch_add(1) < 0) {
+    page->pin_count_.fetch_sub(1);
+    return nullptr;
+  }
+  if (page->GetPageId() != page_id || page->io_in_progress_) {
+    // an eviction may have parked the frame because of this pin
+    if (page->pin_count_.fetch_sub(1) == 1 && page->parked_) {
+      std::unique_lock<std::mutex> lock = LockShard(shard);
+      UnparkFrameHelper(shard, frame_id);
+    }
+    return nullptr;
+  }
 
+  if (access_type != AccessType::Scan) {
+    // the page is used outside of a scan, it must not be recycled by the scan ring anymore
+    if (page->in_scan_ring_.load(std::memory_order_relaxed)) {
+      page->in_scan_ring_ = false;
+    }
+    size_t now = shard.unlatched_replacer_.load(std::memory_order_acquire)->Now();
+    if (page->pending_accesses_.fetch_add(1, std::memory_order_relaxed) == 0) {
+      page->first_pending_access_.store(now, std::memory_order_relaxed);
+    }
+    page->last_pending_access_.store(now, std::memory_order_relaxed);
+  }
+  stats_.Add(BufferPoolStat::Hit);
+  return page;
+}
+
+auto BufferPoolManager::PinPageHelper(Shard &shard, std::unique_lock<std::mutex> &lock, page_id_t page_id,
+                                      AccessType access_type, Page **page) -> PinResult {
+  while (true) {
+    frame_id_t frame_id = shard.PageTable().Find(page_id);
+    if (frame_id != ConcurrentPageTable::NOT_FOUND) {
+      *page = &pages_[frame_id];
+      stats_.Add(BufferPoolStat::Hit);
+      (*page)->pin_count_++;
+      shard.replacer_->RecordAccess(shard.LocalFrame(frame_id), access_type);
+      if (access_type != AccessType::Scan) {
+        // the page is used outside of a scan, it must not be recycled by the scan ring anymore
+        (*page)->in_scan_ring_ = false;
+      }
+
+      if (DEBUG) {
+        std::cout << "PIN page " << page_id << std::endl;
+      }
+      return PinResult::Hit;
+    }
+
+    frame_id_t replacement_frame_id = -1;
+    bool found = access_type == AccessType::Scan ? FindScanFrameHelper(shard, lock, &replacement_frame_id)
+                                                  : FindFrameSlotHepler(shard, lock, &replacement_frame_id);
+    if (!found) {
+      stats_.Add(BufferPoolStat::NoFreeFrame);
+      return PinResult::NoFreeFrame;
+    }
+
+    // the latch may have been dropped to write back the victim, someone else could have brought the page in
+    if (shard.PageTable().Find(page_id) != ConcurrentPageTable::NOT_FOUND) {
+      ReturnFrameHelper(shard, replacement_frame_id);
+      continue;
+    }
+
+    // initial page metadata, the data is read by the caller after releasing the latch
+    stats_.Add(BufferPoolStat::Miss);
+    *page = &pages_[replacement_frame_id];
+    (*page)->page_id_ = page_id;
+    (*page)->is_dirty_ = false;
+    (*page)->rec_lsn_ = RecLSNHelper();
+    (*page)->has_lsn_ = false;
+    (*page)->io_in_progress_ = true;
+    (*page)->in_scan_ring_ = access_type == AccessType::Scan;
+    shard.PageTable().Insert(page_id, replacement_frame_id);
     if (DEBUG) {
       std::cout << "PIN page " << page_id << std::endl;
     }
 
-    return &pages_[frame_id];
+    // update replacer metadata
+    shard.replacer_->RecordAccess(shard.LocalFrame(replacement_frame_id), access_type, page_id);
+    shard.replacer_->SetEvictable(shard.LocalFrame(replacement_frame_id), true);
+    UnclaimFrame(*page, 1);
+    return PinResult::Miss;
   }
+}
 
-  frame_id_t replacement_frame_id = -1;
-  if (!FindFrameSlotHepler(&replacement_frame_id)) {
-    return nullptr;
+auto BufferPoolManager::FetchPage(page_id_t page_id, AccessType access_type) -> Page * {
+  Page *page = TryFetchResident(page_id, access_type);
+  if (page != nullptr) {
+    return page;
   }
 
-  // initial page data and metadata
-  Page *page = &pages_[replacement_frame_id];
-  disk_manager_->ReadPage(page_id, page->GetData());
-  page->page_id_ = page_id;
-  page->pin_count_ = 1;
-  page->is_dirty_ = false;
-  page_table_[page_id] = replacement_frame_id;
-  if (DEBUG) {
-    std::cout << "PIN page " << page_id << std::endl;
+  Shard &shard = ShardOf(page_id);
+  std::unique_lock<std::mutex> lock = LockShard(shard);
+  switch (PinPageHelper(shard, lock, page_id, access_type, &page)) {
+    case PinResult::Hit:
+      // the page may still be on its way in (or out), our pin keeps the frame until the transfer is done
+      WaitForIO(page, lock);
+      return page;
+    case PinResult::Miss:
+      lock.unlock();
+      disk_scheduler_->ScheduleRead(page_id, page->GetData()).get();
+      lock.lock();
+      page->io_in_progress_ = false;
+      page->io_done_.notify_all();
+      return page;
+    case PinResult::NoFreeFrame:
+      break;
   }
+  return nullptr;
+}
 
-  // update replacer metadata
-  replacer_->SetEvictable(replacement_frame_id, false);
-  replacer_->RecordAccess(replacement_frame_id);
+auto BufferPoolManager::FetchPages(const std::vector<page_id_t> &page_ids, AccessType access_type)
+    -> std::vector<Page *> {
+  std::vector<Page *> pages(page_ids.size(), nullptr);
 
-  return page;
+  // positions of the pages that are not pinned by the lock-free path, by shard
+  std::vector<std::vector<size_t>> latched(shards_.size());
+  for (size_t i = 0; i < page_ids.size(); ++i) {
+    pages[i] = TryFetchResident(page_ids[i], access_type);
+    if (pages[i] == nullptr) {
+      latched[ShardIndexOf(page_ids[i])].push_back(i);
+    }
+  }
+
+  for (size_t shard_index = 0; shard_index < shards_.size(); ++shard_index) {
+    if (latched[shard_index].empty()) {
+      continue;
+    }
+
+    Shard &shard = *shards_[shard_index];
+    std::vector<size_t> hits;
+    std::vector<size_t> misses;
+    std::unique_lock<std::mutex> lock = LockShard(shard);
+    for (size_t i : latched[shard_index]) {
+      switch (PinPageHelper(shard, lock, page_ids[i], access_type, &pages[i])) {
+        case PinResult::Hit:
+          hits.push_back(i);
+          break;
+        case PinResult::Miss:
+          misses.push_back(i);
+          break;
+        case PinResult::NoFreeFrame:
+          pages[i] = nullptr;
+          break;
+      }
+    }
+
+    // read all misses of the shard in one go, so that the scheduler reads runs of consecutive pages together
+    if (!misses.empty()) {
+      lock.unlock();
+      std::vector<DiskRequest> requests;
+      std::vector<std::future<bool>> reads;
+      for (size_t i : misses) {
+        auto promise = DiskScheduler::CreatePromise();
+        reads.push_back(promise.get_future());
+        requests.push_back({false, pages[i]->GetData(), page_ids[i], std::move(promise)});
+      }
+      disk_scheduler_->Schedule(std::move(requests));
+      for (auto &read : reads) {
+        read.get();
+      }
+      lock.lock();
+      for (size_t i : misses) {
+        pages[i]->io_in_progress_ = false;
+        pages[i]->io_done_.notify_all();
+      }
+    }
+    for (size_t i : hits) {
+      WaitForIO(pages[i], lock);
+    }
+  }
+
+  return pages;
 }
 
-auto BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty, [[maybe_unused]] AccessType access_type) -> bool {
-  std::unique_lock<std::mutex> lock(latch_);
+void BufferPoolManager::Prefetch(const std::vector<page_id_t> &page_ids, AccessType access_type) {
+  if (page_ids.empty()) {
+    return;
+  }
 
-  auto iter = page_table_.find(page_id);
-  if (iter == page_table_.end()) {
-    return false;
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_latch_);
+    if (prefetch_workers_.empty()) {
+      for (int i = 0; i < PREFETCH_WORKERS; ++i) {
+        prefetch_workers_.emplace_back(&BufferPoolManager::RunPrefetchWorker, this);
+      }
+    }
+
+    for (auto page_id : page_ids) {
+      if (page_id != INVALID_PAGE_ID) {
+        prefetch_queue_.emplace_back(page_id, access_type);
+      }
+    }
+  }
+  prefetch_cv_.notify_all();
+}
+
+void BufferPoolManager::RunPrefetchWorker() {
+  std::unique_lock<std::mutex> lock(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(lock, [this] { return !enable_prefetch_ || !prefetch_queue_.empty(); });
+    if (!enable_prefetch_) {
+      return;
+    }
+
+    // take a run of consecutive pages at once, e.g. from one extent of a table, so that they are read together
+    auto [first_page_id, access_type] = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    std::vector<page_id_t> page_ids{first_page_id};
+    while (!prefetch_queue_.empty() && page_ids.size() < static_cast<size_t>(DISK_SCHEDULER_BATCH) &&
+           prefetch_queue_.front().first == page_ids.back() + 1 && prefetch_queue_.front().second == access_type) {
+      page_ids.push_back(prefetch_queue_.front().first);
+      prefetch_queue_.pop_front();
+    }
+    lock.unlock();
+
+    // a resident page is left alone, fetching it would count as an access for the replacer
+    page_ids.erase(std::remove_if(page_ids.begin(), page_ids.end(),
+                                  [this](page_id_t page_id) {
+                                    return ShardOf(page_id).PageTable().Lookup(page_id) !=
+                                           ConcurrentPageTable::NOT_FOUND;
+                                  }),
+                   page_ids.end());
+    for (Page *page : FetchPages(page_ids, access_type)) {
+      if (page != nullptr) {
+        UnpinPage(page->GetPageId(), false, access_type);
+      }
+    }
+
+    lock.lock();
+  }
+}
+
+auto BufferPoolManager::GetWarmupList() -> std::vector<page_id_t> {
+  // (rank relative to the resident pages of the shard, page id), 0 is the hottest page of a shard
+  std::vector<std::pair<double, page_id_t>> ranked_pages;
+  for (auto &shard : shards_) {
+    std::unique_lock<std::mutex> lock = LockShard(*shard);
+    // parked frames are pinned, i.e. in use right now, they go first
+    shard->PageTable().ForEach([this, &ranked_pages](page_id_t page_id, frame_id_t frame_id) {
+      if (pages_[frame_id].parked_) {
+        ranked_pages.emplace_back(0.0, page_id);
+      }
+    });
+    auto local_frame_ids = shard->replacer_->EvictionCandidates(shard->frame_capacity_);
+    // lock-free hits are only known to the replacer once they are recorded
+    if (RecordPendingAccesses(*shard, local_frame_ids)) {
+      local_frame_ids = shard->replacer_->EvictionCandidates(shard->frame_capacity_);
+    }
+    for (size_t i = 0; i < local_frame_ids.size(); ++i) {
+      page_id_t page_id = pages_[shard->GlobalFrame(local_frame_ids[i])].GetPageId();
+      if (page_id != INVALID_PAGE_ID) {
+        double rank = static_cast<double>(local_frame_ids.size() - 1 - i) / static_cast<double>(local_frame_ids.size());
+        ranked_pages.emplace_back(rank, page_id);
+      }
+    }
+  }
+
+  std::stable_sort(ranked_pages.begin(), ranked_pages.end(),
+                   [](const auto &a, const auto &b) { return a.first < b.first; });
+  std::vector<page_id_t> page_ids;
+  page_ids.reserve(ranked_pages.size());
+  for (const auto &[rank, page_id] : ranked_pages) {
+    page_ids.push_back(page_id);
+  }
+  return page_ids;
+}
+
+void BufferPoolManager::DumpWarmupList() { disk_manager_->WriteWarmupList(GetWarmupList()); }
+
+auto BufferPoolManager::StartWarmup() -> size_t {
+  std::vector<size_t> shard_pages(shards_.size(), 0);
+  std::vector<page_id_t> page_ids;
+  {
+    std::scoped_lock<std::mutex> lock(alloc_latch_);
+    for (page_id_t page_id : disk_manager_->ReadWarmupList()) {
+      size_t shard_index = ShardIndexOf(page_id);
+      if (IsAllocated(page_id) && shard_pages[shard_index] < shards_[shard_index]->num_frames_) {
+        shard_pages[shard_index]++;
+        page_ids.push_back(page_id);
+      }
+    }
+  }
+
+  std::sort(page_ids.begin(), page_ids.end());
+  Prefetch(page_ids);
+  return page_ids.size();
+}
+
+auto BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty, [[maybe_unused]] AccessType access_type) -> bool {
+  Shard &shard = ShardOf(page_id);
+  // the caller's pin keeps the page in its frame, so the lock-free lookup can be trusted unless it misses
+  frame_id_t frame_id = shard.PageTable().Lookup(page_id);
+  std::unique_lock<std::mutex> lock;
+  if (frame_id == ConcurrentPageTable::NOT_FOUND || pages_[frame_id].GetPageId() != page_id) {
+    lock = LockShard(shard);
+    frame_id = shard.PageTable().Find(page_id);
+    if (frame_id == ConcurrentPageTable::NOT_FOUND) {
+      return false;
+    }
   }
 
-  frame_id_t frame_id = iter->second;
   Page *page = &pages_[frame_id];
-  if (page->GetPinCount() == 0) {
-    return false;
+  if (is_dirty) {
+    page->is_dirty_ = true;
   }
+  int pin_count = page->pin_count_.load();
+  do {
+    if (pin_count <= 0) {
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
 
-  page->is_dirty_ |= is_dirty;
-  page->pin_count_--;
-  if (page->GetPinCount() == 0) {
-    replacer_->SetEvictable(frame_id, true);
+  // The last pin of a parked frame makes it evictable again. The one of a frame that Resize() gave up while it was
+  // in use evicts the page and retires the frame.
+  if (pin_count == 1 && (page->parked_ || shard.IsRetiring(frame_id))) {
+    if (!lock.owns_lock()) {
+      lock = LockShard(shard);
+    }
+    if (page->GetPageId() == page_id) {
+      UnparkFrameHelper(shard, frame_id);
+      if (page->GetPinCount() == 0 && shard.IsRetiring(frame_id) && ReleaseFrameHelper(shard, lock, frame_id)) {
+        RetireFrameHelper(page);
+      }
+    }
   }
 
   if (DEBUG) {
@@ -161,67 +994,333 @@ auto BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty, [[maybe_unus
   return true;
 }
 
-auto BufferPoolManager::FlushPage(page_id_t page_id) -> bool {
-  std::unique_lock<std::mutex> lock(latch_);
+auto BufferPoolManager::FlushPage(page_id_t page_id) -> bool { return FlushPageHelper(page_id, false); }
+
+auto BufferPoolManager::FlushPageHelper(page_id_t page_id, bool latch) -> bool {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+
+  Shard &shard = ShardOf(page_id);
+  std::unique_lock<std::mutex> lock = LockShard(shard);
 
-  auto iter = page_table_.find(page_id);
-  if (iter == page_table_.end() || page_id == INVALID_PAGE_ID) {
+  frame_id_t frame_id = shard.PageTable().Find(page_id);
+  if (frame_id == ConcurrentPageTable::NOT_FOUND) {
     return false;
   }
 
-  frame_id_t frame_id = iter->second;
   Page *page = &pages_[frame_id];
-  disk_manager_->WritePage(page_id, page->GetData());
+  // pin the page so it can neither be evicted nor deleted while the latch is released for the write
+  page->pin_count_++;
+  WaitForIO(page, lock);
+  if (latch) {
+    // nobody waits for a page latch while holding a shard latch, so the shard latch is taken again under it
+    lock.unlock();
+    page->RLatch();
+    lock.lock();
+    WaitForIO(page, lock);
+  }
+
+  // threads that already hold a pin may keep modifying the page, clear the flag first so their unpin re-dirties it
   page->is_dirty_ = false;
+  page->written_rec_lsn_ = RecLSNHelper();
+  page->io_in_progress_ = true;
+  lock.unlock();
+  ForceLogHelper(page);
+  disk_scheduler_->ScheduleWrite(page_id, page->GetData()).get();
+  stats_.Add(BufferPoolStat::Flush);
+  if (latch) {
+    page->RUnlatch();
+  }
+  lock.lock();
+  page->rec_lsn_ = page->written_rec_lsn_;
+  page->io_in_progress_ = false;
+  page->io_done_.notify_all();
+  page->pin_count_--;
+  UnparkFrameHelper(shard, frame_id);
 
   return true;
 }
 
+void BufferPoolManager::FlushPages(const std::vector<page_id_t> &page_ids) {
+  for (page_id_t page_id : page_ids) {
+    FlushPageHelper(page_id, true);
+  }
+  disk_manager_->SyncPages();
+}
+
+auto BufferPoolManager::GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>> {
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages;
+  for (auto &shard : shards_) {
+    std::unique_lock<std::mutex> lock = LockShard(*shard);
+    shard->PageTable().ForEach([this, &dirty_pages](page_id_t page_id, frame_id_t frame_id) {
+      // a pinned page may have been changed by a thread that has not unpinned it dirty yet
+      Page *page = &pages_[frame_id];
+      if (page->IsDirty() || page->GetPinCount() > 0) {
+        dirty_pages.emplace_back(page_id, page->rec_lsn_);
+      }
+    });
+  }
+  return dirty_pages;
+}
+
 void BufferPoolManager::FlushAllPages() {
-  std::unique_lock<std::mutex> lock(latch_);
+  // write the dirty pages back in page id order, so that runs of consecutive pages go to disk in a single write
+  std::vector<std::pair<page_id_t, frame_id_t>> dirty_pages;
+  for (auto &shard : shards_) {
+    std::unique_lock<std::mutex> lock = LockShard(*shard);
+    shard->PageTable().ForEach([this, &dirty_pages](page_id_t page_id, frame_id_t frame_id) {
+      if (pages_[frame_id].IsDirty()) {
+        dirty_pages.emplace_back(page_id, frame_id);
+      }
+    });
+  }
+  std::sort(dirty_pages.begin(), dirty_pages.end());
 
-  for (auto &entry : page_table_) {
-    page_id_t page_id = entry.first;
-    auto iter = page_table_.find(page_id);
-    if (iter == page_table_.end() || page_id == INVALID_PAGE_ID) {
+  std::vector<page_id_t> busy_page_ids;
+  for (size_t begin = 0; begin < dirty_pages.size(); begin += FLUSH_BATCH_SIZE) {
+    size_t end = std::min(begin + FLUSH_BATCH_SIZE, dirty_pages.size());
+    FlushBatchHelper(dirty_pages.begin() + begin, dirty_pages.begin() + end, &busy_page_ids);
+  }
+  // pages a writer kept latched or another thread was transferring are written back the slow way, once the writer
+  // is done with them
+  for (page_id_t page_id : busy_page_ids) {
+    FlushPageHelper(page_id, true);
+  }
+
+  disk_manager_->SyncPages();
+  FlushAllocationMap();
+}
+
+void BufferPoolManager::FlushBatchHelper(std::vector<std::pair<page_id_t, frame_id_t>>::const_iterator begin,
+                                         std::vector<std::pair<page_id_t, frame_id_t>>::const_iterator end,
+                                         std::vector<page_id_t> *busy_page_ids) {
+  // pin the pages and mark them in transfer, so that nobody evicts them or writes them back until the batch is on
+  // disk. The read latch keeps writers out while a page is written, so clearing the dirty flag under it is exact:
+  // writers unpin their pages dirty before they release the write latch.
+  std::vector<Page *> batch;
+  for (auto it = begin; it != end; ++it) {
+    auto [page_id, frame_id] = *it;
+    Shard &shard = ShardOf(page_id);
+    std::unique_lock<std::mutex> lock = LockShard(shard);
+    if (shard.PageTable().Find(page_id) != frame_id) {
       continue;
     }
 
-    frame_id_t frame_id = iter->second;
     Page *page = &pages_[frame_id];
-    disk_manager_->WritePage(page_id, page->GetData());
+    if (!page->IsDirty()) {
+      continue;
+    }
+    // a writer may hold the latch of this page while it waits for another page of the batch, never block on it
+    if (page->io_in_progress_ || !page->TryRLatch()) {
+      busy_page_ids->push_back(page_id);
+      continue;
+    }
+    page->pin_count_++;
     page->is_dirty_ = false;
+    page->written_rec_lsn_ = RecLSNHelper();
+    page->io_in_progress_ = true;
+    batch.push_back(page);
+  }
+
+  for (Page *page : batch) {
+    ForceLogHelper(page);
   }
+  for (size_t run_begin = 0, i = 1; i <= batch.size(); i++) {
+    if (i < batch.size() && batch[i]->GetPageId() == batch[i - 1]->GetPageId() + 1) {
+      continue;
+    }
+    std::vector<const char *> pages_data;
+    pages_data.reserve(i - run_begin);
+    for (size_t j = run_begin; j < i; j++) {
+      pages_data.push_back(batch[j]->GetData());
+    }
+    disk_manager_->WritePages(batch[run_begin]->GetPageId(), pages_data);
+    run_begin = i;
+  }
+
+  for (Page *page : batch) {
+    page->RUnlatch();
+    Shard &shard = ShardOf(page->GetPageId());
+    std::unique_lock<std::mutex> lock = LockShard(shard);
+    page->rec_lsn_ = page->written_rec_lsn_;
+    page->io_in_progress_ = false;
+    page->io_done_.notify_all();
+    page->pin_count_--;
+    UnparkFrameHelper(shard, static_cast<frame_id_t>(page - pages_));
+  }
+  stats_.Add(BufferPoolStat::Flush, batch.size());
 }
 
 auto BufferPoolManager::DeletePage(page_id_t page_id) -> bool {
-  std::unique_lock<std::mutex> lock(latch_);
+  Shard &shard = ShardOf(page_id);
+  std::unique_lock<std::mutex> lock = LockShard(shard);
 
-  auto iter = page_table_.find(page_id);
-  if (iter == page_table_.end()) {
+  frame_id_t frame_id = shard.PageTable().Find(page_id);
+  if (frame_id == ConcurrentPageTable::NOT_FOUND) {
+    DeallocatePage(page_id);
     return true;
   }
 
-  frame_id_t frame_id = iter->second;
   Page *page = &pages_[frame_id];
   // some thread is processing this page, Forbid deletion !
-  if (page->GetPinCount() != 0) {
+  if (!TryClaimFrame(page)) {
     return false;
   }
 
   // free page
-  page_table_.erase(page_id);
-  replacer_->Remove(frame_id);
-  free_list_.push_front(frame_id);
+  shard.PageTable().Erase(page_id);
+  if (page->parked_.exchange(false)) {
+    shard.replacer_->SetEvictable(shard.LocalFrame(frame_id), true);
+  }
+  shard.replacer_->Remove(shard.LocalFrame(frame_id));
+  page->page_id_ = INVALID_PAGE_ID;
+  page->in_scan_ring_ = false;
+  page->pending_accesses_ = 0;
+  ReturnFrameHelper(shard, frame_id);
   DeallocatePage(page_id);
 
   return true;
 }
 
-auto BufferPoolManager::AllocatePage() -> page_id_t { return next_page_id_++; }
+void BufferPoolManager::ForceLogHelper(Page *page) {
+  // pages whose lsn was never set, e.g. b+ tree pages, keep other data where it would be
+  if (log_manager_ == nullptr || !enable_logging || !page->HasLSN()) {
+    return;
+  }
+  lsn_t lsn = page->GetLSN();
+  if (lsn > log_manager_->GetPersistentLSN()) {
+    log_manager_->WaitUntilPersistent(lsn);
+  }
+}
+
+auto BufferPoolManager::RecLSNHelper() -> lsn_t {
+  return log_manager_ == nullptr ? INVALID_LSN : log_manager_->GetNextLSN();
+}
+
+void BufferPoolManager::MarkPageAllocated(page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(alloc_latch_);
+  if (IsAllocated(page_id)) {
+    return;
+  }
+  // the ids between the last allocated page and page_id stay free
+  for (page_id_t skipped = next_page_id_; skipped < page_id; ++skipped) {
+    free_page_ids_.insert(skipped);
+  }
+  next_page_id_ = std::max(next_page_id_, page_id + 1);
+  free_page_ids_.erase(page_id);
+  MarkAllocated(page_id, true);
+}
+
+auto BufferPoolManager::AllocatePage(PageExtent *extent) -> page_id_t {
+  std::scoped_lock<std::mutex> lock(alloc_latch_);
+  page_id_t page_id;
+  if (extent != nullptr) {
+    if (extent->next_page_id_ == extent->end_page_id_) {
+      ReserveExtent(extent);
+    }
+    page_id = extent->next_page_id_++;
+  } else if (!free_page_ids_.empty()) {
+    page_id = *free_page_ids_.begin();
+    free_page_ids_.erase(free_page_ids_.begin());
+  } else {
+    page_id = next_page_id_++;
+  }
+
+  MarkAllocated(page_id, true);
+  return page_id;
+}
+
+void BufferPoolManager::ReserveExtent(PageExtent *extent) {
+  // an extent whose pages were all deallocated, e.g. by dropping a table, is reused before the file grows
+  for (auto it = free_page_ids_.begin(); it != free_page_ids_.end();) {
+    page_id_t first_page_id = *it;
+    auto end = free_page_ids_.lower_bound(first_page_id + PAGE_EXTENT_SIZE);
+    if (first_page_id % PAGE_EXTENT_SIZE == 0 && std::distance(it, end) == PAGE_EXTENT_SIZE) {
+      free_page_ids_.erase(it, end);
+      extent->next_page_id_ = first_page_id;
+      extent->end_page_id_ = first_page_id + PAGE_EXTENT_SIZE;
+      return;
+    }
+    it = free_page_ids_.lower_bound((first_page_id / PAGE_EXTENT_SIZE + 1) * PAGE_EXTENT_SIZE);
+  }
+
+  // otherwise the extent goes after the last page, the ids skipped to align it are left to single page allocations
+  page_id_t first_page_id = (next_page_id_ + PAGE_EXTENT_SIZE - 1) / PAGE_EXTENT_SIZE * PAGE_EXTENT_SIZE;
+  for (page_id_t page_id = next_page_id_; page_id < first_page_id; ++page_id) {
+    free_page_ids_.insert(page_id);
+  }
+  next_page_id_ = first_page_id + PAGE_EXTENT_SIZE;
+  extent->next_page_id_ = first_page_id;
+  extent->end_page_id_ = next_page_id_;
+}
+
+void BufferPoolManager::DeallocatePage(page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(alloc_latch_);
+  if (page_id < 0 || page_id >= next_page_id_ ||
+      (alloc_map_[page_id / 64] & (uint64_t{1} << (page_id % 64))) == 0) {
+    return;
+  }
+
+  MarkAllocated(page_id, false);
+  free_page_ids_.insert(page_id);
+}
 
-auto BufferPoolManager::FetchPageBasic(page_id_t page_id) -> BasicPageGuard {
-  Page *page = FetchPage(page_id);
+void BufferPoolManager::MarkAllocated(page_id_t page_id, bool allocated) {
+  size_t map_page_idx = page_id / PAGES_PER_ALLOC_MAP_PAGE;
+  if (alloc_map_.size() <= map_page_idx * WORDS_PER_ALLOC_MAP_PAGE) {
+    alloc_map_.resize((map_page_idx + 1) * WORDS_PER_ALLOC_MAP_PAGE);
+  }
+
+  uint64_t bit = uint64_t{1} << (page_id % 64);
+  if (allocated) {
+    alloc_map_[page_id / 64] |= bit;
+  } else {
+    alloc_map_[page_id / 64] &= ~bit;
+  }
+  dirty_alloc_map_pages_.insert(map_page_idx);
+}
+
+auto BufferPoolManager::IsAllocated(page_id_t page_id) const -> bool {
+  if (page_id < 0 || static_cast<size_t>(page_id / 64) >= alloc_map_.size()) {
+    return false;
+  }
+  return ((alloc_map_[page_id / 64] >> (page_id % 64)) & 1) != 0;
+}
+
+void BufferPoolManager::LoadAllocationMap() {
+  std::scoped_lock<std::mutex> lock(alloc_latch_);
+  char page_data[BUSTUB_PAGE_SIZE];
+  for (size_t map_page_idx = 0; disk_manager_->ReadAllocationMapPage(map_page_idx, page_data); ++map_page_idx) {
+    alloc_map_.resize((map_page_idx + 1) * WORDS_PER_ALLOC_MAP_PAGE);
+    memcpy(&alloc_map_[map_page_idx * WORDS_PER_ALLOC_MAP_PAGE], page_data, BUSTUB_PAGE_SIZE);
+  }
+
+  // new pages go after the last allocated one, the holes below it are reused first
+  for (size_t word = alloc_map_.size(); word-- > 0;) {
+    if (alloc_map_[word] != 0) {
+      next_page_id_ = static_cast<page_id_t>(word * 64 + 64 - __builtin_clzll(alloc_map_[word]));
+      break;
+    }
+  }
+  for (page_id_t page_id = 0; page_id < next_page_id_; ++page_id) {
+    if ((alloc_map_[page_id / 64] & (uint64_t{1} << (page_id % 64))) == 0) {
+      free_page_ids_.insert(page_id);
+    }
+  }
+}
+
+void BufferPoolManager::FlushAllocationMap() {
+  std::scoped_lock<std::mutex> lock(alloc_latch_);
+  for (size_t map_page_idx : dirty_alloc_map_pages_) {
+    disk_manager_->WriteAllocationMapPage(
+        map_page_idx, reinterpret_cast<const char *>(&alloc_map_[map_page_idx * WORDS_PER_ALLOC_MAP_PAGE]));
+  }
+  dirty_alloc_map_pages_.clear();
+}
+
+auto BufferPoolManager::FetchPageBasic(page_id_t page_id, AccessType access_type) -> BasicPageGuard {
+  Page *page = FetchPage(page_id, access_type);
   if (page != nullptr) {
     return {this, page};
   }
@@ -229,8 +1328,8 @@ auto BufferPoolManager::FetchPageBasic(page_id_t page_id) -> BasicPageGuard {
   return {nullptr, nullptr};
 }
 
-auto BufferPoolManager::FetchPageRead(page_id_t page_id) -> ReadPageGuard {
-  Page *page = FetchPage(page_id);
+auto BufferPoolManager::FetchPageRead(page_id_t page_id, AccessType access_type) -> ReadPageGuard {
+  Page *page = FetchPage(page_id, access_type);
 
   if (page != nullptr) {
     page->RLatch();
@@ -240,8 +1339,32 @@ auto BufferPoolManager::FetchPageRead(page_id_t page_id) -> ReadPageGuard {
   return {nullptr, nullptr};
 }
 
-auto BufferPoolManager::FetchPageWrite(page_id_t page_id) -> WritePageGuard {
-  Page *page = FetchPage(page_id);
+auto BufferPoolManager::FetchPagesRead(const std::vector<page_id_t> &page_ids, AccessType access_type)
+    -> std::vector<ReadPageGuard> {
+  std::vector<ReadPageGuard> guards;
+  guards.reserve(page_ids.size());
+  for (Page *page : FetchPages(page_ids, access_type)) {
+    if (page != nullptr) {
+      page->RLatch();
+      guards.emplace_back(this, page);
+    } else {
+      guards.emplace_back(nullptr, nullptr);
+    }
+  }
+  return guards;
+}
+
+auto BufferPoolManager::FetchPageOptimistic(page_id_t page_id, AccessType access_type) -> OptimisticReadGuard {
+  Page *page = FetchPage(page_id, access_type);
+  if (page != nullptr) {
+    return {this, page};
+  }
+
+  return {};
+}
+
+auto BufferPoolManager::FetchPageWrite(page_id_t page_id, AccessType access_type) -> WritePageGuard {
+  Page *page = FetchPage(page_id, access_type);
 
   if (page != nullptr) {
     page->WLatch();
@@ -251,8 +1374,8 @@ auto BufferPoolManager::FetchPageWrite(page_id_t page_id) -> WritePageGuard {
   return {nullptr, nullptr};
 }
 
-auto BufferPoolManager::NewPageGuarded(page_id_t *page_id) -> BasicPageGuard {
-  Page *page = NewPage(page_id);
+auto BufferPoolManager::NewPageGuarded(page_id_t *page_id, PageExtent *extent) -> BasicPageGuard {
+  Page *page = NewPage(page_id, extent);
   if (page != nullptr) {
     return {this, page};
   }
@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.cpp
+//
+// Identification: src/buffer/buffer_pool_stats.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include <functional>
+#include <thread>  // NOLINT
+
+#include "fmt/format.h"
+
+namespace bustub {
+
+/** Names of the BufferPoolStat events, in enum order. */
+static const char *const STAT_NAMES[] = {
+    "hits", "misses", "evictions", "foreground_writes", "background_writes",
+    "flushes", "no_free_frame", "pin_waits", "latch_waits", "latch_wait_ns"};
+static_assert(sizeof(STAT_NAMES) / sizeof(STAT_NAMES[0]) == static_cast<size_t>(BufferPoolStat::Count));
+
+auto BufferPoolStats::HitRate() const -> double {
+  uint64_t fetches = Get(BufferPoolStat::Hit) + Get(BufferPoolStat::Miss);
+  return fetches == 0 ? 0 : static_cast<double>(Get(BufferPoolStat::Hit)) / static_cast<double>(fetches);
+}
+
+auto BufferPoolStats::Fields() const -> std::vector<std::pair<std::string, uint64_t>> {
+  std::vector<std::pair<std::string, uint64_t>> fields;
+  for (size_t i = 0; i < counters_.size(); i++) {
+    fields.emplace_back(STAT_NAMES[i], counters_[i]);
+  }
+  fields.emplace_back("replacer_cold_evictions", cold_evictions_);
+  fields.emplace_back("replacer_hot_evictions", hot_evictions_);
+  fields.emplace_back("replacer_ignored_scan_accesses", ignored_scan_accesses_);
+  return fields;
+}
+
+auto BufferPoolStats::ToJson() const -> std::string {
+  std::string json = "{";
+  for (const auto &[name, value] : Fields()) {
+    json += fmt::format("\"{}\": {}, ", name, value);
+  }
+  json += fmt::format("\"hit_rate\": {:.6f}}}", HitRate());
+  return json;
+}
+
+auto BufferPoolStatCounters::Sum(BufferPoolStat stat) const -> uint64_t {
+  uint64_t sum = 0;
+  for (const auto &stripe : stripes_) {
+    sum += stripe.counters_[static_cast<size_t>(stat)].load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+void BufferPoolStatCounters::Snapshot(BufferPoolStats *stats) const {
+  for (size_t i = 0; i < stats->counters_.size(); i++) {
+    stats->counters_[i] = Sum(static_cast<BufferPoolStat>(i));
+  }
+}
+
+auto BufferPoolStatCounters::LocalStripe() -> Stripe & {
+  thread_local size_t stripe = std::hash<std::thread::id>{}(std::this_thread::get_id()) % NUM_STRIPES;
+  return stripes_[stripe];
+}
+
+}  // namespace bustub
@@ -12,18 +12,151 @@
 
 #include "buffer/clock_replacer.h"
 
+#include <algorithm>
+
+#include "common/exception.h"
+#include "fmt/format.h"
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : frames_(num_pages) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
-auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool { return false; }
+void ClockReplacer::CheckFrameId(frame_id_t frame_id, const char *caller) const {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= frames_.size()) {
+    throw Exception(fmt::format("{}: frame_id {} out of the bound {}", caller, frame_id, frames_.size()));
+  }
+}
+
+void ClockReplacer::Untrack(frame_id_t frame_id, bool evicted) {
+  ClockFrame &frame = frames_[frame_id];
+  if (evicted) {
+    if (frame.reused_) {
+      stats_.hot_evictions_++;
+    } else {
+      stats_.cold_evictions_++;
+    }
+  }
+  frame = ClockFrame{};
+  curr_size_--;
+}
+
+auto ClockReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (curr_size_ == 0) {
+    return false;
+  }
+
+  // every evictable frame is passed at most twice: once to clear its bit and once to evict it
+  while (true) {
+    ClockFrame &frame = frames_[hand_];
+    auto current = static_cast<frame_id_t>(hand_);
+    hand_ = (hand_ + 1) % frames_.size();
+    if (!frame.tracked_ || !frame.evictable_) {
+      continue;
+    }
+    if (frame.referenced_) {
+      frame.referenced_ = false;
+      continue;
+    }
+
+    *frame_id = current;
+    Untrack(current, true);
+    return true;
+  }
+}
+
+auto ClockReplacer::Evict(frame_id_t frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id, "Evict");
+  if (!frames_[frame_id].evictable_) {
+    return false;
+  }
+  Untrack(frame_id, true);
+  return true;
+}
+
+void ClockReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type, [[maybe_unused]] page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id, "RecordAccess");
+  ClockFrame &frame = frames_[frame_id];
+  if (!frame.tracked_) {
+    frame.tracked_ = true;
+    frame.referenced_ = access_type != AccessType::Scan;
+    return;
+  }
+
+  if (access_type == AccessType::Scan) {
+    // re-reading a page during a scan says nothing about how hot it is
+    stats_.ignored_scan_accesses_++;
+    return;
+  }
+  frame.referenced_ = true;
+  frame.reused_ = true;
+}
+
+void ClockReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id, "SetEvictable");
+  ClockFrame &frame = frames_[frame_id];
+  if (!frame.tracked_ || frame.evictable_ == set_evictable) {
+    return;
+  }
+
+  frame.evictable_ = set_evictable;
+  if (set_evictable) {
+    curr_size_++;
+  } else {
+    curr_size_--;
+  }
+}
+
+void ClockReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id, "Remove");
+  ClockFrame &frame = frames_[frame_id];
+  if (!frame.tracked_) {
+    return;
+  }
+  if (!frame.evictable_) {
+    throw Exception(fmt::format("Remove: paged[{}] is unevictable", frame_id));
+  }
+  Untrack(frame_id, false);
+}
+
+auto ClockReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return curr_size_;
+}
+
+void ClockReplacer::SetNumFrames(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (num_frames > frames_.size()) {
+    frames_.resize(num_frames);
+  }
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+auto ClockReplacer::EvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+  std::vector<frame_id_t> candidates;
+  candidates.reserve(std::min(max_frames, curr_size_));
+  for (bool referenced : {false, true}) {
+    for (size_t i = 0; i < frames_.size() && candidates.size() < max_frames; ++i) {
+      size_t slot = (hand_ + i) % frames_.size();
+      const ClockFrame &frame = frames_[slot];
+      if (frame.tracked_ && frame.evictable_ && frame.referenced_ == referenced) {
+        candidates.push_back(static_cast<frame_id_t>(slot));
+      }
+    }
+  }
+  return candidates;
+}
 
-auto ClockReplacer::Size() -> size_t { return 0; }
+auto ClockReplacer::GetStats() -> ReplacerStats {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return stats_;
+}
 
 }  // namespace bustub
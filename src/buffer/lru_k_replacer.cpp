@@ -11,10 +11,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/lru_k_replacer.h"
-#include <climits>
-#include <cmath>
+#include <algorithm>
 #include <cstddef>
-#include <memory>
 #include <utility>
 #include "common/config.h"
 #include "common/exception.h"
@@ -24,128 +22,209 @@
 static const bool DEBUG = false;
 namespace bustub {
 
-LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(num_frames), k_(k) {
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(0), k_(std::max<size_t>(k, 1)) {
   if (DEBUG) {
     std::cout << "k = " << k << std::endl;
     std::cout << "num_frames = " << num_frames << std::endl;
   }
+
+  SetNumFrames(num_frames);
+}
+
+void LRUKReplacer::SetNumFrames(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (num_frames <= replacer_size_) {
+    return;
+  }
+
+  // tracked nodes are referenced by frame id only, so growing the store leaves them intact
+  node_store_.resize(num_frames);
+  for (size_t i = replacer_size_; i < num_frames; ++i) {
+    node_store_[i].fid_ = static_cast<frame_id_t>(i);
+    node_store_[i].history_.resize(k_);
+  }
+  replacer_size_ = num_frames;
 }
 
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
-  // find largest k-distance backward
-  size_t min_least_recent = LONG_LONG_MAX;
-  size_t min_k_least_recent = LONG_LONG_MAX;
-  bool evict = false;
-
-  latch_.lock();
-  for (const auto &store : node_store_) {
-    if (store.second->is_evictable_) {
-      auto node = store.second;
-      size_t least_recent = node->history_.back();
-      size_t least_k_recent = node->history_.front();
-      if (node->history_.size() < k_ && min_least_recent > least_recent) {
-        *frame_id = node->fid_;
-        min_least_recent = least_recent;
-        min_k_least_recent = 0;
-        evict = true;
-      } else if (min_k_least_recent > least_k_recent) {
-        min_k_least_recent = least_k_recent;
-        *frame_id = node->fid_;
-        evict = true;
-      }
-    }
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  // frames with +inf backward k-distance go first, in LRU order of their first access
+  EvictionQueue &queue = less_than_k_.empty() ? k_accessed_ : less_than_k_;
+  if (queue.empty()) {
+    return false;
   }
 
-  if (evict) {
-    node_store_.erase(*frame_id);
-    if (DEBUG) {
-      std::cout << "evice frame " << *frame_id << std::endl;
-    }
-    curr_size_--;
+  *frame_id = queue.begin()->second;
+  queue.erase(queue.begin());
+  if (&queue == &less_than_k_) {
+    stats_.cold_evictions_++;
+  } else {
+    stats_.hot_evictions_++;
+  }
+
+  LRUKNode &node = node_store_[*frame_id];
+  node.access_cnt_ = 0;
+  node.is_evictable_ = false;
+  curr_size_--;
+  if (DEBUG) {
+    std::cout << "evice frame " << *frame_id << std::endl;
   }
-  latch_.unlock();
 
-  return evict;
+  return true;
 }
 
-void LRUKReplacer::RecordAccess(frame_id_t frame_id, [[maybe_unused]] AccessType access_type) {
+void LRUKReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type, [[maybe_unused]] page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
   if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
     throw Exception(fmt::format("RecordAccess: frame_id {} out of the bound {}", frame_id, replacer_size_));
   }
-
-  latch_.lock();
   if (DEBUG) {
     std::cout << "record frame " << frame_id << std::endl;
   }
-  auto iter = node_store_.find(frame_id);
-  current_timestamp_ = std::chrono::system_clock::now().time_since_epoch().count();
-  if (iter == node_store_.end()) {
-    LRUKNode new_node(frame_id);
-    new_node.history_.push_front(current_timestamp_);
-    node_store_[frame_id] = std::make_shared<LRUKNode>(new_node);
+
+  LRUKNode &node = node_store_[frame_id];
+  if (access_type == AccessType::Scan && node.access_cnt_ != 0) {
+    // re-reading a page during a scan says nothing about how hot it is
+    stats_.ignored_scan_accesses_++;
+    return;
+  }
+
+  if (node.is_evictable_) {
+    QueueOf(node).erase({node.EvictionKey(), frame_id});
+  }
+
+  node.history_[node.Head()] = current_timestamp_++;
+  node.access_cnt_++;
+
+  if (node.is_evictable_) {
+    QueueOf(node).emplace(node.EvictionKey(), frame_id);
+  }
+}
+
+void LRUKReplacer::RecordAccessAt(frame_id_t frame_id, size_t timestamp) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw Exception(fmt::format("RecordAccessAt: frame_id {} out of the bound {}", frame_id, replacer_size_));
+  }
+  LRUKNode &node = node_store_[frame_id];
+  if (node.is_evictable_) {
+    QueueOf(node).erase({node.EvictionKey(), frame_id});
+  }
+
+  if (node.access_cnt_ == 0 || timestamp >= current_timestamp_) {
+    node.history_[node.Head()] = current_timestamp_++;
   } else {
-    auto record = iter->second;
-    record->history_.push_front(current_timestamp_);
+    // merge the access into the last k in time order, oldest first, and keep the k most recent
+    size_t recorded = std::min(node.access_cnt_, k_);
+    std::vector<size_t> history;
+    history.reserve(recorded + 1);
+    for (size_t i = 0; i < recorded; ++i) {
+      history.push_back(node.history_[(node.access_cnt_ - recorded + i) % k_]);
+    }
+    history.insert(std::upper_bound(history.begin(), history.end(), timestamp), timestamp);
+    size_t access_cnt = node.access_cnt_ + 1;
+    size_t kept = std::min(access_cnt, k_);
+    for (size_t i = 0; i < kept; ++i) {
+      node.history_[(access_cnt - kept + i) % k_] = history[history.size() - kept + i];
+    }
   }
+  node.access_cnt_++;
 
-  latch_.unlock();
+  if (node.is_evictable_) {
+    QueueOf(node).emplace(node.EvictionKey(), frame_id);
+  }
 }
 
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::scoped_lock<std::mutex> lock(latch_);
   if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
     throw Exception(fmt::format("SetEvictable: frame_id {} out of the bound {}", frame_id, replacer_size_));
   }
-  latch_.lock();
-  auto iter = node_store_.find(frame_id);
-  if (iter == node_store_.end()) {
-    latch_.unlock();
+  LRUKNode &node = node_store_[frame_id];
+  if (node.access_cnt_ == 0 || node.is_evictable_ == set_evictable) {
     return;
   }
 
-  auto record = iter->second;
-  if (set_evictable && !record->is_evictable_) {
-    record->is_evictable_ = true;
-    if (DEBUG) {
-      std::cout << "SetEvictable frame " << frame_id << " " << set_evictable << std::endl;
-    }
+  if (DEBUG) {
+    std::cout << "SetEvictable frame " << frame_id << " " << set_evictable << std::endl;
+  }
+  node.is_evictable_ = set_evictable;
+  if (set_evictable) {
+    QueueOf(node).emplace(node.EvictionKey(), frame_id);
     curr_size_++;
-  } else if (!set_evictable && record->is_evictable_) {
-    record->is_evictable_ = false;
-    if (DEBUG) {
-      std::cout << "SetEvictable frame " << frame_id << " " << set_evictable << std::endl;
-    }
+  } else {
+    QueueOf(node).erase({node.EvictionKey(), frame_id});
     curr_size_--;
   }
-
-  latch_.unlock();
 }
 
 void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
   if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
     throw Exception(fmt::format("Remove: frame_id {} out of the bound {}", frame_id, replacer_size_));
   }
-
-  latch_.lock();
-
-  auto record = node_store_.find(frame_id);
-  if (record == node_store_.end()) {
-    latch_.unlock();
+  LRUKNode &node = node_store_[frame_id];
+  if (node.access_cnt_ == 0) {
     return;
   }
 
-  if (!record->second->is_evictable_) {
+  if (!node.is_evictable_) {
     throw Exception(fmt::format("Remove: paged[{}] is unevictable", frame_id));
-    latch_.unlock();
-    return;
   }
   if (DEBUG) {
     std::cout << "remove frame " << frame_id << std::endl;
   }
-  node_store_.erase(frame_id);
-  curr_size_--;
 
-  latch_.unlock();
+  QueueOf(node).erase({node.EvictionKey(), frame_id});
+  node.access_cnt_ = 0;
+  node.is_evictable_ = false;
+  curr_size_--;
 }
 
 auto LRUKReplacer::Size() -> size_t { return curr_size_; }
+
+auto LRUKReplacer::EvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  std::vector<frame_id_t> frames;
+  frames.reserve(std::min(max_frames, curr_size_));
+  for (EvictionQueue *queue : {&less_than_k_, &k_accessed_}) {
+    for (auto iter = queue->begin(); iter != queue->end() && frames.size() < max_frames; ++iter) {
+      frames.push_back(iter->second);
+    }
+  }
+
+  return frames;
+}
+
+auto LRUKReplacer::Evict(frame_id_t frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw Exception(fmt::format("Evict: frame_id {} out of the bound {}", frame_id, replacer_size_));
+  }
+  LRUKNode &node = node_store_[frame_id];
+  if (!node.is_evictable_) {
+    return false;
+  }
+
+  EvictionQueue &queue = QueueOf(node);
+  queue.erase({node.EvictionKey(), frame_id});
+  if (&queue == &less_than_k_) {
+    stats_.cold_evictions_++;
+  } else {
+    stats_.hot_evictions_++;
+  }
+  node.access_cnt_ = 0;
+  node.is_evictable_ = false;
+  curr_size_--;
+
+  return true;
+}
+
+auto LRUKReplacer::GetStats() -> ReplacerStats {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return stats_;
+}
+
 }  // namespace bustub
@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer.cpp
+//
+// Identification: src/buffer/replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/replacer.h"
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/two_queue_replacer.h"
+#include "common/exception.h"
+
+namespace bustub {
+
+/** Names of the ReplacerPolicy values, in enum order. */
+static const char *const POLICY_NAMES[] = {"lru-k", "lru", "clock", "2q", "arc"};
+
+auto ReplacerPolicyName(ReplacerPolicy policy) -> std::string { return POLICY_NAMES[static_cast<size_t>(policy)]; }
+
+auto ParseReplacerPolicy(const std::string &name, ReplacerPolicy *policy) -> bool {
+  for (size_t i = 0; i < sizeof(POLICY_NAMES) / sizeof(POLICY_NAMES[0]); i++) {
+    if (name == POLICY_NAMES[i]) {
+      *policy = static_cast<ReplacerPolicy>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+auto MakeReplacer(ReplacerPolicy policy, size_t num_frames, size_t k) -> std::unique_ptr<Replacer> {
+  switch (policy) {
+    case ReplacerPolicy::LRUK:
+      return std::make_unique<LRUKReplacer>(num_frames, k);
+    case ReplacerPolicy::LRU:
+      return std::make_unique<LRUReplacer>(num_frames);
+    case ReplacerPolicy::Clock:
+      return std::make_unique<ClockReplacer>(num_frames);
+    case ReplacerPolicy::TwoQueue:
+      return std::make_unique<TwoQueueReplacer>(num_frames);
+    case ReplacerPolicy::ARC:
+      return std::make_unique<ARCReplacer>(num_frames);
+  }
+  throw Exception("unknown replacer policy");
+}
+
+}  // namespace bustub
@@ -0,0 +1,200 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer.cpp
+//
+// Identification: src/buffer/two_queue_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_queue_replacer.h"
+
+#include <algorithm>
+
+#include "common/exception.h"
+#include "fmt/format.h"
+
+namespace bustub {
+
+TwoQueueReplacer::TwoQueueReplacer(size_t num_frames)
+    : node_store_(num_frames), kin_(std::max<size_t>(num_frames / 4, 1)), kout_(std::max<size_t>(num_frames / 2, 1)) {}
+
+void TwoQueueReplacer::CheckFrameId(frame_id_t frame_id, const char *caller) const {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= node_store_.size()) {
+    throw Exception(fmt::format("{}: frame_id {} out of the bound {}", caller, frame_id, node_store_.size()));
+  }
+}
+
+auto TwoQueueReplacer::EvictionOrder() -> std::vector<std::list<frame_id_t> *> {
+  if (a1in_.size() > kin_) {
+    return {&a1in_, &am_};
+  }
+  return {&am_, &a1in_};
+}
+
+void TwoQueueReplacer::Untrack(frame_id_t frame_id, bool evicted) {
+  Node &node = node_store_[frame_id];
+  if (node.in_am_) {
+    am_.erase(node.pos_);
+  } else {
+    a1in_.erase(node.pos_);
+  }
+
+  if (evicted) {
+    if (node.in_am_) {
+      stats_.hot_evictions_++;
+    } else {
+      stats_.cold_evictions_++;
+      if (node.page_id_ != INVALID_PAGE_ID && a1out_index_.count(node.page_id_) == 0) {
+        a1out_index_[node.page_id_] = a1out_.insert(a1out_.end(), node.page_id_);
+        if (a1out_.size() > kout_) {
+          a1out_index_.erase(a1out_.front());
+          a1out_.pop_front();
+        }
+      }
+    }
+  }
+
+  node = Node{};
+  curr_size_--;
+}
+
+auto TwoQueueReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (auto *queue : EvictionOrder()) {
+    for (frame_id_t candidate : *queue) {
+      if (node_store_[candidate].evictable_) {
+        *frame_id = candidate;
+        Untrack(candidate, true);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+auto TwoQueueReplacer::Evict(frame_id_t frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id, "Evict");
+  if (!node_store_[frame_id].evictable_) {
+    return false;
+  }
+  Untrack(frame_id, true);
+  return true;
+}
+
+void TwoQueueReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type, page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id, "RecordAccess");
+  Node &node = node_store_[frame_id];
+  if (!node.tracked_) {
+    node.tracked_ = true;
+    node.page_id_ = page_id;
+    auto ghost = a1out_index_.find(page_id);
+    if (ghost != a1out_index_.end()) {
+      a1out_.erase(ghost->second);
+      a1out_index_.erase(ghost);
+      // a scan coming back to a page does not prove reuse
+      node.in_am_ = access_type != AccessType::Scan;
+    }
+    node.pos_ = node.in_am_ ? am_.insert(am_.end(), frame_id) : a1in_.insert(a1in_.end(), frame_id);
+    return;
+  }
+
+  if (access_type == AccessType::Scan) {
+    // re-reading a page during a scan says nothing about how hot it is
+    stats_.ignored_scan_accesses_++;
+    return;
+  }
+  if (node.in_am_) {
+    am_.splice(am_.end(), am_, node.pos_);
+  }
+  // accesses while in A1in are correlated with the first one and leave the frame where it is
+}
+
+void TwoQueueReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id, "SetEvictable");
+  Node &node = node_store_[frame_id];
+  if (!node.tracked_ || node.evictable_ == set_evictable) {
+    return;
+  }
+
+  node.evictable_ = set_evictable;
+  if (set_evictable) {
+    curr_size_++;
+  } else {
+    curr_size_--;
+  }
+}
+
+void TwoQueueReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id, "Remove");
+  Node &node = node_store_[frame_id];
+  if (!node.tracked_) {
+    return;
+  }
+  if (!node.evictable_) {
+    throw Exception(fmt::format("Remove: paged[{}] is unevictable", frame_id));
+  }
+  Untrack(frame_id, false);
+}
+
+auto TwoQueueReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return curr_size_;
+}
+
+void TwoQueueReplacer::SetNumFrames(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (num_frames > node_store_.size()) {
+    node_store_.resize(num_frames);
+  }
+  kin_ = std::max<size_t>(num_frames / 4, 1);
+  kout_ = std::max<size_t>(num_frames / 2, 1);
+  while (a1out_.size() > kout_) {
+    a1out_index_.erase(a1out_.front());
+    a1out_.pop_front();
+  }
+}
+
+auto TwoQueueReplacer::EvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  // replay the evictions: A1in shrinks with every victim taken from it, which may hand over to Am
+  std::vector<frame_id_t> candidates;
+  candidates.reserve(std::min(max_frames, curr_size_));
+  auto a1in_iter = a1in_.begin();
+  auto am_iter = am_.begin();
+  size_t a1in_size = a1in_.size();
+  auto next_evictable = [this](std::list<frame_id_t>::iterator *iter, const std::list<frame_id_t> &queue) {
+    while (*iter != queue.end() && !node_store_[**iter].evictable_) {
+      ++*iter;
+    }
+    return *iter != queue.end();
+  };
+  while (candidates.size() < max_frames) {
+    bool a1in_left = next_evictable(&a1in_iter, a1in_);
+    bool am_left = next_evictable(&am_iter, am_);
+    if (a1in_left && (a1in_size > kin_ || !am_left)) {
+      candidates.push_back(*a1in_iter++);
+      a1in_size--;
+    } else if (am_left) {
+      candidates.push_back(*am_iter++);
+    } else {
+      break;
+    }
+  }
+  return candidates;
+}
+
+auto TwoQueueReplacer::GetStats() -> ReplacerStats {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return stats_;
+}
+
+}  // namespace bustub
@@ -3,6 +3,7 @@
 
 #include <optional>
 #include <shared_mutex>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 
@@ -128,11 +129,30 @@ void BustubInstance::HandleExplainStatement(Transaction *txn, const ExplainState
 void BustubInstance::HandleVariableShowStatement(Transaction *txn, const VariableShowStatement &stmt,
                                                  ResultWriter &writer) {
   auto content = GetSessionVariable(stmt.variable_);
+  if (stmt.variable_ == "buffer_pool_size" && buffer_pool_manager_ != nullptr) {
+    content = std::to_string(buffer_pool_manager_->GetPoolSize());
+  }
   WriteOneCell(fmt::format("{}={}", stmt.variable_, content), writer);
 }
 
 void BustubInstance::HandleVariableSetStatement(Transaction *txn, const VariableSetStatement &stmt,
                                                 ResultWriter &writer) {
+  // the buffer pool size is not a session variable, setting it resizes the buffer pool of the instance
+  if (stmt.variable_ == "buffer_pool_size") {
+    if (buffer_pool_manager_ == nullptr) {
+      throw Exception("buffer pool manager is not available");
+    }
+    size_t pool_size = 0;
+    try {
+      pool_size = std::stoul(stmt.value_);
+    } catch (const std::logic_error &e) {
+      throw Exception(fmt::format("invalid buffer pool size: {}", stmt.value_));
+    }
+    if (!buffer_pool_manager_->Resize(pool_size)) {
+      throw Exception(fmt::format("buffer pool size out of range: {}", stmt.value_));
+    }
+    return;
+  }
   session_variables_[stmt.variable_] = stmt.value_;
 }
 
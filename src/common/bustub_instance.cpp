@@ -43,11 +43,14 @@ auto BustubInstance::MakeExecutorContext(Transaction *txn, bool is_modify) -> st
                                            lock_manager_.get(), is_modify);
 }
 
-BustubInstance::BustubInstance(const std::string &db_file_name) {
+BustubInstance::BustubInstance(const std::string &db_file_name)
+    : BustubInstance(db_file_name, DiskIOMode::Buffered) {}
+
+BustubInstance::BustubInstance(const std::string &db_file_name, DiskIOMode io_mode) {
   enable_logging = false;
 
   // Storage related.
-  disk_manager_ = std::make_unique<DiskManager>(db_file_name);
+  disk_manager_ = std::make_unique<DiskManager>(db_file_name, io_mode);
 
   // Log related.
   log_manager_ = std::make_unique<LogManager>(disk_manager_.get());
@@ -71,6 +74,11 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
 
 #ifndef __EMSCRIPTEN__
   lock_manager_->StartDeadlockDetection();
+  if (buffer_pool_manager_ != nullptr) {
+    buffer_pool_manager_->StartBackgroundWriter();
+    // load the pages that were resident before the last shutdown
+    buffer_pool_manager_->StartWarmup();
+  }
 #endif
 
   // Checkpoint related.
@@ -112,6 +120,9 @@ BustubInstance::BustubInstance() {
 
 #ifndef __EMSCRIPTEN__
   lock_manager_->StartDeadlockDetection();
+  if (buffer_pool_manager_ != nullptr) {
+    buffer_pool_manager_->StartBackgroundWriter();
+  }
 #endif
 
   // Checkpoint related.
@@ -166,6 +177,43 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
   writer.EndTable();
 }
 
+void BustubInstance::CmdDisplayBufferPoolStats(ResultWriter &writer) {
+  if (buffer_pool_manager_ == nullptr) {
+    throw Exception("buffer pool manager is not available");
+  }
+  auto stats = buffer_pool_manager_->GetStats();
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("stat");
+  writer.WriteHeaderCell("value");
+  writer.EndHeader();
+  for (const auto &[name, value] : stats.Fields()) {
+    writer.BeginRow();
+    writer.WriteCell(name);
+    writer.WriteCell(fmt::format("{}", value));
+    writer.EndRow();
+  }
+  writer.BeginRow();
+  writer.WriteCell("hit_rate");
+  writer.WriteCell(fmt::format("{:.4f}", stats.HitRate()));
+  writer.EndRow();
+  writer.EndTable();
+}
+
+void BustubInstance::CmdReplacerPolicy(const std::string &policy_name, ResultWriter &writer) {
+  if (buffer_pool_manager_ == nullptr) {
+    throw Exception("buffer pool manager is not available");
+  }
+  if (!policy_name.empty()) {
+    ReplacerPolicy policy;
+    if (!ParseReplacerPolicy(policy_name, &policy)) {
+      throw Exception(fmt::format("unknown replacer policy: {}, expected lru-k, lru, clock, 2q or arc", policy_name));
+    }
+    buffer_pool_manager_->SetReplacerPolicy(policy);
+  }
+  WriteOneCell(ReplacerPolicyName(buffer_pool_manager_->GetReplacerPolicy()), writer);
+}
+
 void BustubInstance::WriteOneCell(const std::string &cell, ResultWriter &writer) {
   writer.BeginTable(true);
   writer.BeginRow();
@@ -179,6 +227,8 @@ void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
 
 \dt: show all tables
 \di: show all indices
+\bpmstats: show buffer pool statistics
+\replacer [policy]: show or switch the buffer pool replacement policy (lru-k, lru, clock, 2q or arc)
 \help: show this message again
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
@@ -219,6 +269,14 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       CmdDisplayIndices(writer);
       return true;
     }
+    if (sql == "\\bpmstats") {
+      CmdDisplayBufferPoolStats(writer);
+      return true;
+    }
+    if (sql == "\\replacer" || StringUtil::StartsWith(sql, "\\replacer ")) {
+      CmdReplacerPolicy(StringUtil::Strip(sql.substr(std::string("\\replacer").size()), ' '), writer);
+      return true;
+    }
     if (sql == "\\help") {
       CmdDisplayHelp(writer);
       return true;
@@ -354,6 +412,9 @@ void BustubInstance::GenerateMockTable() {
 }
 
 BustubInstance::~BustubInstance() {
+  if (checkpoint_manager_ != nullptr) {
+    checkpoint_manager_->StopCheckpointThread();
+  }
   if (enable_logging) {
     log_manager_->StopFlushThread();
   }
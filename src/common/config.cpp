@@ -20,4 +20,12 @@ std::chrono::duration<int64_t> log_timeout = std::chrono::seconds(1);
 
 std::chrono::milliseconds cycle_detection_interval = std::chrono::milliseconds(50);
 
+std::chrono::milliseconds bg_writer_interval = std::chrono::milliseconds(10);
+
+std::chrono::milliseconds warmup_dump_interval = std::chrono::milliseconds(30000);
+
+std::chrono::milliseconds checkpoint_interval = std::chrono::milliseconds(30000);
+
+size_t scan_prefetch_window = 8;
+
 }  // namespace bustub
@@ -25,6 +25,22 @@
 namespace bustub {
 
 void TransactionManager::Commit(Transaction *txn) {
+  lsn_t lsn = INVALID_LSN;
+  {
+    // a checkpoint sees the transaction either active or committing after its BEGIN_CHECKPOINT record
+    std::unique_lock<std::shared_mutex> l(txn_map_mutex_);
+    if (enable_logging) {
+      LogRecord record = LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::COMMIT);
+      lsn = log_manager_->AppendLogRecord(&record);
+      txn->SetPrevLSN(lsn);
+    }
+    active_txns_.erase(txn->GetTransactionId());
+  }
+  if (lsn != INVALID_LSN) {
+    // the transaction is committed once its commit record is on disk, commits arriving meanwhile share that write
+    log_manager_->WaitUntilPersistent(lsn);
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
 
@@ -36,10 +52,10 @@ void TransactionManager::Abort(Transaction *txn) {
   for (auto write_set = (*txn->GetWriteSet()).rbegin(); write_set != (*txn->GetWriteSet()).rend(); write_set++) {
     switch (write_set->wtype_) {
       case WType::INSERT:
-        write_set->table_heap_->UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, true}, write_set->rid_);
+        write_set->table_heap_->UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, true}, write_set->rid_, txn);
         break;
       case WType::DELETE:
-        write_set->table_heap_->UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, false}, write_set->rid_);
+        write_set->table_heap_->UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, false}, write_set->rid_, txn);
         // TODO(jun): I think some bugs there if update tuple meta directly
         // auto tuple_info = write_set.table_heap_->GetTuple(write_set.rid_);
         // write_set.table_heap_->InsertTuple({INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple_info.second);
@@ -49,13 +65,31 @@ void TransactionManager::Abort(Transaction *txn) {
     }
   }
 
+  {
+    std::unique_lock<std::shared_mutex> l(txn_map_mutex_);
+    if (enable_logging) {
+      LogRecord record = LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ABORT);
+      txn->SetPrevLSN(log_manager_->AppendLogRecord(&record));
+    }
+    active_txns_.erase(txn->GetTransactionId());
+  }
+
   ReleaseLocks(txn);
 
   txn->SetState(TransactionState::ABORTED);
 }
 
-void TransactionManager::BlockAllTransactions() { UNIMPLEMENTED("block is not supported now!"); }
+void TransactionManager::BlockAllTransactions() { txn_map_mutex_.lock(); }
+
+void TransactionManager::ResumeTransactions() { txn_map_mutex_.unlock(); }
 
-void TransactionManager::ResumeTransactions() { UNIMPLEMENTED("resume is not supported now!"); }
+auto TransactionManager::GetActiveTransactionTable() -> std::vector<CheckpointTxn> {
+  std::vector<CheckpointTxn> active_txns;
+  active_txns.reserve(active_txns_.size());
+  for (const auto &[txn_id, active_txn] : active_txns_) {
+    active_txns.push_back({txn_id, active_txn.txn_->GetPrevLSN(), active_txn.first_offset_});
+  }
+  return active_txns;
+}
 
 }  // namespace bustub
@@ -43,7 +43,7 @@ auto DeleteExecutor::Next(Tuple *tuple, RID *rid) -> bool {
     }
 
     // delete tuple in heapTable (set field "is_deleted_" to true)
-    table_info_->table_->UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, true}, ch_rid);
+    table_info_->table_->UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, true}, ch_rid, cur_transaction);
     // record transaction write set for abort safty
     TableWriteRecord w_record{plan_->TableOid(), ch_rid, table_info_->table_.get()};
     w_record.wtype_ = WType::DELETE;
@@ -24,22 +24,25 @@ IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanP
 void IndexScanExecutor::Init() {
   cnt_ = 0;
 
-  while (!done_ && !index_iterator_.IsEnd()) {
-    // get rid by index
-    RID rid = (*index_iterator_).second;
-
-    // get tuple by rid
-    auto tuple_info = table_info_->table_->GetTuple(rid);
-    if (tuple_info.first.is_deleted_) {
+  std::vector<RID> rids;
+  while (!done_) {
+    // get rids by index, a batch at a time
+    rids.clear();
+    while (rids.size() < static_cast<size_t>(TUPLE_BATCH_SIZE) && !index_iterator_.IsEnd()) {
+      rids.push_back((*index_iterator_).second);
       ++index_iterator_;
-      continue;
     }
-
-    tuple_info_.emplace_back(std::move(tuple_info.second), rid);
-    ++index_iterator_;
+    done_ = index_iterator_.IsEnd();
+
+    // get tuples by rid, pinning their pages together
+    auto tuple_infos = table_info_->table_->GetTuples(rids);
+    for (size_t i = 0; i < rids.size(); ++i) {
+      if (tuple_infos[i].first.is_deleted_) {
+        continue;
+      }
+      tuple_info_.emplace_back(std::move(tuple_infos[i].second), rids[i]);
+    }
   }
-
-  done_ = true;
 }
 
 auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
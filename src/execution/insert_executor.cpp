@@ -48,38 +48,41 @@ auto InsertExecutor::Next(Tuple *tuple, RID *rid) -> bool {
 
   int32_t cnt = 0;
   Transaction *cur_transaction = exec_ctx_->GetTransaction();
-  while (true) {
-    Tuple ch_tuple;
-    RID ch_rid;
-    if (!child_executor_->Next(&ch_tuple, &ch_rid)) {
-      break;
+  std::vector<IndexInfo *> index_info = exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->name_);
+  std::vector<Tuple> batch;
+  bool child_done = false;
+  while (!child_done) {
+    batch.clear();
+    while (batch.size() < static_cast<size_t>(TUPLE_BATCH_SIZE)) {
+      Tuple ch_tuple;
+      RID ch_rid;
+      if (!child_executor_->Next(&ch_tuple, &ch_rid)) {
+        child_done = true;
+        break;
+      }
+      batch.push_back(std::move(ch_tuple));
     }
 
     // insert into heapTable
-    auto result = table_info_->table_->InsertTuple({INVALID_TXN_ID, INVALID_TXN_ID, false}, ch_tuple, lock_manager_,
-                                                   cur_transaction, plan_->TableOid());
-    BUSTUB_ENSURE(result.has_value(), "Fail to InsertExecutor InsertTuple");
-    RID new_rid = result.value();
-    // record transaction write set for abort safty
-    TableWriteRecord w_record{plan_->TableOid(), new_rid, table_info_->table_.get()};
-    w_record.wtype_ = WType::INSERT;
-    cur_transaction->AppendTableWriteRecord(w_record);
+    std::vector<RID> new_rids = table_info_->table_->InsertTuples({INVALID_TXN_ID, INVALID_TXN_ID, false}, batch,
+                                                                  lock_manager_, cur_transaction, plan_->TableOid());
+    BUSTUB_ENSURE(new_rids.size() == batch.size(), "Fail to InsertExecutor InsertTuple");
 
-    // update index
-    std::vector<IndexInfo *> index_info = exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->name_);
-    for (auto *info : index_info) {
-      // std::cout << std::endl;
-      // std::cout << "update index" << info->name_ << std::endl;
-      Schema *schema = info->index_->GetKeySchema();
+    for (size_t i = 0; i < batch.size(); ++i) {
+      // record transaction write set for abort safty
+      TableWriteRecord w_record{plan_->TableOid(), new_rids[i], table_info_->table_.get()};
+      w_record.wtype_ = WType::INSERT;
+      cur_transaction->AppendTableWriteRecord(w_record);
 
-      // uint32_t num = schema->GetColumnCount();
-      // std::cout << "schema count is " << num << std::endl;
+      // update index
+      for (auto *info : index_info) {
+        Schema *schema = info->index_->GetKeySchema();
+        info->index_->InsertEntry(batch[i].KeyFromTuple(table_info_->schema_, *schema, info->index_->GetKeyAttrs()),
+                                  new_rids[i], exec_ctx_->GetTransaction());
+      }
 
-      info->index_->InsertEntry(ch_tuple.KeyFromTuple(table_info_->schema_, *schema, info->index_->GetKeyAttrs()),
-                                new_rid, exec_ctx_->GetTransaction());
+      cnt++;
     }
-
-    cnt++;
   }
 
   std::vector<Value> value{{INTEGER, cnt}};
@@ -43,7 +43,7 @@ auto UpdateExecutor::Next(Tuple *tuple, RID *rid) -> bool {
     }
 
     // update tuple in heapTable (delete and insert)
-    table_info_->table_->UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, true}, ch_rid);
+    table_info_->table_->UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, true}, ch_rid, exec_ctx_->GetTransaction());
 
     std::vector<Value> values;
     values.reserve(plan_->target_expressions_.size());
@@ -52,7 +52,8 @@ auto UpdateExecutor::Next(Tuple *tuple, RID *rid) -> bool {
     }
 
     Tuple new_tuple = {values, &table_info_->schema_};
-    auto result = table_info_->table_->InsertTuple({INVALID_TXN_ID, INVALID_TXN_ID, false}, new_tuple);
+    auto result = table_info_->table_->InsertTuple({INVALID_TXN_ID, INVALID_TXN_ID, false}, new_tuple, nullptr,
+                                                  exec_ctx_->GetTransaction());
     BUSTUB_ENSURE(result.has_value(), "Fail to UpdateExecutor InsertTuple");
     RID new_rid = result.value();
 
@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.h
+//
+// Identification: src/include/buffer/arc_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ARCReplacer implements the Adaptive Replacement Cache policy (Megiddo and Modha, FAST '03).
+ *
+ * Resident pages live in T1 (seen once recently) or T2 (seen at least twice), both LRU lists. Evicted pages are
+ * remembered by their page id in the ghost lists B1 and B2. A page that comes back while remembered in B1 shows that
+ * T1 is too small and grows the target size p of T1; one remembered in B2 shrinks it. Victims are taken from T1 while
+ * it is larger than p, from T2 otherwise. Scan accesses neither promote pages to T2 nor adapt p.
+ */
+class ARCReplacer : public Replacer {
+ public:
+  /**
+   * @param num_frames the maximum number of frames the replacer will be required to store. The ghost lists remember
+   * as many pages as there are frames.
+   */
+  explicit ARCReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ARCReplacer);
+
+  ~ARCReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  auto Evict(frame_id_t frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown,
+                    page_id_t page_id = INVALID_PAGE_ID) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  /** Grow the node store if needed and make num_frames the c of the paper, trimming the ghost lists to it. */
+  void SetNumFrames(size_t num_frames) override;
+
+  auto EvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> override;
+
+  auto GetStats() -> ReplacerStats override;
+
+  /** @return the current target size of T1 */
+  auto GetTargetT1Size() -> size_t;
+
+ private:
+  struct Node {
+    bool tracked_{false};
+    bool evictable_{false};
+    /** True if the frame is in t2_, otherwise in t1_. */
+    bool in_t2_{false};
+    page_id_t page_id_{INVALID_PAGE_ID};
+    /** Position of the frame in t1_ or t2_. */
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  /** A ghost list, least recently evicted first, with an index by page id. */
+  struct GhostList {
+    std::list<page_id_t> pages_;
+    std::unordered_map<page_id_t, std::list<page_id_t>::iterator> index_;
+
+    auto Size() const -> size_t { return pages_.size(); }
+    auto Contains(page_id_t page_id) const -> bool { return index_.count(page_id) != 0; }
+    void Push(page_id_t page_id) { index_[page_id] = pages_.insert(pages_.end(), page_id); }
+    void Erase(page_id_t page_id);
+    void PopOldest();
+  };
+
+  /** Throw if frame_id is out of the bound. Needs latch_. */
+  void CheckFrameId(frame_id_t frame_id, const char *caller) const;
+
+  /** @return true if victims are taken from T1 first while it holds t1_size frames */
+  auto PreferT1(size_t t1_size) const -> bool { return t1_size > 0 && t1_size > p_; }
+
+  /** EvictionCandidates() for callers holding latch_. */
+  auto Candidates(size_t max_frames) -> std::vector<frame_id_t>;
+
+  /** Stop tracking an evictable frame. An evicted frame is remembered in the ghost list of its list. */
+  void Untrack(frame_id_t frame_id, bool evicted);
+
+  /** Drop the oldest ghosts until the ghost lists fit the bounds of the paper again. */
+  void TrimGhostLists();
+
+  std::vector<Node> node_store_;
+  /** Frames seen once since they were brought in, least recently used first. */
+  std::list<frame_id_t> t1_;
+  /** Frames seen at least twice, least recently used first. */
+  std::list<frame_id_t> t2_;
+  /** Pages recently evicted from T1 and T2. */
+  GhostList b1_;
+  GhostList b2_;
+  /** Target size of T1. */
+  size_t p_{0};
+  /** Number of frames, the c of the paper. */
+  size_t capacity_;
+  size_t curr_size_{0};
+  ReplacerStats stats_;
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -12,21 +12,64 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <limits>
 #include <list>
 #include <memory>
-#include <mutex>  // NOLINT
-#include <unordered_map>
+#include <mutex>   // NOLINT
+#include <set>
+#include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
-#include "buffer/lru_k_replacer.h"
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/concurrent_page_table.h"
+#include "buffer/replacer.h"
 #include "common/config.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_scheduler.h"
 #include "storage/page/page.h"
 #include "storage/page/page_guard.h"
 
 namespace bustub {
 
+/** How BufferPoolManager allocates the memory of its frames. */
+enum class FrameAllocation {
+  /** One heap allocation per frame, so that ASAN catches accesses past the end of a page. */
+  PerFrame,
+  /** One contiguous arena for all frames, every frame aligned to BUSTUB_PAGE_SIZE. */
+  Arena,
+  /** Like Arena, but mapped with mmap and advised to be backed by transparent huge pages. */
+  HugePageArena,
+};
+
+#if defined(__SANITIZE_ADDRESS__)
+static constexpr FrameAllocation DEFAULT_FRAME_ALLOCATION = FrameAllocation::PerFrame;
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+static constexpr FrameAllocation DEFAULT_FRAME_ALLOCATION = FrameAllocation::PerFrame;
+#else
+static constexpr FrameAllocation DEFAULT_FRAME_ALLOCATION = FrameAllocation::Arena;
+#endif
+#else
+static constexpr FrameAllocation DEFAULT_FRAME_ALLOCATION = FrameAllocation::Arena;
+#endif
+
+/**
+ * A run of PAGE_EXTENT_SIZE contiguous page ids reserved for one table heap or index, so that its pages lie next to
+ * each other on disk and a scan over them reads sequentially. The owner only keeps it, NewPage() reserves the extents
+ * and hands out their pages. Reservations are not persisted: after a restart the unused ids of an extent are free.
+ */
+struct PageExtent {
+  /** Next page id of the extent to hand out. */
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  /** One past the last page id of the extent, equal to next_page_id_ once the extent is used up. */
+  page_id_t end_page_id_{INVALID_PAGE_ID};
+};
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
@@ -38,9 +81,17 @@ class BufferPoolManager {
    * @param disk_manager the disk manager
    * @param replacer_k the LookBack constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param num_shards the number of independent partitions the frames are split into. Every shard has its own page
+   * table, free list, replacer and latch, and a page always lives in the shard its page id hashes to. NewPage() passes
+   * over ids of shards without a frame to spare, so it only fails once all shards are full.
+   * @param frame_allocation how the memory of the frames is allocated. Builds with ASAN default to one allocation per
+   * frame, others to a single arena. The page metadata is always kept in a separate array.
+   * @param replacer_policy the replacement policy of every shard, see SetReplacerPolicy()
    */
   BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
-                    LogManager *log_manager = nullptr);
+                    LogManager *log_manager = nullptr, size_t num_shards = 1,
+                    FrameAllocation frame_allocation = DEFAULT_FRAME_ALLOCATION,
+                    ReplacerPolicy replacer_policy = DEFAULT_REPLACER_POLICY);
 
   /**
    * @brief Destroy an existing BufferPoolManager.
@@ -50,9 +101,61 @@ class BufferPoolManager {
   /** @brief Return the size (number of frames) of the buffer pool. */
   auto GetPoolSize() -> size_t { return pool_size_; }
 
-  /** @brief Return the pointer to all the pages in the buffer pool. */
+  /**
+   * @brief Return the pointer to all the pages in the buffer pool, indexed by frame id. Frames added by Resize()
+   * follow the ones the buffer pool was created with.
+   */
   auto GetPages() -> Page * { return pages_; }
 
+  /**
+   * @brief Grow or shrink the buffer pool while it is in use. New frames go to the free lists of the shards. When
+   * shrinking, the frames with the highest ids are given up: free ones right away, unpinned ones after writing back
+   * their page, and pinned ones once their last pin is released, so live guards stay valid. The memory of a frame
+   * given up is returned to the operating system.
+   * @param pool_size the new number of frames, at least one per shard and at most MAX_BUFFER_POOL_SIZE
+   * @return false if pool_size is out of range
+   */
+  auto Resize(size_t pool_size) -> bool;
+
+  /** @brief Return how the memory of the frames was allocated. */
+  auto GetFrameAllocation() -> FrameAllocation { return frame_allocation_; }
+
+  /** @brief Return the replacement policy of the shards. */
+  auto GetReplacerPolicy() -> ReplacerPolicy;
+
+  /**
+   * @brief Switch every shard to another replacement policy while the buffer pool is in use. The access history of
+   * the old policy is dropped, the new one starts with every resident page accessed once.
+   */
+  void SetReplacerPolicy(ReplacerPolicy replacer_policy);
+
+  /** @brief Return the number of shards the buffer pool is partitioned into. */
+  auto GetNumShards() -> size_t { return shards_.size(); }
+
+  /** @brief Return the number of dirty victims written back by the thread that needed their frame. */
+  auto GetForegroundWriteCount() -> uint64_t { return stats_.Sum(BufferPoolStat::ForegroundWrite); }
+
+  /** @brief Return the number of pages written back ahead of eviction by the background writer. */
+  auto GetBackgroundWriteCount() -> uint64_t { return stats_.Sum(BufferPoolStat::BackgroundWrite); }
+
+  /**
+   * @brief Return the counters of the buffer pool and its replacers. Counters are read one by one while other
+   * threads keep counting, so related counters may be slightly out of step.
+   */
+  auto GetStats() -> BufferPoolStats;
+
+  /**
+   * @brief Start the background writer. Every bg_writer_interval it looks at the next frames the replacer of each
+   * shard would evict and writes back the dirty ones, at most BG_WRITER_BATCH_SIZE per shard and round, so that
+   * eviction finds clean frames and the foreground thread does not pay for the write. It also saves the warm-up list,
+   * see DumpWarmupList().
+   * @param clean_frames number of frames per shard, free or next in eviction order, the writer tries to keep clean
+   */
+  void StartBackgroundWriter(size_t clean_frames = BG_WRITER_CLEAN_FRAMES);
+
+  /** @brief Stop the background writer and wait for it to exit. Called by the destructor. */
+  void StopBackgroundWriter();
+
   /**
    * TODO(P1): Add implementation
    *
@@ -68,9 +171,11 @@ class BufferPoolManager {
    * Also, remember to record the access history of the frame in the replacer for the lru-k algorithm to work.
    *
    * @param[out] page_id id of created page
+   * @param extent if not null, the page id is taken from this extent, and a new extent is reserved when it is used up.
+   * Pages of the extent passed over for a full shard are left to single page allocations.
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  auto NewPage(page_id_t *page_id) -> Page *;
+  auto NewPage(page_id_t *page_id, PageExtent *extent = nullptr) -> Page *;
 
   /**
    * TODO(P1): Add implementation
@@ -82,9 +187,10 @@ class BufferPoolManager {
    * BasicPageGuard structure.
    *
    * @param[out] page_id, the id of the new page
+   * @param extent if not null, the extent the page id is taken from, see NewPage()
    * @return BasicPageGuard holding a new page
    */
-  auto NewPageGuarded(page_id_t *page_id) -> BasicPageGuard;
+  auto NewPageGuarded(page_id_t *page_id, PageExtent *extent = nullptr) -> BasicPageGuard;
 
   /**
    * TODO(P1): Add implementation
@@ -93,14 +199,21 @@ class BufferPoolManager {
    * but all frames are currently in use and not evictable (in another word, pinned).
    *
    * First search for page_id in the buffer pool. If not found, pick a replacement frame from either the free list or
-   * the replacer (always find from the free list first), read the page from disk by calling disk_manager_->ReadPage(),
-   * and replace the old page in the frame. Similar to NewPage(), if the old page is dirty, you need to write it back
+   * the replacer (always find from the free list first), read the page from disk through disk_scheduler_, and
+   * replace the old page in the frame. Similar to NewPage(), if the old page is dirty, you need to write it back
    * to disk and update the metadata of the new page
    *
    * In addition, remember to disable eviction and record the access history of the frame like you did for NewPage().
    *
+   * Pages missed by an AccessType::Scan fetch are read into a small ring of frames that is recycled by the scan
+   * itself, so a large sequential scan cannot push the working set out of the pool. Scan hits do not count as an
+   * access for the replacer.
+   *
+   * A hit on a resident page takes no latch: the page is looked up in the concurrent page table and pinned with an
+   * atomic increment, and the access is only recorded in the replacer when the page comes up for eviction.
+   *
    * @param page_id id of page to be fetched
-   * @param access_type type of access to the page, only needed for leaderboard tests.
+   * @param access_type type of access to the page
    * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
    */
   auto FetchPage(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> Page *;
@@ -116,11 +229,69 @@ class BufferPoolManager {
    * the returned page already has a read or write latch held, respectively.
    *
    * @param page_id, the id of the page to fetch
+   * @param access_type type of access to the page, see FetchPage()
    * @return PageGuard holding the fetched page
    */
-  auto FetchPageBasic(page_id_t page_id) -> BasicPageGuard;
-  auto FetchPageRead(page_id_t page_id) -> ReadPageGuard;
-  auto FetchPageWrite(page_id_t page_id) -> WritePageGuard;
+  auto FetchPageBasic(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> BasicPageGuard;
+  auto FetchPageRead(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> ReadPageGuard;
+  auto FetchPageWrite(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> WritePageGuard;
+
+  /**
+   * @brief Pin a set of pages with one pass over the page table of every shard. Resident pages are pinned without a
+   * latch, the rest of a shard's pages are pinned or installed under one acquisition of its latch, and all of its
+   * misses are then read back to back.
+   *
+   * Each entry is pinned once, like a FetchPage() of it, so duplicates have to be unpinned as often as they occur.
+   *
+   * @param page_ids ids of the pages to fetch
+   * @param access_type type of access to the pages, see FetchPage()
+   * @return the pages in the order of page_ids, nullptr for those that could not get a frame
+   */
+  auto FetchPages(const std::vector<page_id_t> &page_ids, AccessType access_type = AccessType::Unknown)
+      -> std::vector<Page *>;
+
+  /**
+   * @brief Like FetchPages(), with every fetched page read latched. Pages that could not be fetched get an invalid
+   * guard. Callers latching several pages must not hold a write latch at the same time.
+   */
+  auto FetchPagesRead(const std::vector<page_id_t> &page_ids, AccessType access_type = AccessType::Unknown)
+      -> std::vector<ReadPageGuard>;
+
+  /**
+   * @brief Like FetchPageRead, except that no latch is taken: the page is only pinned and has to be read
+   * optimistically, see OptimisticReadGuard.
+   */
+  auto FetchPageOptimistic(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> OptimisticReadGuard;
+
+  /**
+   * @brief Read pages into the buffer pool in the background, so that a later FetchPage() of them is a hit. Returns
+   * immediately. Prefetched pages are left unpinned, pages that are already resident are skipped, and a page that
+   * cannot get a frame is not read.
+   *
+   * @param page_ids ids of the pages that will be fetched soon, in the order they will be fetched
+   * @param access_type access type the pages are read with, see FetchPage()
+   */
+  void Prefetch(const std::vector<page_id_t> &page_ids, AccessType access_type = AccessType::Unknown);
+
+  /**
+   * @brief Return the resident pages, hottest first. Every shard ranks its pages in the reverse of the order its
+   * replacer would evict them in, and the shards are interleaved by relative rank.
+   */
+  auto GetWarmupList() -> std::vector<page_id_t>;
+
+  /**
+   * @brief Save GetWarmupList() with the disk manager, see DiskManager::WriteWarmupList(). The background writer
+   * calls this every warmup_dump_interval and once more when it stops.
+   */
+  void DumpWarmupList();
+
+  /**
+   * @brief Warm up the buffer pool after a restart: prefetch the pages of the saved warm-up list, as many of the
+   * hottest ones as fit into each shard, in page id order so that the reads are mostly sequential. Pages that were
+   * deallocated since the list was saved are skipped. Returns immediately, the pages are read in the background.
+   * @return the number of pages queued for prefetching
+   */
+  auto StartWarmup() -> size_t;
 
   /**
    * TODO(P1): Add implementation
@@ -128,8 +299,8 @@ class BufferPoolManager {
    * @brief Unpin the target page from the buffer pool. If page_id is not in the buffer pool or its pin count is already
    * 0, return false.
    *
-   * Decrement the pin count of a page. If the pin count reaches 0, the frame should be evictable by the replacer.
-   * Also, set the dirty flag on the page to indicate if the page was modified.
+   * Decrement the pin count of a page. Once the pin count reaches 0, the replacer may pick the frame for eviction.
+   * Also, set the dirty flag on the page to indicate if the page was modified. Takes no latch for resident pages.
    *
    * @param page_id id of page to be unpinned
    * @param is_dirty true if the page should be marked as dirty, false otherwise
@@ -154,61 +325,388 @@ class BufferPoolManager {
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Flush all the pages in the buffer pool to disk.
+   * @brief Flush all the dirty pages in the buffer pool to disk, followed by the changed pages of the page allocation
+   * map. The pages are written in page id order, runs of consecutive pages with one vectored write, and the database
+   * file is synced once at the end. No shard latch is held during the writes. Every page is written under its read
+   * latch, so the caller must not hold any page latch.
    */
   void FlushAllPages();
 
+  /**
+   * @brief Flush the given pages that are in the buffer pool to disk, dirty or not, e.g. for a checkpoint. Every page
+   * is written under its read latch, waiting for a writer to release it, so the caller must not hold any page latch.
+   * The database file is synced once at the end.
+   * @param page_ids ids of the pages
+   */
+  void FlushPages(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * @brief The dirty page table for a checkpoint: the pages that may hold changes that are not on disk, i.e. the
+   * dirty and the pinned ones, with their recovery lsn. Changes of a page logged before its recovery lsn are on disk.
+   * @return (page id, recovery lsn) pairs
+   */
+  auto GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>>;
+
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Delete a page from the buffer pool. If page_id is not in the buffer pool, do nothing and return true. If the
-   * page is pinned and cannot be deleted, return false immediately.
+   * @brief Delete a page from the buffer pool and give its id back to the page allocation map, so that a later
+   * NewPage() reuses it. If page_id is not in the buffer pool, only give the id back and return true. If the page is
+   * pinned and cannot be deleted, return false immediately.
    *
    * After deleting the page from the page table, stop tracking the frame in the replacer and add the frame
    * back to the free list. Also, reset the page's memory and metadata. Finally, you should call DeallocatePage() to
-   * imitate freeing the page on the disk.
+   * free the page on the disk.
    *
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
    */
   auto DeletePage(page_id_t page_id) -> bool;
 
+  /**
+   * @brief Mark a page allocated that the page allocation map on disk may have missed, e.g. because recovery found it
+   * in the log, so that NewPage() never hands it out again.
+   * @param page_id id of the page
+   */
+  void MarkPageAllocated(page_id_t page_id);
+
+  /**
+   * @brief Write the changed pages of the page allocation map to disk.
+   */
+  void FlushAllocationMap();
+
  private:
-  /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
-  /** The next page id to be allocated  */
-  std::atomic<page_id_t> next_page_id_ = 0;
+  /**
+   * A shard owns every num_shards-th frame, starting at frame shard_index_, together with the page table, free list
+   * and replacer that manage them. Interleaving the frames lets every shard grow and shrink at the end of its range
+   * while the pool-wide frame ids stay dense. The replacer works on shard-local frame ids.
+   */
+  struct Shard {
+    Shard(size_t shard_index, size_t num_shards, size_t num_frames, size_t replacer_k, ReplacerPolicy replacer_policy);
+
+    /** @return the replacer frame id of a pool-wide frame id */
+    auto LocalFrame(frame_id_t frame_id) const -> frame_id_t { return frame_id / num_shards_; }
+
+    /** @return the pool-wide frame id of a replacer frame id */
+    auto GlobalFrame(frame_id_t local_frame_id) const -> frame_id_t { return local_frame_id * num_shards_ + shard_index_; }
 
-  /** Array of buffer pool pages. */
+    /** @return true if the frame is beyond the current size of the shard and is given up once it is unpinned */
+    auto IsRetiring(frame_id_t frame_id) const -> bool {
+      return static_cast<size_t>(LocalFrame(frame_id)) >= num_frames_.load();
+    }
+
+    /** @return the current page table. Lock-free readers may still be probing older ones. */
+    auto PageTable() -> ConcurrentPageTable & { return *page_table_.load(std::memory_order_acquire); }
+
+    /** Index of this shard, also the id of its first frame. */
+    const frame_id_t shard_index_;
+    /** Number of shards of the buffer pool, the distance between two frames of this shard. */
+    const frame_id_t num_shards_;
+    /**
+     * Number of frames in use, changed by Resize() under latch_. Frames with higher local ids are retired or about to
+     * be. Read without the latch by UnpinPage(), which retires a frame whose last pin it releases.
+     */
+    std::atomic<size_t> num_frames_;
+    /** Number of frames that exist, in use or retired. Only grows. */
+    size_t frame_capacity_;
+    /** Page table for keeping track of the pages resident in this shard. Modified under latch_, read without it. */
+    std::atomic<ConcurrentPageTable *> page_table_;
+    /** Every page table the shard has used, the current one last. Outgrown ones are kept for lock-free readers. */
+    std::vector<std::unique_ptr<ConcurrentPageTable>> page_tables_;
+    /**
+     * Replacer to find unpinned pages for replacement. Resident pages are evictable in the replacer until an eviction
+     * finds them pinned and parks them, see Page::parked_ and Replacer.
+     */
+    std::unique_ptr<Replacer> replacer_;
+    /** replacer_ for lock-free hits, which read its clock. */
+    std::atomic<Replacer *> unlatched_replacer_;
+    /** The replacers replaced by SetReplacerPolicy(), kept for their counters and for lock-free hits still reading. */
+    std::vector<std::unique_ptr<Replacer>> retired_replacers_;
+    /** The k of LRU-K replacers, also the most pending accesses of a page worth recording. */
+    const size_t replacer_k_;
+    /** List of free frames that don't have any pages on them. */
+    std::list<frame_id_t> free_list_;
+    /** Frames recycled by scans, at most scan_ring_size_ of them. */
+    std::vector<frame_id_t> scan_ring_;
+    /** Maximum number of frames in scan_ring_. */
+    const size_t scan_ring_size_;
+    /** Slot of scan_ring_ to recycle next. */
+    size_t scan_ring_next_{0};
+    /**
+     * Protects the changes of page_table_, free_list_, replacer_ and the metadata of the pages in this shard, except
+     * for the pins and pending accesses of lock-free hits.
+     */
+    std::mutex latch_;
+  };
+
+  /**
+   * Pin count of a frame that holds no page or whose page is being detached. Lock-free pins see a negative count and
+   * back off, and claiming a frame only succeeds while nobody pins it. Concurrent increments and decrements of racing
+   * pins are kept, so a claimed frame is released by adding rather than storing its new pin count.
+   */
+  static constexpr int FRAME_CLAIMED = std::numeric_limits<int>::min() / 2;
+
+  /** Number of eviction candidates looked at at once. Pinned ones are parked, so the next look sees new ones. */
+  static constexpr size_t EVICTION_CANDIDATES = 16;
+
+  /** Number of pages in the buffer pool, see Resize(). */
+  std::atomic<size_t> pool_size_;
+  /** Number of frames whose metadata was constructed in pages_, in use or retired. Protected by resize_latch_. */
+  size_t frame_capacity_{0};
+  /** Serializes Resize(). */
+  std::mutex resize_latch_;
+  /** Replacement policy of the shards, protected by replacer_policy_latch_. */
+  ReplacerPolicy replacer_policy_;
+  std::mutex replacer_policy_latch_;
+  /** Number of page ids covered by one page of the allocation map. */
+  static constexpr size_t PAGES_PER_ALLOC_MAP_PAGE = BUSTUB_PAGE_SIZE * 8;
+  /** Number of words of alloc_map_ held by one page of the allocation map. */
+  static constexpr size_t WORDS_PER_ALLOC_MAP_PAGE = BUSTUB_PAGE_SIZE / sizeof(uint64_t);
+
+  /** The next page id to be allocated when no deallocated one can be reused. */
+  page_id_t next_page_id_ = 0;
+  /** Page allocation map, one bit per page id that is set while the page is allocated. Always whole map pages. */
+  std::vector<uint64_t> alloc_map_;
+  /** Positions of the allocation map pages changed since they were last written to disk. */
+  std::set<size_t> dirty_alloc_map_pages_;
+  /**
+   * Deallocated page ids below next_page_id_, reused lowest first to keep the database file compact. Also holds the
+   * ids next_page_id_ skipped to align an extent, but never the unused ids of a reserved extent.
+   */
+  std::set<page_id_t> free_page_ids_;
+  /** Protects next_page_id_, alloc_map_, dirty_alloc_map_pages_ and free_page_ids_. */
+  std::mutex alloc_latch_;
+
+  /** Memory of the frames added at once, by the constructor or by a Resize(). */
+  struct FrameSegment {
+    char *data_;
+    size_t size_;
+    /** True if data_ was mapped with mmap, otherwise it was allocated with aligned_alloc. */
+    bool mapped_;
+  };
+
+  /**
+   * Array of buffer pool pages, it only holds their metadata and points into frame_segments_ for the data. The
+   * address range for MAX_BUFFER_POOL_SIZE pages is reserved up front and made accessible as frames are added, so the
+   * array never moves and pages stay valid across Resize().
+   */
   Page *pages_;
+  /** Number of pages the address range of pages_ is reserved for. */
+  size_t pages_reserved_{0};
+  /** Number of bytes at the start of pages_ that are accessible. */
+  size_t pages_committed_size_{0};
+  /** How the page data is allocated, HugePageArena falls back to Arena if the mapping fails. */
+  FrameAllocation frame_allocation_;
+  /** Data memory of the frames, empty for FrameAllocation::PerFrame. */
+  std::vector<FrameSegment> frame_segments_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
-  /** Pointer to the log manager. Please ignore this for P1. */
-  LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
-  /** Replacer to find unpinned pages for replacement. */
-  std::unique_ptr<LRUKReplacer> replacer_;
-  /** List of free frames that don't have any pages on them. */
-  std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
-  std::mutex latch_;
-
-  /**
-   * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
+  /** Carries out the page reads and writes of misses, evictions and write-back on the disk manager. */
+  std::unique_ptr<DiskScheduler> disk_scheduler_;
+  /** Pointer to the log manager, dirty pages are only written back once the log covers them. */
+  LogManager *log_manager_;
+  /** Partitions of the buffer pool, a page belongs to shards_[ShardOf(page_id)]. */
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  /** Event counters, see GetStats(). */
+  BufferPoolStatCounters stats_;
+  /** Background writer thread, nullptr if it is not running. */
+  std::thread *bg_writer_thread_{nullptr};
+  /** Number of frames per shard the background writer tries to keep clean. */
+  size_t bg_writer_clean_frames_{0};
+  /** True while the background writer should keep running. */
+  bool enable_bg_writer_{false};
+  /** Protects enable_bg_writer_, signaled to stop the background writer. */
+  std::mutex bg_writer_latch_;
+  std::condition_variable bg_writer_cv_;
+
+  /** Threads serving prefetch_queue_, started by the first Prefetch(). */
+  std::vector<std::thread> prefetch_workers_;
+  /** Pages waiting to be prefetched. */
+  std::deque<std::pair<page_id_t, AccessType>> prefetch_queue_;
+  /** True while the prefetch workers should keep running. */
+  bool enable_prefetch_{true};
+  /** Protects prefetch_workers_, prefetch_queue_ and enable_prefetch_, signaled when either queue or flag change. */
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+
+  /** @return the shard responsible for the given page */
+  auto ShardOf(page_id_t page_id) -> Shard & { return *shards_[ShardIndexOf(page_id)]; }
+
+  /** @return the index of the shard responsible for the given page */
+  auto ShardIndexOf(page_id_t page_id) const -> size_t { return static_cast<size_t>(page_id) % shards_.size(); }
+
+  /**
+   * @brief Allocate a page on disk, reusing the lowest deallocated page id if there is one.
+   * @param extent if not null, allocate the next page of this extent instead, reserving a new one if it is used up
    * @return the id of the allocated page
    */
-  auto AllocatePage() -> page_id_t;
+  auto AllocatePage(PageExtent *extent = nullptr) -> page_id_t;
+
+  /**
+   * @brief Reserve PAGE_EXTENT_SIZE contiguous page ids for extent, reusing the lowest extent whose pages are all
+   * deallocated if there is one. Caller should hold alloc_latch_.
+   */
+  void ReserveExtent(PageExtent *extent);
+
+  /**
+   * @brief Write-ahead rule: block until the log records applied to page are on disk, before page is written back.
+   * Does nothing while logging is disabled.
+   */
+  void ForceLogHelper(Page *page);
+
+  /**
+   * @brief The recovery lsn of a page that is read or written back now: changes logged from now on may be missing in
+   * the copy on disk.
+   */
+  auto RecLSNHelper() -> lsn_t;
+
+  /**
+   * @brief Write back a page for FlushPage(), FlushPages() and the pages FlushAllPages() found busy.
+   * @param latch true to write the page under its read latch
+   * @return false if the page is not in the buffer pool
+   */
+  auto FlushPageHelper(page_id_t page_id, bool latch) -> bool;
 
   /**
-   * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Deallocate a page on disk. Page ids that are not allocated are ignored.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
+
+  /**
+   * @brief Read the page allocation map from disk and recover next_page_id_ and free_page_ids_ from it.
+   */
+  void LoadAllocationMap();
+
+  /**
+   * @brief Set or clear the bit of a page in the allocation map. Caller should hold alloc_latch_.
+   */
+  void MarkAllocated(page_id_t page_id, bool allocated);
+
+  /**
+   * @brief Return whether a page is set in the allocation map. Caller should hold alloc_latch_.
+   */
+  auto IsAllocated(page_id_t page_id) const -> bool;
 
   // TODO(student): You may add additional private members and helper functions
-  auto FindFrameSlotHepler(frame_id_t *frame_id) -> bool;
+  /**
+   * @brief Take a frame from the shard's free list or evict one. A dirty victim is written back with the shard latch
+   * released, so the caller must re-validate anything it looked up before calling this.
+   * @param[out] frame_id a claimed frame, see FRAME_CLAIMED
+   * @return false if every frame of the shard is pinned
+   */
+  auto FindFrameSlotHepler(Shard &shard, std::unique_lock<std::mutex> &lock, frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Evict the unpinned page the replacer ranks first. The pending accesses of the next candidates are recorded
+   * first, so pages hit without the latch are ranked by those hits too. Candidates that are pinned are parked.
+   * @return false if every resident page of the shard is pinned
+   */
+  auto EvictFrameHelper(Shard &shard, std::unique_lock<std::mutex> &lock, frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Record the pending accesses of the given shard-local frames in the replacer, at the times they happened.
+   * Only the first and the last time are kept, the accesses in between are taken to be spread evenly.
+   * @return true if any frame had pending accesses
+   */
+  auto RecordPendingAccesses(Shard &shard, const std::vector<frame_id_t> &local_frame_ids) -> bool;
+
+  /**
+   * @brief Make a parked frame evictable again once it is unpinned, recording its pending accesses first. Caller
+   * should hold the shard latch.
+   */
+  void UnparkFrameHelper(Shard &shard, frame_id_t frame_id);
+
+  /** Outcome of PinPageHelper(). */
+  enum class PinResult { Hit, Miss, NoFreeFrame };
+
+  /**
+   * @brief Pin a page under the shard latch. A hit may still be in transfer, the caller has to WaitForIO() before
+   * using it. A miss gets a frame marked io_in_progress_, the caller reads the page and clears the flag.
+   * @param[out] page the pinned page, unless every frame of the shard is pinned
+   */
+  auto PinPageHelper(Shard &shard, std::unique_lock<std::mutex> &lock, page_id_t page_id, AccessType access_type,
+                     Page **page) -> PinResult;
+
+  /**
+   * @brief Pin a resident page without taking the shard latch.
+   * @return the page, or nullptr if it is not resident, is being transferred or raced with its eviction
+   */
+  auto TryFetchResident(page_id_t page_id, AccessType access_type) -> Page *;
+
+  /** @brief Claim an unpinned frame, see FRAME_CLAIMED. */
+  static auto TryClaimFrame(Page *page) -> bool {
+    int expected = 0;
+    return page->pin_count_.compare_exchange_strong(expected, FRAME_CLAIMED);
+  }
+
+  /** @brief Give up the claim on a frame, leaving it with pin_count pins. */
+  static void UnclaimFrame(Page *page, int pin_count) { page->pin_count_.fetch_add(pin_count - FRAME_CLAIMED); }
+
+  /**
+   * @brief Like FindFrameSlotHepler(), but for pages read by a scan: recycle the next frame of the shard's scan ring if
+   * it still holds an unpinned scan page, otherwise take a regular frame and make it part of the ring.
+   */
+  auto FindScanFrameHelper(Shard &shard, std::unique_lock<std::mutex> &lock, frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Detach the page held by an unpinned frame, writing it back first if it is dirty, and stop tracking the
+   * frame in the replacer. The shard latch is released during the write.
+   * @return false if the page was pinned again meanwhile, in which case it stays resident; otherwise the frame is
+   * claimed
+   */
+  auto ReleaseFrameHelper(Shard &shard, std::unique_lock<std::mutex> &lock, frame_id_t frame_id) -> bool;
+
+  /**
+   * @brief Add num_frames frames behind the existing ones in pages_, claimed. Unless frame_allocation_ is PerFrame,
+   * their data is one new segment. Caller should hold resize_latch_ once the buffer pool is in use.
+   */
+  void AddFrames(size_t num_frames);
+
+  /** @brief Destroy pages_ and release the frame segments. */
+  void FreeFrames();
+
+  /**
+   * @brief Change the number of frames a shard uses, see Resize().
+   */
+  void ResizeShard(Shard &shard, std::unique_lock<std::mutex> &lock, size_t num_frames);
+
+  /** @brief Return the memory of a claimed frame without a page to the operating system. It stays claimed. */
+  void RetireFrameHelper(Page *page);
+
+  /** @brief Put a claimed frame without a page back into the free list, or retire it if the shard gave it up. */
+  void ReturnFrameHelper(Shard &shard, frame_id_t frame_id);
+
+  /** @brief Main loop of the background writer. */
+  void RunBackgroundWriter();
+
+  /** @brief Write back the dirty pages among the next frames the shard would evict. */
+  void CleanShard(Shard &shard);
+
+  /**
+   * @brief Write back a batch of dirty pages for FlushAllPages().
+   * @param begin, end the (page id, frame id) pairs of the batch, sorted by page id
+   * @param[out] busy_page_ids pages that were skipped because they were latched by a writer or in transfer
+   */
+  void FlushBatchHelper(std::vector<std::pair<page_id_t, frame_id_t>>::const_iterator begin,
+                        std::vector<std::pair<page_id_t, frame_id_t>>::const_iterator end,
+                        std::vector<page_id_t> *busy_page_ids);
+
+  /** @brief Main loop of a prefetch worker. */
+  void RunPrefetchWorker();
+
+  /**
+   * @brief Wait until no disk I/O is in flight on the page. The shard latch is released while waiting.
+   */
+  void WaitForIO(Page *page, std::unique_lock<std::mutex> &lock) {
+    if (page->io_in_progress_) {
+      stats_.Add(BufferPoolStat::PinWait);
+      page->io_done_.wait(lock, [page] { return !page->io_in_progress_; });
+    }
+  }
+
+  /** @brief Take the latch of a shard, counting the time spent waiting for it if it is contended. */
+  auto LockShard(Shard &shard) -> std::unique_lock<std::mutex>;
 };
 }  // namespace bustub
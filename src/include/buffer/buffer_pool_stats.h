@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+/** The events the buffer pool counts. */
+enum class BufferPoolStat : size_t {
+  Hit = 0,          // FetchPage found the page resident
+  Miss,             // FetchPage read the page from disk
+  Eviction,         // a resident page was replaced to free its frame
+  ForegroundWrite,  // a dirty victim was written back by the thread that needed its frame
+  BackgroundWrite,  // a dirty page was written back by the background writer
+  Flush,            // a page was written back by FlushPage or FlushAllPages
+  NoFreeFrame,      // NewPage failed because every frame was pinned, or FetchPage because those of the shard were
+  PinWait,          // a pinned page was waited for until another thread finished its disk I/O
+  LatchWait,        // a shard latch was contended and had to be waited for
+  LatchWaitNanos,   // total time spent waiting for contended shard latches
+  Count
+};
+
+/** A consistent-enough copy of the buffer pool counters, see BufferPoolManager::GetStats(). */
+struct BufferPoolStats {
+  std::array<uint64_t, static_cast<size_t>(BufferPoolStat::Count)> counters_{};
+  /** Replacer counters summed over all shards, see ReplacerStats. */
+  uint64_t cold_evictions_{0};
+  uint64_t hot_evictions_{0};
+  uint64_t ignored_scan_accesses_{0};
+
+  auto Get(BufferPoolStat stat) const -> uint64_t { return counters_[static_cast<size_t>(stat)]; }
+
+  /** @return fraction of FetchPage calls that were hits, 0 if there were none */
+  auto HitRate() const -> double;
+
+  /** @return all counters as (name, value) pairs, in a stable order */
+  auto Fields() const -> std::vector<std::pair<std::string, uint64_t>>;
+
+  /** @return the counters as a flat JSON object */
+  auto ToJson() const -> std::string;
+};
+
+/**
+ * BufferPoolStatCounters counts buffer pool events without a shared hot cache line. Every thread adds to one of
+ * NUM_STRIPES cache line sized stripes of relaxed atomics, picked by its thread id, and readers sum the stripes up.
+ */
+class BufferPoolStatCounters {
+ public:
+  /** Count n occurrences of stat. */
+  void Add(BufferPoolStat stat, uint64_t n = 1) {
+    LocalStripe().counters_[static_cast<size_t>(stat)].fetch_add(n, std::memory_order_relaxed);
+  }
+
+  /** @return the total of stat over all threads */
+  auto Sum(BufferPoolStat stat) const -> uint64_t;
+
+  /** Fill the buffer pool counters of stats. */
+  void Snapshot(BufferPoolStats *stats) const;
+
+ private:
+  static constexpr size_t NUM_STRIPES = 16;
+
+  struct alignas(64) Stripe {
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(BufferPoolStat::Count)> counters_{};
+  };
+
+  auto LocalStripe() -> Stripe &;
+
+  std::array<Stripe, NUM_STRIPES> stripes_;
+};
+
+}  // namespace bustub
@@ -12,17 +12,21 @@
 
 #pragma once
 
-#include <list>
 #include <mutex>  // NOLINT
 #include <vector>
 
 #include "buffer/replacer.h"
 #include "common/config.h"
+#include "common/macros.h"
 
 namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * The frames form a ring swept by a clock hand. Every access sets the reference bit of a frame. The hand clears the
+ * reference bits it passes and evicts the first evictable frame whose bit is already clear, so a frame accessed since
+ * the last sweep gets a second chance. A frame first accessed by a scan starts with a clear bit.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -32,21 +36,56 @@ class ClockReplacer : public Replacer {
    */
   explicit ClockReplacer(size_t num_pages);
 
+  DISALLOW_COPY_AND_MOVE(ClockReplacer);
+
   /**
    * Destroys the ClockReplacer.
    */
   ~ClockReplacer() override;
 
-  auto Victim(frame_id_t *frame_id) -> bool override;
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  auto Evict(frame_id_t frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown,
+                    page_id_t page_id = INVALID_PAGE_ID) override;
 
-  void Pin(frame_id_t frame_id) override;
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
-  void Unpin(frame_id_t frame_id) override;
+  void Remove(frame_id_t frame_id) override;
 
   auto Size() -> size_t override;
 
+  /** Add frames to the ring behind the existing ones. */
+  void SetNumFrames(size_t num_frames) override;
+
+  /** The frames with a clear reference bit in ring order from the hand, then the others in the same order. */
+  auto EvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> override;
+
+  auto GetStats() -> ReplacerStats override;
+
  private:
-  // TODO(student): implement me!
+  struct ClockFrame {
+    bool tracked_{false};
+    bool evictable_{false};
+    /** Set by accesses, cleared by the passing hand. */
+    bool referenced_{false};
+    /** True once the frame was accessed again after it started to be tracked, for the cold/hot statistics. */
+    bool reused_{false};
+  };
+
+  /** Throw if frame_id is out of the bound. Needs latch_. */
+  void CheckFrameId(frame_id_t frame_id, const char *caller) const;
+
+  /** Stop tracking an evictable frame. */
+  void Untrack(frame_id_t frame_id, bool evicted);
+
+  std::vector<ClockFrame> frames_;
+  /** Position of the clock hand, the frame looked at next. */
+  size_t hand_{0};
+  size_t curr_size_{0};
+  ReplacerStats stats_;
+  std::mutex latch_;
 };
 
 }  // namespace bustub
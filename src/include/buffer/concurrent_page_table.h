@@ -0,0 +1,150 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// concurrent_page_table.h
+//
+// Identification: src/include/buffer/concurrent_page_table.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ConcurrentPageTable maps the page ids resident in a buffer pool shard to their frames. It is an open addressing
+ * hash table with linear probing and a fixed capacity of at least twice the number of frames, so it never grows.
+ * Every slot is a single atomic word holding both the page id and the frame id.
+ *
+ * Insert() and Erase() must be serialized by the caller, e.g. by the shard latch. Lookup() may run concurrently with
+ * them without any latch. It returns a frame the page was mapped to at some point during the call, or misses an entry
+ * that Erase() is moving back in its probe sequence. Callers of Lookup() therefore have to validate the frame and
+ * fall back to a latched lookup on a miss. Find() is Lookup() for callers that hold the writer side.
+ */
+class ConcurrentPageTable {
+ public:
+  /** Frame id returned for page ids that are not in the table. */
+  static constexpr frame_id_t NOT_FOUND = -1;
+
+  explicit ConcurrentPageTable(size_t max_entries) {
+    while (capacity_ < 2 * max_entries) {
+      capacity_ *= 2;
+    }
+    slots_ = std::make_unique<std::atomic<uint64_t>[]>(capacity_);
+    for (size_t i = 0; i < capacity_; ++i) {
+      slots_[i].store(EMPTY, std::memory_order_relaxed);
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(ConcurrentPageTable);
+
+  /** @return the frame holding page_id, or NOT_FOUND. Lock-free, see the class comment for the caveats. */
+  auto Lookup(page_id_t page_id) const -> frame_id_t {
+    for (size_t i = Home(page_id), probes = 0; probes < capacity_; i = (i + 1) & (capacity_ - 1), ++probes) {
+      uint64_t slot = slots_[i].load(std::memory_order_acquire);
+      if (slot == EMPTY) {
+        return NOT_FOUND;
+      }
+      if (PageOf(slot) == page_id) {
+        return FrameOf(slot);
+      }
+    }
+    return NOT_FOUND;
+  }
+
+  /** @return the frame holding page_id, or NOT_FOUND. Exact as long as the caller serializes it with the writers. */
+  auto Find(page_id_t page_id) const -> frame_id_t { return Lookup(page_id); }
+
+  /** Map page_id, which must not be in the table yet, to frame_id. */
+  void Insert(page_id_t page_id, frame_id_t frame_id) {
+    BUSTUB_ASSERT(size_ < capacity_ / 2, "page table is full");
+    size_t i = Home(page_id);
+    while (slots_[i].load(std::memory_order_relaxed) != EMPTY) {
+      i = (i + 1) & (capacity_ - 1);
+    }
+    slots_[i].store(Pack(page_id, frame_id), std::memory_order_release);
+    size_++;
+  }
+
+  /** Remove page_id from the table if it is there. */
+  void Erase(page_id_t page_id) {
+    size_t hole = Home(page_id);
+    while (true) {
+      uint64_t slot = slots_[hole].load(std::memory_order_relaxed);
+      if (slot == EMPTY) {
+        return;
+      }
+      if (PageOf(slot) == page_id) {
+        break;
+      }
+      hole = (hole + 1) & (capacity_ - 1);
+    }
+
+    // shift back the entries behind the hole that would otherwise become unreachable, so no tombstones are needed
+    for (size_t i = (hole + 1) & (capacity_ - 1);; i = (i + 1) & (capacity_ - 1)) {
+      uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+      if (slot == EMPTY) {
+        break;
+      }
+      size_t home = Home(PageOf(slot));
+      // the entry may move to the hole if its home is not in the cyclic range (hole, i]
+      bool reachable = hole <= i ? (hole < home && home <= i) : (hole < home || home <= i);
+      if (!reachable) {
+        slots_[hole].store(slot, std::memory_order_release);
+        hole = i;
+      }
+    }
+    slots_[hole].store(EMPTY, std::memory_order_release);
+    size_--;
+  }
+
+  /** @return the number of entries the table was created for */
+  auto MaxEntries() const -> size_t { return capacity_ / 2; }
+
+  /** @return the number of entries. Only meaningful for callers serialized with the writers. */
+  auto Size() const -> size_t { return size_; }
+
+  /** Call f(page_id, frame_id) for every entry. Only meaningful for callers serialized with the writers. */
+  template <typename F>
+  void ForEach(F &&f) const {
+    for (size_t i = 0; i < capacity_; ++i) {
+      uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+      if (slot != EMPTY) {
+        f(PageOf(slot), FrameOf(slot));
+      }
+    }
+  }
+
+ private:
+  static constexpr uint64_t EMPTY = ~uint64_t{0};
+
+  static auto Pack(page_id_t page_id, frame_id_t frame_id) -> uint64_t {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static auto PageOf(uint64_t slot) -> page_id_t { return static_cast<page_id_t>(slot >> 32); }
+  static auto FrameOf(uint64_t slot) -> frame_id_t { return static_cast<frame_id_t>(slot & 0xffffffff); }
+
+  /** @return the first slot probed for page_id. Page ids are dense, so they are scattered by a Fibonacci hash. */
+  auto Home(page_id_t page_id) const -> size_t {
+    return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL) >>
+                               32) &
+           (capacity_ - 1);
+  }
+
+  size_t capacity_{2};
+  size_t size_{0};
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+};
+
+}  // namespace bustub
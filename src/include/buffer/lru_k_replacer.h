@@ -12,31 +12,43 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <limits>
-#include <list>
 #include <memory>
 #include <mutex>  // NOLINT
-#include <unordered_map>
+#include <set>
+#include <utility>
 #include <vector>
 
+#include "buffer/replacer.h"
 #include "common/config.h"
 #include "common/macros.h"
 
 namespace bustub {
 
-enum class AccessType { Unknown = 0, Get, Scan };
-
 class LRUKNode {
   friend class LRUKReplacer;
 
  public:
   LRUKNode() = default;
   explicit LRUKNode(frame_id_t fid) : fid_(fid) {}
-  /** History of last seen K timestamps of this page. Least recent timestamp stored in front. */
-  // Remove maybe_unused if you start using them. Feel free to change the member variables as you want.
+
  private:
-  std::list<size_t> history_;
+  /**
+   * @return the timestamp the frame is ordered by: the k-th most recent access once the frame has been seen k times,
+   * otherwise its first access
+   */
+  auto EvictionKey() const -> size_t { return access_cnt_ < history_.size() ? history_[0] : history_[Head()]; }
+
+  /** @return the slot of history_ that holds the oldest of the last k accesses and is overwritten next */
+  auto Head() const -> size_t { return access_cnt_ % history_.size(); }
+
+  /** Ring buffer of the last k access timestamps of this frame, preallocated to k entries. */
+  std::vector<size_t> history_;
+  /** Number of accesses recorded since the frame was added, 0 if the frame is not tracked. */
+  size_t access_cnt_{0};
   frame_id_t fid_;
   bool is_evictable_{false};
 };
@@ -52,7 +64,7 @@ class LRUKNode {
  * +inf as its backward k-distance. When multiple frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
  */
-class LRUKReplacer {
+class LRUKReplacer : public Replacer {
  public:
   /**
    *
@@ -70,7 +82,7 @@ class LRUKReplacer {
    *
    * @brief Destroys the LRUReplacer.
    */
-  ~LRUKReplacer() = default;
+  ~LRUKReplacer() override = default;
 
   /**
    * TODO(P1): Add implementation
@@ -88,7 +100,7 @@ class LRUKReplacer {
    * @param[out] frame_id id of frame that is evicted.
    * @return true if a frame is evicted successfully, false if no frames can be evicted.
    */
-  auto Evict(frame_id_t *frame_id) -> bool;
+  auto Evict(frame_id_t *frame_id) -> bool override;
 
   /**
    * TODO(P1): Add implementation
@@ -100,10 +112,21 @@ class LRUKReplacer {
    * also use BUSTUB_ASSERT to abort the process if frame id is invalid.
    *
    * @param frame_id id of frame that received a new access.
-   * @param access_type type of access that was received. This parameter is only needed for
-   * leaderboard tests.
+   * @param access_type type of access that was received. A scan access only starts the history of a frame
+   * that is not tracked yet, it does not make a tracked frame look hotter.
+   * @param page_id unused, LRU-K forgets evicted pages
+   */
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown,
+                    page_id_t page_id = INVALID_PAGE_ID) override;
+
+  /** @return the logical clock, bumped on every recorded access */
+  auto Now() const -> size_t override { return current_timestamp_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Record an access that happened at an earlier time of Now(). It goes into the history of the frame in time
+   * order, so it only counts among the last k accesses if it is more recent than the oldest of them.
    */
-  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown);
+  void RecordAccessAt(frame_id_t frame_id, size_t timestamp) override;
 
   /**
    * TODO(P1): Add implementation
@@ -122,7 +145,7 @@ class LRUKReplacer {
    * @param frame_id id of frame whose 'evictable' status will be modified
    * @param set_evictable whether the given frame is evictable or not
    */
-  void SetEvictable(frame_id_t frame_id, bool set_evictable);
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
   /**
    * TODO(P1): Add implementation
@@ -141,7 +164,7 @@ class LRUKReplacer {
    *
    * @param frame_id id of frame to be removed
    */
-  void Remove(frame_id_t frame_id);
+  void Remove(frame_id_t frame_id) override;
 
   /**
    * TODO(P1): Add implementation
@@ -150,16 +173,52 @@ class LRUKReplacer {
    *
    * @return size_t
    */
-  auto Size() -> size_t;
+  auto Size() -> size_t override;
+
+  /**
+   * Grow the node store to num_frames frames. LRU-K does not depend on the number of frames otherwise.
+   */
+  void SetNumFrames(size_t num_frames) override;
+
+  /**
+   * @brief Look ahead of eviction without evicting anything.
+   * @param max_frames maximum number of frames to return
+   * @return up to max_frames evictable frames, in the order Evict() would pick them
+   */
+  auto EvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> override;
+
+  /**
+   * @brief Evict a frame picked from EvictionCandidates() by the caller, e.g. because the ones ranked before it are
+   * still in use. Unlike Remove(), this counts as an eviction.
+   * @param frame_id id of frame to be evicted
+   * @return true if the frame was evictable and is evicted
+   */
+  auto Evict(frame_id_t frame_id) -> bool override;
+
+  /** @return a copy of the counters of this replacer */
+  auto GetStats() -> ReplacerStats override;
 
  private:
-  // TODO(student): implement me! You can replace these member variables as you like.
-  // Remove maybe_unused if you start using them.
-  std::unordered_map<frame_id_t, std::shared_ptr<LRUKNode>> node_store_;
-  size_t current_timestamp_{0};
+  using EvictionQueue = std::set<std::pair<size_t, frame_id_t>>;
+
+  /** @return the queue an evictable node belongs to */
+  auto QueueOf(const LRUKNode &node) -> EvictionQueue & {
+    return node.access_cnt_ < k_ ? less_than_k_ : k_accessed_;
+  }
+
+  /** One node per frame, allocated up front and reset when the frame is evicted or removed. */
+  std::vector<LRUKNode> node_store_;
+  /** Evictable frames with fewer than k accesses, ordered by their first access. */
+  EvictionQueue less_than_k_;
+  /** Evictable frames with at least k accesses, ordered by their k-th most recent access. */
+  EvictionQueue k_accessed_;
+  /** Logical clock, bumped on every recorded access. Read without the latch by Now(). */
+  std::atomic<size_t> current_timestamp_{0};
   size_t curr_size_{0};
+  /** Number of frames, grown by SetNumFrames(). Only read under latch_, the bound checks included. */
   size_t replacer_size_;
   size_t k_;
+  ReplacerStats stats_;
   std::mutex latch_;
 };
 
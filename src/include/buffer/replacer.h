@@ -12,12 +12,68 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+enum class AccessType { Unknown = 0, Get, Scan };
+
+/** Replacement policies a BufferPoolManager can be created with, see MakeReplacer(). */
+enum class ReplacerPolicy {
+  /** LRU-K, see LRUKReplacer. */
+  LRUK,
+  /** Plain LRU, i.e. LRU-K with k = 1, see LRUReplacer. */
+  LRU,
+  /** CLOCK (second chance), see ClockReplacer. */
+  Clock,
+  /** 2Q, see TwoQueueReplacer. */
+  TwoQueue,
+  /** Adaptive Replacement Cache, see ARCReplacer. */
+  ARC,
+};
+
+static constexpr ReplacerPolicy DEFAULT_REPLACER_POLICY = ReplacerPolicy::LRUK;
+
+/** @return the name of a policy as accepted by ParseReplacerPolicy() */
+auto ReplacerPolicyName(ReplacerPolicy policy) -> std::string;
+
+/**
+ * @param name one of lru-k, lru, clock, 2q or arc
+ * @param[out] policy the policy with that name
+ * @return false if name is not a policy
+ */
+auto ParseReplacerPolicy(const std::string &name, ReplacerPolicy *policy) -> bool;
+
 /**
- * Replacer is an abstract class that tracks page usage.
+ * Counters of a replacer, see Replacer::GetStats(). Every policy keeps pages seen once apart from pages that proved
+ * to be reused (LRU-K: fewer than k accesses, 2Q: A1in, ARC: T1, CLOCK: not referenced again), which tells cold
+ * from hot evictions.
+ */
+struct ReplacerStats {
+  /** Frames evicted before their page was accessed again. */
+  uint64_t cold_evictions_{0};
+  /** Frames evicted although their page had been reused. */
+  uint64_t hot_evictions_{0};
+  /** Scan accesses to tracked frames, which are not recorded. */
+  uint64_t ignored_scan_accesses_{0};
+};
+
+/**
+ * Replacer is an abstract class that tracks page usage and picks the frames to evict.
+ *
+ * A frame is tracked from its first recorded access until it is evicted or removed. Only tracked frames that are
+ * marked evictable are candidates for eviction. Implementations synchronize internally.
+ *
+ * The buffer pool does not keep the evictable flag in step with the pin count: pinning a resident page takes no latch,
+ * so a frame stays evictable while it is pinned until an eviction finds it pinned among the candidates and sets it
+ * non-evictable. Its last unpin makes it evictable again. Hits that pinned a page without the latch are recorded
+ * once the frame comes up for eviction, with RecordAccessAt() and the time they happened.
  */
 class Replacer {
  public:
@@ -25,26 +81,85 @@ class Replacer {
   virtual ~Replacer() = default;
 
   /**
-   * Remove the victim frame as defined by the replacement policy.
-   * @param[out] frame_id id of frame that was removed, nullptr if no victim was found
-   * @return true if a victim frame was found, false otherwise
+   * Evict the frame the policy ranks first among the evictable frames and stop tracking it.
+   * @param[out] frame_id id of the evicted frame
+   * @return true if a frame was evicted, false if no frame is evictable
    */
-  virtual auto Victim(frame_id_t *frame_id) -> bool = 0;
+  virtual auto Evict(frame_id_t *frame_id) -> bool = 0;
 
   /**
-   * Pins a frame, indicating that it should not be victimized until it is unpinned.
-   * @param frame_id the id of the frame to pin
+   * Evict a frame picked from EvictionCandidates() by the caller, e.g. because the ones ranked before it are still
+   * in use. Unlike Remove(), this counts as an eviction and lets policies remember the evicted page.
+   * @param frame_id id of frame to be evicted
+   * @return true if the frame was evictable and is evicted
    */
-  virtual void Pin(frame_id_t frame_id) = 0;
+  virtual auto Evict(frame_id_t frame_id) -> bool = 0;
 
   /**
-   * Unpins a frame, indicating that it can now be victimized.
-   * @param frame_id the id of the frame to unpin
+   * Record an access to a frame, starting to track it if it is not tracked yet. Throws if frame_id is out of range.
+   * @param frame_id id of frame that received a new access
+   * @param access_type type of access. A scan access only starts tracking a frame, it does not make a tracked frame
+   * look hotter.
+   * @param page_id page the frame holds, needed by policies that remember evicted pages when a frame starts to be
+   * tracked
    */
-  virtual void Unpin(frame_id_t frame_id) = 0;
+  virtual void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown,
+                            page_id_t page_id = INVALID_PAGE_ID) = 0;
 
-  /** @return the number of elements in the replacer that can be victimized */
+  /**
+   * @return the time of the logical clock accesses are ordered by, to pass to RecordAccessAt() later. Safe to call
+   * without synchronization. Policies that rank frames by the order of accesses only return 0.
+   */
+  virtual auto Now() const -> size_t { return 0; }
+
+  /**
+   * Record an access that happened at a time returned by Now(), e.g. a hit that is recorded after others that
+   * happened later. A time the clock has not reached counts as now. Policies that rank frames by the order of
+   * accesses only record it like RecordAccess().
+   * @param frame_id id of frame that received the access
+   * @param timestamp time of the access
+   */
+  virtual void RecordAccessAt(frame_id_t frame_id, [[maybe_unused]] size_t timestamp) { RecordAccess(frame_id); }
+
+  /**
+   * Toggle whether a tracked frame may be evicted. Size() counts the evictable frames. Untracked frames are ignored.
+   * Throws if frame_id is out of range.
+   */
+  virtual void SetEvictable(frame_id_t frame_id, bool set_evictable) = 0;
+
+  /**
+   * Stop tracking an evictable frame, e.g. because its page was deleted. Untracked frames are ignored, a tracked
+   * frame that is not evictable throws.
+   */
+  virtual void Remove(frame_id_t frame_id) = 0;
+
+  /** @return the number of evictable frames */
   virtual auto Size() -> size_t = 0;
+
+  /**
+   * Change the number of frames the policy is sized for, e.g. because the buffer pool was resized. Frame ids below
+   * num_frames may be recorded afterwards. Tracked frames at or above num_frames stay tracked until they are evicted
+   * or removed, so the range of valid frame ids never shrinks.
+   */
+  virtual void SetNumFrames(size_t num_frames) = 0;
+
+  /**
+   * Look ahead of eviction without evicting anything.
+   * @param max_frames maximum number of frames to return
+   * @return up to max_frames evictable frames, in the order Evict() would pick them
+   */
+  virtual auto EvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> = 0;
+
+  /** @return a copy of the counters of this replacer */
+  virtual auto GetStats() -> ReplacerStats = 0;
 };
 
+/**
+ * Create a replacer.
+ * @param policy the replacement policy
+ * @param num_frames the number of frames the replacer tracks
+ * @param k the k of LRU-K, ignored by the other policies
+ */
+auto MakeReplacer(ReplacerPolicy policy, size_t num_frames, size_t k) -> std::unique_ptr<Replacer>;
+
 }  // namespace bustub
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer.h
+//
+// Identification: src/include/buffer/two_queue_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * TwoQueueReplacer implements the full version of the 2Q replacement policy (Johnson and Shasha, VLDB '94).
+ *
+ * A page that is not remembered starts in A1in, a FIFO queue of pages seen once; accesses while it is there are
+ * treated as correlated and ignored. Pages evicted from A1in are remembered by their page id in the ghost queue A1out.
+ * A page that comes back while remembered in A1out goes to Am, an LRU list of pages with proven reuse. A1in is
+ * evicted from while it holds more than a quarter of the frames, Am otherwise. Scans never promote pages to Am.
+ */
+class TwoQueueReplacer : public Replacer {
+ public:
+  /**
+   * @param num_frames the maximum number of frames the replacer will be required to store. A1in is kept at about a
+   * quarter of them, A1out remembers half as many pages as there are frames.
+   */
+  explicit TwoQueueReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(TwoQueueReplacer);
+
+  ~TwoQueueReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  auto Evict(frame_id_t frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown,
+                    page_id_t page_id = INVALID_PAGE_ID) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  /** Grow the node store if needed and size A1in and A1out for num_frames frames. */
+  void SetNumFrames(size_t num_frames) override;
+
+  auto EvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> override;
+
+  auto GetStats() -> ReplacerStats override;
+
+ private:
+  struct Node {
+    bool tracked_{false};
+    bool evictable_{false};
+    /** True if the frame is in am_, otherwise in a1in_. */
+    bool in_am_{false};
+    page_id_t page_id_{INVALID_PAGE_ID};
+    /** Position of the frame in a1in_ or am_. */
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  /** Throw if frame_id is out of the bound. Needs latch_. */
+  void CheckFrameId(frame_id_t frame_id, const char *caller) const;
+
+  /** @return the resident queues in the order victims are taken from them */
+  auto EvictionOrder() -> std::vector<std::list<frame_id_t> *>;
+
+  /** Stop tracking an evictable frame. An evicted frame of A1in is remembered in A1out. */
+  void Untrack(frame_id_t frame_id, bool evicted);
+
+  std::vector<Node> node_store_;
+  /** Frames seen once, oldest first. */
+  std::list<frame_id_t> a1in_;
+  /** Frames with proven reuse, least recently used first. */
+  std::list<frame_id_t> am_;
+  /** Page ids recently evicted from A1in, oldest first. */
+  std::list<page_id_t> a1out_;
+  std::unordered_map<page_id_t, std::list<page_id_t>::iterator> a1out_index_;
+  /** Size A1in is kept at, about a quarter of the frames. */
+  size_t kin_;
+  /** Number of page ids A1out remembers, half the number of frames. */
+  size_t kout_;
+  size_t curr_size_{0};
+  ReplacerStats stats_;
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -135,7 +135,7 @@ class Catalog {
     // When create_table_heap == false, it means that we're running binder tests (where no txn will be provided) or
     // we are running shell without buffer pool. We don't need to create TableHeap in this case.
     if (create_table_heap) {
-      table = std::make_unique<TableHeap>(bpm_);
+      table = std::make_unique<TableHeap>(bpm_, log_manager_);
     } else {
       // Otherwise, create an empty heap only for binder tests
       table = TableHeap::CreateEmptyHeap(create_table_heap);
@@ -346,7 +346,7 @@ class Catalog {
  private:
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] LockManager *lock_manager_;
-  [[maybe_unused]] LogManager *log_manager_;
+  LogManager *log_manager_;
 
   /**
    * Map table identifier -> table metadata.
@@ -34,6 +34,7 @@ namespace bustub {
 class Transaction;
 class ExecutorContext;
 class DiskManager;
+enum class DiskIOMode;
 class BufferPoolManager;
 class LockManager;
 class TransactionManager;
@@ -220,6 +221,9 @@ class BustubInstance {
  public:
   explicit BustubInstance(const std::string &db_file_name);
 
+  /** Create an instance whose database file is accessed with io_mode, e.g. DiskIOMode::Direct to bypass the OS cache. */
+  BustubInstance(const std::string &db_file_name, DiskIOMode io_mode);
+
   BustubInstance();
 
   ~BustubInstance();
@@ -280,6 +284,8 @@ class BustubInstance {
   void CmdDisplayTables(ResultWriter &writer);
   void CmdDisplayIndices(ResultWriter &writer);
   void CmdDisplayHelp(ResultWriter &writer);
+  void CmdDisplayBufferPoolStats(ResultWriter &writer);
+  void CmdReplacerPolicy(const std::string &policy_name, ResultWriter &writer);
   void WriteOneCell(const std::string &cell, ResultWriter &writer);
 
   void HandleCreateStatement(Transaction *txn, const CreateStatement &stmt, ResultWriter &writer);
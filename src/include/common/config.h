@@ -14,6 +14,7 @@
 
 #include <atomic>
 #include <chrono>  // NOLINT
+#include <cstddef>
 #include <cstdint>
 
 namespace bustub {
@@ -27,15 +28,44 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** The background writer of the buffer pool cleans pages ahead of eviction every BG_WRITER_INTERVAL milliseconds. */
+extern std::chrono::milliseconds bg_writer_interval;
+
+/** The background writer saves the warm-up list of the buffer pool every WARMUP_DUMP_INTERVAL milliseconds. */
+extern std::chrono::milliseconds warmup_dump_interval;
+
+/** The checkpoint manager takes a fuzzy checkpoint every CHECKPOINT_INTERVAL milliseconds once it runs its thread. */
+extern std::chrono::milliseconds checkpoint_interval;
+
+/** Number of upcoming pages table and index scans keep in flight ahead of the current one, 0 disables read-ahead. */
+extern size_t scan_prefetch_window;
+
 static constexpr int INVALID_PAGE_ID = -1;                                           // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                             // the header page id
 static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int HUGE_PAGE_SIZE = 2 * 1024 * 1024;                               // size of a transparent huge page
+static constexpr int DIRECT_IO_ALIGNMENT = 4096;                                     // alignment O_DIRECT buffers need
 static constexpr int BUFFER_POOL_SIZE = 10;                                          // size of buffer pool
+static constexpr int MAX_BUFFER_POOL_SIZE = 1 << 24;                                 // most frames of a buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
-static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int LRUK_REPLACER_K = 10;         // lookback window for lru-k replacer
+static constexpr int SCAN_RING_SIZE = 16;          // max number of frames a buffer pool shard lends to sequential scans
+static constexpr int BG_WRITER_CLEAN_FRAMES = 16;  // frames per buffer pool shard the background writer keeps clean
+static constexpr int BG_WRITER_BATCH_SIZE = 16;    // max pages the background writer writes per shard and round
+static constexpr int PREFETCH_WORKERS = 4;         // number of threads reading prefetched pages into the buffer pool
+static constexpr int DISK_SCHEDULER_WORKERS = 4;   // number of threads carrying out the page transfers of a buffer pool
+static constexpr int DISK_SCHEDULER_BATCH = 64;    // max adjacent page requests the disk scheduler transfers at once
+static constexpr int PAGE_EXTENT_SIZE = 64;        // contiguous page ids a table heap or index reserves at once
+static constexpr int OPTIMISTIC_READ_RETRIES = 8;  // optimistic index descents tried before latching all the way down
+static constexpr int TUPLE_BATCH_SIZE = 64;        // tuples index scans and inserts pass to the table heap at once
+static constexpr int FLUSH_BATCH_SIZE = 256;       // max pages FlushAllPages keeps in flight between two disk writes
+static constexpr int RECOVERY_REDO_THREADS = 4;    // number of threads redoing the log, each owns a share of the pages
+static constexpr int REDO_READ_SIZE = 1 << 20;     // bytes of the log recovery reads at once while redoing
+static constexpr int LOG_SEGMENT_SIZE = 16 << 20;  // bytes of a log segment file, allocated in full when it is created
+static constexpr int LOG_SEGMENT_SPARES = 4;       // log segments a checkpoint keeps for reuse instead of removing them
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -16,6 +16,7 @@
 #include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
@@ -47,14 +48,18 @@ class TransactionManager {
       txn = new Transaction(next_txn_id_++, isolation_level);
     }
 
+    // a checkpoint sees the transaction either active or beginning after its BEGIN_CHECKPOINT record
+    std::unique_lock<std::shared_mutex> l(txn_map_mutex_);
+    // without a record, the transaction is rolled back by reading the log from the start
+    size_t first_offset = 0;
     if (enable_logging) {
       LogRecord record = LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::BEGIN);
-      lsn_t lsn = log_manager_->AppendLogRecord(&record);
+      lsn_t lsn = log_manager_->AppendLogRecord(&record, &first_offset);
       txn->SetPrevLSN(lsn);
     }
 
-    std::unique_lock<std::shared_mutex> l(txn_map_mutex_);
     txn_map_[txn->GetTransactionId()] = txn;
+    active_txns_[txn->GetTransactionId()] = {txn, first_offset};
     return txn;
   }
 
@@ -90,12 +95,21 @@ class TransactionManager {
     return res;
   }
 
-  /** Prevents all transactions from performing operations, used for checkpointing. */
+  /**
+   * Prevents transactions from beginning, committing and aborting, used for checkpointing. The operations of running
+   * transactions go on.
+   */
   void BlockAllTransactions();
 
   /** Resumes all transactions, used for checkpointing. */
   void ResumeTransactions();
 
+  /**
+   * The active transaction table for a checkpoint. The caller blocks all transactions, so that every transaction is
+   * either in the table or has its BEGIN, COMMIT or ABORT record after the ones appended meanwhile.
+   */
+  auto GetActiveTransactionTable() -> std::vector<CheckpointTxn>;
+
  private:
   /**
    * Releases all the locks held by the given transaction.
@@ -147,9 +161,19 @@ class TransactionManager {
     }
   }
 
+  /** A transaction that neither committed nor aborted yet. */
+  struct ActiveTxn {
+    Transaction *txn_;
+    /** Log file offset of the BEGIN record of the transaction. */
+    size_t first_offset_;
+  };
+
+  /** The transactions that neither committed nor aborted yet, protected by txn_map_mutex_. */
+  std::unordered_map<txn_id_t, ActiveTxn> active_txns_;
+
   std::atomic<txn_id_t> next_txn_id_{0};
   LockManager *lock_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
+  LogManager *log_manager_;
 };
 
 }  // namespace bustub
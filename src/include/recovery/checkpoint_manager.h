@@ -12,6 +12,11 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction_manager.h"
 #include "recovery/log_manager.h"
@@ -19,7 +24,18 @@
 namespace bustub {
 
 /**
- * CheckpointManager creates consistent checkpoints by blocking all other transactions temporarily.
+ * CheckpointManager takes fuzzy checkpoints, which bound the part of the log recovery reads, without stopping the
+ * transactions:
+ *  - BeginCheckpoint() logs a BEGIN_CHECKPOINT record and takes the active transaction table. Transactions are only
+ *    kept from beginning and ending meanwhile, so every one is either in the table or logs its BEGIN, COMMIT or ABORT
+ *    record after BEGIN_CHECKPOINT.
+ *  - EndCheckpoint() writes back the pages that were dirty at BEGIN_CHECKPOINT, one at a time while the transactions
+ *    go on, so that every change logged before BEGIN_CHECKPOINT is on disk. It then logs the tables in END_CHECKPOINT
+ *    records: the active transactions and the pages that are dirty now, with their recovery lsn. Once those are on
+ *    disk, the master record points recovery to the checkpoint.
+ *
+ * Recovery starts reading the log at the BEGIN_CHECKPOINT record of the last complete checkpoint, and only goes
+ * further back to roll back the transactions of the active transaction table.
  */
 class CheckpointManager {
  public:
@@ -29,15 +45,44 @@ class CheckpointManager {
         log_manager_(log_manager),
         buffer_pool_manager_(buffer_pool_manager) {}
 
-  ~CheckpointManager() = default;
+  ~CheckpointManager() { StopCheckpointThread(); }
+
+  /** Start taking a checkpoint every checkpoint_interval in the background. Checkpoints need logging enabled. */
+  void RunCheckpointThread();
+
+  /** Stop the checkpoint thread and wait for it to exit, after the checkpoint it may be taking. */
+  void StopCheckpointThread();
+
+  /** Take a checkpoint, does nothing while logging is disabled. Only one checkpoint may be taken at a time. */
+  void Checkpoint();
 
+  /** Log BEGIN_CHECKPOINT and take the active transaction table and the pages to write back. */
   void BeginCheckpoint();
+
+  /** Write back the pages, log the tables and make the checkpoint the one recovery starts from. */
   void EndCheckpoint();
 
  private:
-  TransactionManager *transaction_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** Body of the checkpoint thread. */
+  void CheckpointLoop();
+
+  TransactionManager *transaction_manager_;
+  LogManager *log_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+
+  /** Log file offset of the BEGIN_CHECKPOINT record of the checkpoint being taken. */
+  size_t begin_offset_{0};
+  /** The active transaction table as of BEGIN_CHECKPOINT. */
+  std::vector<CheckpointTxn> active_txns_;
+  /** The pages that may have held changes not on disk at BEGIN_CHECKPOINT. */
+  std::vector<page_id_t> flush_page_ids_;
+
+  std::thread *checkpoint_thread_{nullptr};
+  /** True while the checkpoint thread should keep running. */
+  bool enable_checkpoint_thread_{false};
+  /** Protects enable_checkpoint_thread_, signaled to stop the checkpoint thread. */
+  std::mutex checkpoint_latch_;
+  std::condition_variable checkpoint_cv_;
 };
 
 }  // namespace bustub
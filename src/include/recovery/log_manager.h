@@ -13,9 +13,12 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>  // NOLINT
+#include <cstdint>
 #include <future>              // NOLINT
 #include <mutex>               // NOLINT
+#include <thread>              // NOLINT
 
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
@@ -25,16 +28,27 @@ namespace bustub {
 /**
  * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
  * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ *
+ * Appenders serialize their records into log_buffer_ while the flush thread writes the previous batch from
+ * flush_buffer_, and the two buffers are swapped between batches. A committing transaction asks for a flush and waits
+ * until persistent_lsn_ covers its commit record, so all commits that arrive during one write share the next one
+ * (group commit).
+ *
+ * Appending takes no latch: an appender reserves its bytes and its lsn with one atomic operation on reservation_ and
+ * copies its record in parallel with the others. To swap the buffers, the flusher closes reservation_, waits until
+ * the reserved bytes are filled, and opens it again on the other buffer.
  */
 class LogManager {
  public:
   explicit LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
+      : persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
+    buffer_offset_ = disk_manager_ == nullptr ? 0 : disk_manager_->GetLogFileSize();
     log_buffer_ = new char[LOG_BUFFER_SIZE];
     flush_buffer_ = new char[LOG_BUFFER_SIZE];
   }
 
   ~LogManager() {
+    StopFlushThread();
     delete[] log_buffer_;
     delete[] flush_buffer_;
     log_buffer_ = nullptr;
@@ -44,31 +58,92 @@ class LogManager {
   void RunFlushThread();
   void StopFlushThread();
 
-  auto AppendLogRecord(LogRecord *log_record) -> lsn_t;
+  /**
+   * Append a record to the log buffer and number it.
+   * @param[out] offset if not null, the offset of the record in the log file
+   * @return the lsn of the record
+   */
+  auto AppendLogRecord(LogRecord *log_record, size_t *offset = nullptr) -> lsn_t;
 
-  inline auto GetNextLSN() -> lsn_t { return next_lsn_; }
+  /**
+   * Block until the log records up to and including lsn are on disk, asking the flush thread to write them right
+   * away. Without a flush thread, the caller writes them itself.
+   */
+  void WaitUntilPersistent(lsn_t lsn);
+
+  inline auto GetNextLSN() -> lsn_t { return LsnOf(reservation_.load()); }
   inline auto GetPersistentLSN() -> lsn_t { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
+
+  /**
+   * Number the next record lsn and treat all before it as persistent, e.g. to continue the log after recovery. Only
+   * allowed while the buffer is empty and nothing is appended.
+   */
+  inline void SetNextLSN(lsn_t lsn) {
+    reservation_.store(Pack(0, lsn));
+    persistent_lsn_ = lsn - 1;
+    buffer_offset_ = disk_manager_->GetLogFileSize();
+  }
   inline auto GetLogBuffer() -> char * { return log_buffer_; }
+  inline auto GetDiskManager() -> DiskManager * { return disk_manager_; }
 
  private:
-  // TODO(students): you may add your own member variables
-
-  /** The atomic counter which records the next log sequence number. */
-  std::atomic<lsn_t> next_lsn_;
+  /** Serialize log_record into buf, which must have room for log_record->GetSize() bytes. */
+  static void SerializeLogRecord(LogRecord *log_record, char *buf);
+
+  /** Body of the flush thread. */
+  void FlushLoop();
+
+  /** Block until log_buffer_ has room for size more bytes, flushing it if there is no flush thread. */
+  void WaitForRoom(int32_t size);
+
+  /**
+   * Swap the buffers and write the records appended so far, with latch_ released during the write. Waits for a write
+   * that is in progress first, so the buffer being written is never swapped back in. Appenders are only shut out
+   * while the records reserved before the swap are copied. Then the segment the next write may need is created, see
+   * DiskManager::PrepareLogSegments().
+   * @param lock holds latch_
+   */
+  void FlushBuffer(std::unique_lock<std::mutex> *lock);
+
+  /** Offset in log_buffer_ at which reservations fail until the flusher has swapped the buffers. */
+  static constexpr uint64_t CLOSED = 0xffffffff;
+
+  static auto Pack(uint64_t offset, lsn_t lsn) -> uint64_t { return (offset << 32) | static_cast<uint32_t>(lsn); }
+  static auto OffsetOf(uint64_t reservation) -> uint64_t { return reservation >> 32; }
+  static auto LsnOf(uint64_t reservation) -> lsn_t { return static_cast<lsn_t>(reservation & 0xffffffff); }
+
+  /** The end of the reserved part of log_buffer_ and the next log sequence number, see Pack(). */
+  std::atomic<uint64_t> reservation_{0};
+  /** Number of reserved bytes of log_buffer_ whose records are copied in. */
+  std::atomic<uint64_t> filled_{0};
+  /** Offset in the log file at which log_buffer_ is written. Only changed while reservation_ is closed. */
+  std::atomic<size_t> buffer_offset_{0};
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
+  /** Records appended since the last swap. Only swapped while reservation_ is closed. */
   char *log_buffer_;
+  /** Records being written by the flush thread. */
   char *flush_buffer_;
 
+  /** Serializes flushes and protects the flags below. Appenders only take it to wait for room. */
   std::mutex latch_;
 
-  std::thread *flush_thread_ __attribute__((__unused__));
+  std::thread *flush_thread_{nullptr};
+  /** Set while flush_buffer_ is being written. */
+  bool flushing_{false};
+  /** Set to make the flush thread write the buffered records without waiting for the timeout. */
+  bool flush_requested_{false};
+  /** Set to make the flush thread write what is left and exit. */
+  bool stop_flush_thread_{false};
 
+  /** Wakes up the flush thread. */
   std::condition_variable cv_;
+  /** Wakes up appenders waiting for room in log_buffer_ and transactions waiting for persistent_lsn_. */
+  std::condition_variable flushed_cv_;
 
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
 };
 
 }  // namespace bustub
@@ -14,6 +14,8 @@
 
 #include <cassert>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "storage/table/tuple.h"
@@ -32,6 +34,26 @@ enum class LogRecordType {
   ABORT,
   /** Creating a new page in the table heap. */
   NEWPAGE,
+  /** Start of a fuzzy checkpoint, see CheckpointManager. */
+  BEGIN_CHECKPOINT,
+  /** Tables of a fuzzy checkpoint, which is complete once its last END_CHECKPOINT record is on disk. */
+  END_CHECKPOINT,
+};
+
+/** A transaction that was active at a checkpoint. */
+struct CheckpointTxn {
+  txn_id_t txn_id_;
+  /** The lsn of the last record of the transaction. */
+  lsn_t last_lsn_;
+  /** Log file offset of the first record of the transaction, recovery reads back to it to roll the transaction back. */
+  size_t first_offset_;
+};
+
+/** A page that may have held changes not on disk at a checkpoint. */
+struct CheckpointPage {
+  page_id_t page_id_;
+  /** The recovery lsn: the changes of the page logged before it are on disk. */
+  lsn_t rec_lsn_;
 };
 
 /**
@@ -54,9 +76,15 @@ enum class LogRecordType {
  * | HEADER | tuple_rid | tuple_size | old_tuple_data | tuple_size | new_tuple_data |
  *-----------------------------------------------------------------------------------
  * For new page type log record
- *--------------------------
- * | HEADER | prev_page_id |
- *--------------------------
+ *-------------------------------------
+ * | HEADER | prev_page_id | page_id |
+ *-------------------------------------
+ * For end checkpoint type log record, the tables of a checkpoint are split into several records if they do not fit into
+ * one. prev_offset is the log file offset of the previous END_CHECKPOINT record of the checkpoint, or of its
+ * BEGIN_CHECKPOINT record for the first one. The entries are CheckpointTxn and CheckpointPage structs.
+ *-------------------------------------------------------------------------------------
+ * | HEADER | prev_offset | dirty_page_lsn | txn_count | txns[] | page_count | pages[] |
+ *-------------------------------------------------------------------------------------
  */
 class LogRecord {
   friend class LogManager;
@@ -110,8 +138,25 @@ class LogRecord {
     size_ = HEADER_SIZE + sizeof(page_id_t) * 2;
   }
 
+  // constructor for END_CHECKPOINT type
+  LogRecord(size_t prev_offset, lsn_t dirty_page_lsn, std::vector<CheckpointTxn> active_txns,
+            std::vector<CheckpointPage> dirty_pages)
+      : log_record_type_(LogRecordType::END_CHECKPOINT),
+        prev_offset_(prev_offset),
+        dirty_page_lsn_(dirty_page_lsn),
+        active_txns_(std::move(active_txns)),
+        dirty_pages_(std::move(dirty_pages)) {
+    size_ = EndCheckpointSize(active_txns_.size(), dirty_pages_.size());
+  }
+
   ~LogRecord() = default;
 
+  /** @return the size of an END_CHECKPOINT record with num_txns active transactions and num_pages dirty pages */
+  static auto EndCheckpointSize(size_t num_txns, size_t num_pages) -> int32_t {
+    return static_cast<int32_t>(HEADER_SIZE + END_CHECKPOINT_FIXED_SIZE + num_txns * sizeof(CheckpointTxn) +
+                                num_pages * sizeof(CheckpointPage));
+  }
+
   inline auto GetDeleteTuple() -> Tuple & { return delete_tuple_; }
 
   inline auto GetDeleteRID() -> RID & { return delete_rid_; }
@@ -128,6 +173,14 @@ class LogRecord {
 
   inline auto GetNewPageRecord() -> page_id_t { return prev_page_id_; }
 
+  inline auto GetCheckpointPrevOffset() -> size_t { return prev_offset_; }
+
+  inline auto GetDirtyPageLSN() -> lsn_t { return dirty_page_lsn_; }
+
+  inline auto GetActiveTxns() -> std::vector<CheckpointTxn> & { return active_txns_; }
+
+  inline auto GetDirtyPages() -> std::vector<CheckpointPage> & { return dirty_pages_; }
+
   inline auto GetSize() -> int32_t { return size_; }
 
   inline auto GetLSN() -> lsn_t { return lsn_; }
@@ -176,7 +229,17 @@ class LogRecord {
   // case4: for new page operation
   page_id_t prev_page_id_{INVALID_PAGE_ID};
   page_id_t page_id_{INVALID_PAGE_ID};
+
+  // case5: for end checkpoint operation
+  size_t prev_offset_{0};
+  // the records from this lsn on are redone whatever dirty_pages_ says
+  lsn_t dirty_page_lsn_{INVALID_LSN};
+  std::vector<CheckpointTxn> active_txns_;
+  std::vector<CheckpointPage> dirty_pages_;
+
   static const int HEADER_SIZE = 20;
+  // prev_offset, dirty_page_lsn, txn_count and page_count
+  static const int END_CHECKPOINT_FIXED_SIZE = sizeof(size_t) + sizeof(lsn_t) + 2 * sizeof(int32_t);
 };  // namespace bustub
 
 }  // namespace bustub
@@ -13,22 +13,53 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
+#include "recovery/log_manager.h"
 #include "recovery/log_record.h"
+#include "storage/page/table_page.h"
 
 namespace bustub {
 
 /**
  * Read log file from disk, redo and undo.
+ *
+ * Recovery follows ARIES and runs before the system accepts transactions, with logging disabled:
+ *  - Analysis finds the end of the log and the transactions that neither committed nor aborted, the losers.
+ *  - Redo repeats history: a page change is applied again unless the lsn of the page shows it is already there.
+ *  - Undo rolls back the changes of the losers and logs an ABORT record for each of them.
+ *
+ * Redo is parallel. A change only touches its own page, so the reading thread dispatches every record to the worker
+ * owning its page (page_id % number of workers), and each worker applies the changes to its pages in log order
+ * without coordinating with the others. Analysis is done in the same scan of the log.
+ *
+ * With a checkpoint, see CheckpointManager, the scan starts at its BEGIN_CHECKPOINT record, with the active transaction
+ * table of the checkpoint. Its dirty page table spares fetching pages whose changes are known to be on disk, and the
+ * log before the checkpoint is only read again for the records of losers that were active at it.
  */
 class LogRecovery {
  public:
-  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
-      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0) {
+  /**
+   * @param disk_manager the disk manager whose log is recovered
+   * @param buffer_pool_manager the buffer pool the pages are recovered in
+   * @param log_manager the log manager that continues the log afterwards, it must not have appended anything yet
+   * @param redo_threads number of threads that redo the log
+   */
+  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, LogManager *log_manager,
+              size_t redo_threads = RECOVERY_REDO_THREADS)
+      : disk_manager_(disk_manager),
+        buffer_pool_manager_(buffer_pool_manager),
+        log_manager_(log_manager),
+        redo_threads_(std::max<size_t>(redo_threads, 1)) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
   }
 
@@ -37,20 +68,111 @@ class LogRecovery {
     log_buffer_ = nullptr;
   }
 
+  /**
+   * Analysis and redo. Afterwards the log manager continues after the last record, and a record torn by the crash
+   * is cut off the log.
+   */
   void Redo();
+
+  /** Roll back the losers found by Redo(), flush the pool and log their abort. */
   void Undo();
+
+  /**
+   * Deserialize the record at data, see the layout in log_record.h.
+   * @return false if data does not hold a record
+   */
   auto DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool;
 
+  /** @return the log file offset at which Redo() started reading, that of the last checkpoint if there is one */
+  auto GetRedoStart() const -> size_t { return redo_start_; }
+  /** @return the number of bytes of valid records in the log */
+  auto GetLogSize() const -> size_t { return log_end_; }
+  /** @return the number of records Redo() read */
+  auto GetNumRecords() const -> size_t { return num_records_; }
+  /** @return the number of changes Redo() applied because their page did not have them */
+  auto GetNumRedone() const -> size_t { return num_redone_; }
+  /** @return the number of changes Undo() rolled back */
+  auto GetNumUndone() const -> size_t { return num_undone_; }
+  /** @return the number of losers Redo() found that Undo() has not rolled back yet */
+  auto GetNumLosers() const -> size_t { return active_txn_.size(); }
+
  private:
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** Records of one chunk of the log for one redo worker. */
+  struct RedoBatch {
+    std::shared_ptr<const std::vector<char>> chunk_;
+    /** Offsets of the records in chunk_, in log order. */
+    std::vector<size_t> offsets_;
+  };
+
+  /** Batches waiting for one redo worker. Bounded, so a slow worker holds up reading instead of filling memory. */
+  struct RedoQueue {
+    std::mutex latch_;
+    std::condition_variable cv_;
+    std::deque<RedoBatch> batches_;
+    bool closed_{false};
+  };
+
+  /** Batches a redo queue holds before the reading thread waits. */
+  static constexpr size_t REDO_QUEUE_DEPTH = 4;
+
+  /** @return the redo worker owning page_id */
+  auto OwnerOf(page_id_t page_id) const -> size_t { return static_cast<uint32_t>(page_id) % redo_threads_; }
+
+  /** Read the record at offset of the log file, @return false if there is none */
+  auto ReadLogRecord(size_t offset, LogRecord *log_record) -> bool;
+
+  /** Load the tables of the checkpoint the master record points to, if there is one. */
+  void ReadCheckpoint();
+
+  /** @return false if the dirty page table of the checkpoint shows the change at lsn to page_id is on disk */
+  auto NeedsRedo(page_id_t page_id, lsn_t lsn) const -> bool;
+
+  /** Find the records of the losers that were active at the checkpoint in the log before it. */
+  void CollectUndoOffsets();
+
+  /** Body of redo worker worker. */
+  void RedoLoop(size_t worker);
+
+  /** Apply the part of log_record that changes the pages of worker, if the pages do not have it yet. */
+  void RedoRecord(LogRecord *log_record, size_t worker);
+
+  /**
+   * Apply a change to a page unless its lsn shows the page already has it, and stamp the page with lsn. A page that
+   * is not a table page has no lsn and gets every change.
+   */
+  template <typename F>
+  void RedoOnPage(page_id_t page_id, lsn_t lsn, F &&apply);
+
+  /** Roll back the change of log_record. */
+  void UndoRecord(LogRecord *log_record);
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  LogManager *log_manager_;
+  size_t redo_threads_;
 
   /** Maintain active transactions and its corresponding latest lsn. */
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
-  /** Mapping the log sequence number to log file offset for undos. */
-  std::unordered_map<lsn_t, int> lsn_mapping_;
+  /** Log file offsets of the records of the active transactions that undo rolls back, in log order. */
+  std::unordered_map<txn_id_t, std::vector<size_t>> undo_offsets_;
+  /** Log file offsets of the first records of the active transactions that the checkpoint listed. */
+  std::unordered_map<txn_id_t, size_t> first_offsets_;
+  /** The dirty page table of the checkpoint, page id to recovery lsn. */
+  std::unordered_map<page_id_t, lsn_t> dirty_pages_;
+  /** The records from this lsn on are redone whatever dirty_pages_ says, all of them without a checkpoint. */
+  lsn_t dirty_page_lsn_{INVALID_LSN};
+  /** Log file offset of the BEGIN_CHECKPOINT record of the checkpoint, 0 without one. */
+  size_t redo_start_{0};
+  /** The largest lsn in the log. */
+  lsn_t max_lsn_{INVALID_LSN};
+
+  std::vector<RedoQueue> redo_queues_;
+  std::atomic<size_t> num_redone_{0};
+  size_t num_records_{0};
+  size_t num_undone_{0};
 
-  int offset_ __attribute__((__unused__));  // NOLINT
+  /** Offset after the last valid record of the log. */
+  size_t log_end_{0};
   char *log_buffer_;
 };
 
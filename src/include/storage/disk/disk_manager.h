@@ -13,44 +13,83 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <future>  // NOLINT
+#include <map>
 #include <mutex>   // NOLINT
 #include <string>
+#include <vector>
 
 #include "common/config.h"
 
 namespace bustub {
 
+/** How DiskManager accesses the database file. */
+enum class DiskIOMode {
+  /** Through the page cache of the operating system. */
+  Buffered,
+  /**
+   * With O_DIRECT, so pages are only cached by the buffer pool. Transfers need page buffers aligned to
+   * DIRECT_IO_ALIGNMENT, as the frames of an arena are. Other buffers are copied through an aligned one.
+   */
+  Direct,
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with positional I/O on the file descriptor of the database file, without a latch, so
+ * transfers of different pages proceed in parallel. Page writes reach the operating system right away but are only
+ * durable after SyncPages().
+ *
+ * The log is addressed by a logical offset that only grows. It is stored in segment files of LOG_SEGMENT_SIZE bytes,
+ * segment i holding the offsets [i * LOG_SEGMENT_SIZE, (i + 1) * LOG_SEGMENT_SIZE) in the file "<db>.log.<i>".
+ * Segments are allocated in full when they are created, ahead of the log writes that go to them (see
+ * PrepareLogSegments()), so log writes neither create nor grow files. The segments a checkpoint no longer needs are
+ * renamed to come after the current one instead of being removed.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param io_mode how the database file is accessed. Direct falls back to Buffered if the file system does not
+   * support O_DIRECT.
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, DiskIOMode io_mode = DiskIOMode::Buffered);
 
   /** FOR TEST / LEADERBOARD ONLY, used by DiskManagerMemory */
   DiskManager() = default;
 
-  virtual ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
-   * Shut down the disk manager and close all the file resources.
+   * Shut down the disk manager, sync the database file and close all the file resources.
    */
   void ShutDown();
 
   /**
-   * Write a page to the database file.
+   * Write a page to the database file. Call SyncPages() once the write has to be durable.
    * @param page_id id of the page
    * @param page_data raw page data
    */
   virtual void WritePage(page_id_t page_id, const char *page_data);
 
+  /**
+   * Write pages with consecutive ids to the database file, with as few system calls as possible. Call SyncPages()
+   * once the writes have to be durable.
+   * @param first_page_id id of the first page
+   * @param pages_data raw data of the pages first_page_id, first_page_id + 1, ...
+   */
+  virtual void WritePages(page_id_t first_page_id, const std::vector<const char *> &pages_data);
+
+  /**
+   * Make all page writes made so far durable.
+   */
+  virtual void SyncPages();
+
   /**
    * Read a page from the database file.
    * @param page_id id of the page
@@ -58,6 +97,57 @@ class DiskManager {
    */
   virtual void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Read pages with consecutive ids from the database file, with as few system calls as possible. Pages past the end
+   * of the file read as zeros.
+   * @param first_page_id id of the first page
+   * @param[out] pages_data output buffers of the pages first_page_id, first_page_id + 1, ...
+   */
+  virtual void ReadPages(page_id_t first_page_id, const std::vector<char *> &pages_data);
+
+  /**
+   * Write a page of the page allocation map. The map records which page ids are in use and is kept in its own file,
+   * next to the database file, so it does not take page ids away from the data pages.
+   * @param map_page_idx position of the page in the allocation map
+   * @param page_data raw page data
+   */
+  virtual void WriteAllocationMapPage(size_t map_page_idx, const char *page_data);
+
+  /**
+   * Read a page of the page allocation map.
+   * @param map_page_idx position of the page in the allocation map
+   * @param[out] page_data output buffer
+   * @return false if the allocation map has no page at map_page_idx
+   */
+  virtual auto ReadAllocationMapPage(size_t map_page_idx, char *page_data) -> bool;
+
+  /**
+   * Replace the warm-up list, the pages a restarted buffer pool should load first. It is kept in its own small file
+   * next to the database file, which is replaced as a whole so that a crash never leaves half a list behind.
+   * @param page_ids ids of the pages, hottest first
+   */
+  virtual void WriteWarmupList(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * Read the warm-up list written by WriteWarmupList().
+   * @return ids of the pages, hottest first, or nothing if there is no valid list
+   */
+  virtual auto ReadWarmupList() -> std::vector<page_id_t>;
+
+  /**
+   * Replace the master record, which locates the last complete checkpoint in the log. It is kept in its own small file
+   * next to the database file, which is replaced as a whole and is durable when this returns.
+   * @param offset log file offset of the last END_CHECKPOINT record of the checkpoint
+   */
+  virtual void WriteMasterRecord(size_t offset);
+
+  /**
+   * Read the master record written by WriteMasterRecord().
+   * @param[out] offset log file offset of the last END_CHECKPOINT record of the last complete checkpoint
+   * @return false if there is no master record
+   */
+  virtual auto ReadMasterRecord(size_t *offset) -> bool;
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -72,7 +162,36 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  auto ReadLog(char *log_data, int size, int offset) -> bool;
+  auto ReadLog(char *log_data, int size, size_t offset) -> bool;
+
+  /**
+   * Cut the log off at size bytes, e.g. to drop a record that was torn by a crash before appending again.
+   * @param size new size of the log
+   */
+  void TruncateLog(size_t size);
+
+  /**
+   * Create the segment the log ends in and the one after it, if they do not exist yet. Since a log write is smaller
+   * than a segment, the next one then finds all its segments in place. Called after every log write, off the path
+   * that commits wait on.
+   */
+  void PrepareLogSegments();
+
+  /**
+   * Reuse or remove the log segments that hold only offsets below offset. Up to LOG_SEGMENT_SPARES segments are kept
+   * as spares after the current one, the others are removed.
+   * @param offset the smallest log offset that is still needed
+   */
+  void RecycleLogSegments(size_t offset);
+
+  /**
+   * @return the size of the log in bytes, 0 without a log file. Until recovery has truncated the log at its last valid
+   * record, this is the end of the last segment; the log must be recovered before anything is appended to it.
+   */
+  auto GetLogFileSize() -> size_t;
+
+  /** @return true once the end of the log is known, i.e. the log was empty when opened or has been truncated since */
+  auto IsLogRecovered() const -> bool { return log_recovered_; }
 
   /** @return the number of disk flushes */
   auto GetNumFlushes() const -> int;
@@ -83,6 +202,9 @@ class DiskManager {
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
+  /** @return how the database file is accessed */
+  auto GetIOMode() const -> DiskIOMode { return io_mode_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -94,18 +216,47 @@ class DiskManager {
 
  protected:
   auto GetFileSize(const std::string &file_name) -> int;
-  // stream to write log file
-  std::fstream log_io_;
+  void GrowFileSize(size_t size);
+  /** @return true if data can be transferred with the database file as it is */
+  auto IsAligned(const char *data) const -> bool {
+    return io_mode_ != DiskIOMode::Direct || reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT == 0;
+  }
+  /** @return the file name of a log segment */
+  auto LogSegmentName(size_t segment) const -> std::string { return log_name_ + "." + std::to_string(segment); }
+  /** @return the descriptor of a log segment, -1 if it does not exist. Needs log_io_latch_. */
+  auto GetLogSegment(size_t segment) -> int;
+  /** @return the descriptor of a new log segment written in full, -1 on failure. Needs log_create_latch_. */
+  auto CreateLogSegment(size_t segment) -> int;
+  // descriptors of the log segment files by segment number, empty for disk managers without a log file
+  std::map<size_t, int> log_segments_;
+  // logical size of the log, the offset the next log write goes to
+  std::atomic<size_t> log_end_{0};
+  // false while log_end_ is only the end of the last segment of a reopened log, see TruncateLog()
+  std::atomic<bool> log_recovered_{true};
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
   std::string file_name_;
+  // descriptor of the db file for positional reads and writes, -1 for disk managers without a db file
+  int db_fd_{-1};
+  DiskIOMode io_mode_{DiskIOMode::Buffered};
+  // size of the db file, tracked in memory so that reads do not have to ask the file system
+  std::atomic<size_t> db_file_size_{0};
+  // stream to write the page allocation map
+  std::fstream alloc_map_io_;
+  std::string alloc_map_name_;
+  // file of the warm-up list, written and read as a whole
+  std::string warmup_name_;
+  // file of the master record, written and read as a whole
+  std::string master_name_;
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
-  // With multiple buffer pool instances, need to protect file access
+  // With multiple buffer pool instances, need to protect the access to the file streams
   std::mutex db_io_latch_;
+  // protects log_segments_, log writes hold it only to find their segments
+  std::mutex log_io_latch_;
+  // serializes creating and renaming log segment files, which happens without log_io_latch_ held
+  std::mutex log_create_latch_;
 };
 
 }  // namespace bustub
@@ -115,6 +115,49 @@ class DiskManagerUnlimitedMemory : public DiskManager {
     memcpy(page_data, ptr->first.data(), BUSTUB_PAGE_SIZE);
   }
 
+  /**
+   * Write a page of the page allocation map.
+   * @param map_page_idx position of the page in the allocation map
+   * @param page_data raw page data
+   */
+  void WriteAllocationMapPage(size_t map_page_idx, const char *page_data) override {
+    std::unique_lock<std::mutex> l(mutex_);
+    if (map_page_idx >= alloc_map_.size()) {
+      alloc_map_.resize(map_page_idx + 1);
+    }
+    memcpy(alloc_map_[map_page_idx].data(), page_data, BUSTUB_PAGE_SIZE);
+  }
+
+  /**
+   * Read a page of the page allocation map.
+   * @param map_page_idx position of the page in the allocation map
+   * @param[out] page_data output buffer
+   * @return false if the allocation map has no page at map_page_idx
+   */
+  auto ReadAllocationMapPage(size_t map_page_idx, char *page_data) -> bool override {
+    std::unique_lock<std::mutex> l(mutex_);
+    if (map_page_idx >= alloc_map_.size()) {
+      return false;
+    }
+    memcpy(page_data, alloc_map_[map_page_idx].data(), BUSTUB_PAGE_SIZE);
+    return true;
+  }
+
+  /**
+   * Replace the warm-up list.
+   * @param page_ids ids of the pages, hottest first
+   */
+  void WriteWarmupList(const std::vector<page_id_t> &page_ids) override {
+    std::unique_lock<std::mutex> l(mutex_);
+    warmup_list_ = page_ids;
+  }
+
+  /** @return the warm-up list, hottest first */
+  auto ReadWarmupList() -> std::vector<page_id_t> override {
+    std::unique_lock<std::mutex> l(mutex_);
+    return warmup_list_;
+  }
+
   void SetLatency(size_t latency_ms) { latency_ = latency_ms; }
 
  private:
@@ -122,6 +165,8 @@ class DiskManagerUnlimitedMemory : public DiskManager {
   using Page = std::array<char, BUSTUB_PAGE_SIZE>;
   using ProtectedPage = std::pair<Page, std::shared_mutex>;
   std::vector<std::shared_ptr<ProtectedPage>> data_;
+  std::vector<Page> alloc_map_;
+  std::vector<page_id_t> warmup_list_;
   size_t latency_{0};
 };
 
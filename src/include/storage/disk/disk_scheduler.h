@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.h
+//
+// Identification: src/include/storage/disk/disk_scheduler.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * @brief A page transfer for the DiskScheduler to carry out.
+ */
+struct DiskRequest {
+  /** True for a write, false for a read. */
+  bool is_write_;
+  /** The data of the page to write, or the buffer to read the page into. Must stay valid until the request is done. */
+  char *data_;
+  /** Id of the page to transfer. */
+  page_id_t page_id_;
+  /** Set to true once the transfer is done. */
+  std::promise<bool> callback_;
+};
+
+/**
+ * DiskScheduler carries out the page transfers of a DiskManager on a pool of worker threads, so that a caller can keep
+ * many requests in flight and wait for them through the futures of their promises.
+ *
+ * A worker takes the oldest request together with the queued requests of the same kind for the pages adjacent to it,
+ * and transfers those with one vectored DiskManager call. Requests scheduled together are queued together, so runs of
+ * consecutive pages among them are always coalesced.
+ *
+ * Requests for the same page must not be in flight at the same time, they may complete in any order. The buffer pool
+ * guarantees this by marking frames in transfer with io_in_progress_.
+ */
+class DiskScheduler {
+ public:
+  /**
+   * @brief Start the workers.
+   * @param disk_manager the disk manager the requests are carried out with
+   * @param num_workers number of worker threads, at least one
+   */
+  explicit DiskScheduler(DiskManager *disk_manager, size_t num_workers = DISK_SCHEDULER_WORKERS);
+
+  /** @brief Carry out the requests still queued, then stop the workers. */
+  ~DiskScheduler();
+
+  DISALLOW_COPY_AND_MOVE(DiskScheduler);
+
+  /**
+   * @brief Queue a request.
+   * @param request the request, its promise is set once it is done
+   */
+  void Schedule(DiskRequest request);
+
+  /**
+   * @brief Queue several requests at once.
+   * @param requests the requests, their promises are set as they are done
+   */
+  void Schedule(std::vector<DiskRequest> requests);
+
+  /** @brief Queue the read of a page into data. @return a future that becomes ready once the page is read */
+  auto ScheduleRead(page_id_t page_id, char *data) -> std::future<bool>;
+
+  /** @brief Queue the write of a page from data. @return a future that becomes ready once the page is written */
+  auto ScheduleWrite(page_id_t page_id, const char *data) -> std::future<bool>;
+
+  /** @brief Create the promise of a request. */
+  static auto CreatePromise() -> std::promise<bool> { return {}; }
+
+ private:
+  /** @brief Main loop of a worker. */
+  void RunWorker();
+
+  /**
+   * @brief Take the oldest request from the queue together with the requests of the same kind for the pages adjacent
+   * to it, at most DISK_SCHEDULER_BATCH. Caller should hold latch_.
+   * @return the requests, sorted by page id
+   */
+  auto TakeBatch() -> std::vector<DiskRequest>;
+
+  /** @brief Transfer the pages of a batch from TakeBatch() and set the promises of its requests. */
+  void ExecuteBatch(std::vector<DiskRequest> *batch);
+
+  DiskManager *disk_manager_;
+  /** Requests waiting for a worker, oldest first. */
+  std::deque<DiskRequest> queue_;
+  /** True while the workers should wait for more requests. */
+  bool enable_{true};
+  /** Protects queue_ and enable_, signaled when either changes. */
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace bustub
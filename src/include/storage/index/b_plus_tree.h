@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 
+#include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
 #include "common/macros.h"
 #include "concurrency/transaction.h"
@@ -80,6 +81,25 @@ class BPlusTree {
 
   auto FindNextPage(const KeyType &key, const InternalPage *inner_page, int left, int right, page_id_t *next) -> int;
 
+  // Collect the children of inner_page to the right of child_index, in key order.
+  void CollectSiblings(const InternalPage *inner_page, int child_index, std::vector<page_id_t> *siblings);
+
+  /**
+   * @brief Descend to the leaf that may hold key, or to the leftmost leaf if key is nullptr. The header and internal
+   * pages are read optimistically and only the leaf is read latched. After OPTIMISTIC_READ_RETRIES descents that
+   * raced with a writer, latch coupling is used instead.
+   *
+   * @param[out] leaf_page_id id of the leaf
+   * @param[out] upcoming_leaves right siblings of the leaf under its parent, not collected if nullptr
+   * @return read guard on the leaf, invalid if the tree has no root
+   */
+  auto FindLeafRead(const KeyType *key, page_id_t *leaf_page_id, std::vector<page_id_t> *upcoming_leaves)
+      -> ReadPageGuard;
+
+  // One optimistic descent of FindLeafRead(), returns false if it raced with a writer.
+  auto TryFindLeafOptimistic(const KeyType *key, page_id_t *leaf_page_id, std::vector<page_id_t> *upcoming_leaves,
+                             ReadPageGuard *leaf) -> bool;
+
   auto FindValueType(const KeyType &key, const LeafPage *leaf_page, int left, int right, std::vector<ValueType> *result)
       -> bool;
 
@@ -172,6 +192,8 @@ class BPlusTree {
   int leaf_max_size_;
   int internal_max_size_;
   page_id_t header_page_id_;
+  /** Page ids reserved for the next tree pages, so that the leaves of a range lie close together on disk. */
+  PageExtent extent_;
 };
 
 /**
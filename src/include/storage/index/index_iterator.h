@@ -13,6 +13,9 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <deque>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
 #include "storage/page/b_plus_tree_internal_page.h"
@@ -33,8 +36,12 @@ class IndexIterator {
   IndexIterator();
   ~IndexIterator();  // NOLINT
 
+  /**
+   * @param upcoming_leaves ids of the leaves expected after the current one, e.g. its right siblings under the same
+   * parent. They are only used for read-ahead.
+   */
   explicit IndexIterator(BufferPoolManager *bpm, page_id_t current_page_id, ReadPageGuard &&current_page,
-                         int current_index = 0);
+                         int current_index = 0, std::vector<page_id_t> upcoming_leaves = {});
   explicit IndexIterator(page_id_t current_page_id);
 
   auto IsEnd() -> bool;
@@ -52,11 +59,22 @@ class IndexIterator {
   }
 
  private:
+  /**
+   * Keep the next scan_prefetch_window leaves in flight. Once the known upcoming leaves run out, fall back to the
+   * next page id of the current leaf.
+   */
+  void Prefetch();
+
   // add your own private member variables here
   BufferPoolManager *bpm_;
   page_id_t current_page_id_;
   ReadPageGuard current_page_;
   int current_index_;
+
+  // Leaves expected after the current one; the first prefetched_ of them have been passed to
+  // BufferPoolManager::Prefetch().
+  std::deque<page_id_t> upcoming_leaves_;
+  size_t prefetched_{0};
 };
 
 }  // namespace bustub
@@ -12,6 +12,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
 #include <cstring>
 #include <iostream>
 
@@ -28,46 +31,73 @@ namespace bustub {
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
+  friend class OptimisticReadGuard;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() {
-    data_ = new char[BUSTUB_PAGE_SIZE];
-    ResetMemory();
-  }
+  /** Constructor. Allocates and zeros out the page data. */
+  Page() : data_(new char[BUSTUB_PAGE_SIZE]), owns_data_(true) { ResetMemory(); }
+
+  /** Constructor for a page whose data is owned by someone else, e.g. the frame arena of the buffer pool. */
+  explicit Page(char *data) : data_(data) { ResetMemory(); }
 
-  /** Default destructor. */
-  ~Page() { delete[] data_; }
+  /** Destructor. Frees the page data if the page allocated it. */
+  ~Page() {
+    if (owns_data_) {
+      delete[] data_;
+    }
+  }
 
   /** @return the actual data contained within this page */
   inline auto GetData() -> char * { return data_; }
 
   /** @return the page id of this page */
-  inline auto GetPageId() -> page_id_t { return page_id_; }
+  inline auto GetPageId() -> page_id_t { return page_id_.load(std::memory_order_acquire); }
 
-  /** @return the pin count of this page */
-  inline auto GetPinCount() -> int { return pin_count_; }
+  /** @return the pin count of this page, 0 for a frame the buffer pool has claimed */
+  inline auto GetPinCount() -> int { return std::max(pin_count_.load(std::memory_order_acquire), 0); }
 
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
-  inline auto IsDirty() -> bool { return is_dirty_; }
+  inline auto IsDirty() -> bool { return is_dirty_.load(std::memory_order_acquire); }
 
-  /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  /** Acquire the page write latch. The version becomes odd until the latch is released. */
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.fetch_add(1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
 
+  /** Acquire the page read latch if no writer holds it. @return true if the latch was acquired */
+  inline auto TryRLatch() -> bool { return rwlatch_.TryRLock(); }
+
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
-  /** @return the page LSN. */
+  /**
+   * @return the page version, which is odd while a writer holds the page latch and changes every time one does. Readers
+   * that did not take the latch compare it before and after reading to detect a concurrent write.
+   */
+  inline auto GetVersion() -> uint64_t { return version_.load(std::memory_order_acquire); }
+
+  /** @return the page LSN. Only meaningful if HasLSN(), other pages keep other data there. */
   inline auto GetLSN() -> lsn_t { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
-  /** Sets the page LSN. */
-  inline void SetLSN(lsn_t lsn) { memcpy(GetData() + OFFSET_LSN, &lsn, sizeof(lsn_t)); }
+  /** Sets the page LSN, which marks the page as one that carries an LSN. */
+  inline void SetLSN(lsn_t lsn) {
+    memcpy(GetData() + OFFSET_LSN, &lsn, sizeof(lsn_t));
+    has_lsn_.store(true, std::memory_order_release);
+  }
+
+  /** @return true if SetLSN() was called since the page was brought into its frame */
+  inline auto HasLSN() -> bool { return has_lsn_.load(std::memory_order_acquire); }
 
  protected:
   static_assert(sizeof(page_id_t) == 4);
@@ -85,14 +115,52 @@ class Page {
   // Usually this should be stored as `char data_[BUSTUB_PAGE_SIZE]{};`. But to enable ASAN to detect page overflow,
   // we store it as a ptr.
   char *data_;
+  /** True if data_ was allocated by this page. */
+  bool owns_data_{false};
   /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  std::atomic<page_id_t> page_id_ = INVALID_PAGE_ID;
+  /**
+   * The pin count of this page. Resident pages are pinned without the shard latch, so it is atomic. The buffer pool
+   * claims a frame by swinging it from 0 to a large negative value, see BufferPoolManager::FRAME_CLAIMED.
+   */
+  std::atomic<int> pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_ = false;
+  /**
+   * The recovery lsn: the next lsn of the log when the page was last read or written back. The changes of the page
+   * logged before it are on disk. Protected by the shard latch.
+   */
+  lsn_t rec_lsn_ = INVALID_LSN;
+  /**
+   * The recovery lsn the page gets once the write-back in progress is on disk. Until then rec_lsn_ keeps the old one,
+   * so that a checkpoint taken meanwhile does not skip the changes being written. Protected by the shard latch.
+   */
+  lsn_t written_rec_lsn_ = INVALID_LSN;
+  /** True if the page carries an LSN, see HasLSN(). Cleared when the frame gets another page. */
+  std::atomic<bool> has_lsn_ = false;
+  /**
+   * True while the buffer pool manager reads this page from disk or writes it back without holding its latch.
+   * Other requesters of the page wait on `io_done_` instead of touching the half-transferred data.
+   */
+  std::atomic<bool> io_in_progress_ = false;
+  /** Signaled when `io_in_progress_` is cleared. */
+  std::condition_variable io_done_;
+  /** True if the page was brought in by a scan and nobody else has used it since, so its frame may be recycled. */
+  std::atomic<bool> in_scan_ring_ = false;
+  /** Hits that pinned the page without the shard latch and have not been recorded in the replacer yet. */
+  std::atomic<uint32_t> pending_accesses_ = 0;
+  /** Replacer times of the first and the last of the pending hits, see Replacer::Now(). */
+  std::atomic<size_t> first_pending_access_ = 0;
+  std::atomic<size_t> last_pending_access_ = 0;
+  /**
+   * True while the replacer holds the frame as not evictable because an eviction found it pinned. Whoever releases
+   * the last pin makes it evictable again.
+   */
+  std::atomic<bool> parked_ = false;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Bumped when the write latch is acquired and again when it is released, see GetVersion(). */
+  std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
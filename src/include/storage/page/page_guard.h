@@ -80,9 +80,16 @@ class BasicPageGuard {
     return reinterpret_cast<T *>(GetDataMut());
   }
 
+  /** Sets the page LSN, see Page::SetLSN(). */
+  void SetLSN(lsn_t lsn) {
+    is_dirty_ = true;
+    page_->SetLSN(lsn);
+  }
+
  private:
   friend class ReadPageGuard;
   friend class WritePageGuard;
+  friend class OptimisticReadGuard;
 
   BufferPoolManager *bpm_{nullptr};
   Page *page_{nullptr};
@@ -135,6 +142,8 @@ class ReadPageGuard {
    */
   ~ReadPageGuard();
 
+  auto IsValid() -> bool { return guard_.IsValid(); }
+
   auto PageId() -> page_id_t { return guard_.PageId(); }
 
   auto GetData() -> const char * { return guard_.GetData(); }
@@ -145,10 +154,61 @@ class ReadPageGuard {
   }
 
  private:
+  friend class OptimisticReadGuard;
+
   // You may choose to get rid of this and add your own private variables.
   BasicPageGuard guard_;
 };
 
+/**
+ * OptimisticReadGuard pins a page like BasicPageGuard but reads it without taking the page latch, so readers do not
+ * contend on the latch of hot pages such as the root of an index. It remembers the page version it started from;
+ * whatever was read through the guard may be torn by a concurrent writer and must only be trusted after Validate()
+ * returned true. Readers have to tolerate garbage until then, e.g. by bounds checking the sizes they read.
+ */
+class OptimisticReadGuard {
+ public:
+  OptimisticReadGuard() = default;
+
+  /** Waits until no writer holds the page latch and records the page version. */
+  OptimisticReadGuard(BufferPoolManager *bpm, Page *page);
+  OptimisticReadGuard(const OptimisticReadGuard &) = delete;
+  auto operator=(const OptimisticReadGuard &) -> OptimisticReadGuard & = delete;
+  OptimisticReadGuard(OptimisticReadGuard &&that) noexcept = default;
+  auto operator=(OptimisticReadGuard &&that) noexcept -> OptimisticReadGuard & = default;
+  ~OptimisticReadGuard() = default;
+
+  /** Unpin the page. */
+  void Drop() { guard_.Drop(); }
+
+  auto IsValid() -> bool { return guard_.IsValid(); }
+
+  /**
+   * @brief Check that no writer latched the page since the guard was taken, i.e. everything read so far is
+   * consistent. Can be called any number of times.
+   */
+  auto Validate() -> bool;
+
+  /**
+   * @brief Turn this guard into a ReadPageGuard on the same page, keeping the pin. The read latch is taken, so the
+   * page may have changed since the guard was taken; call Validate() on other guards to check the way here.
+   */
+  auto UpgradeRead() -> ReadPageGuard;
+
+  auto PageId() -> page_id_t { return guard_.PageId(); }
+
+  auto GetData() -> const char * { return guard_.GetData(); }
+
+  template <class T>
+  auto As() -> const T * {
+    return guard_.As<T>();
+  }
+
+ private:
+  BasicPageGuard guard_;
+  uint64_t version_{0};
+};
+
 class WritePageGuard {
  public:
   WritePageGuard() = default;
@@ -213,6 +273,8 @@ class WritePageGuard {
     return guard_.AsMut<T>();
   }
 
+  void SetLSN(lsn_t lsn) { guard_.SetLSN(lsn); }
+
  private:
   // You may choose to get rid of this and add your own private variables.
   BasicPageGuard guard_;
@@ -27,7 +27,9 @@
 
 namespace bustub {
 
-static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 8;
+static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 16;
+/** Stamped into the header by TablePage::Init(), "TPAG". */
+static constexpr uint32_t TABLE_PAGE_MAGIC = 0x54504147;
 
 /**
  * Slotted page format:
@@ -39,8 +41,10 @@ static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 8;
  *
  *  Header format (size in bytes):
  *  ----------------------------------------------------------------------------
- *  | NextPageId (4)| NumTuples(2) | NumDeletedTuples(2) |
+ *  | NextPageId (4)| LSN (4) | NumTuples(2) | NumDeletedTuples(2) | Magic (4) |
  *  ----------------------------------------------------------------------------
+ *  The LSN is where Page::GetLSN() reads it, it is the LSN of the last log record applied to the page. The magic tells
+ *  a table page from a page that held something else before its page id was reused, whose LSN means nothing.
  *  ----------------------------------------------------------------
  *  | Tuple_1 offset+size (4) | Tuple_2 offset+size (4) | ... |
  *  ----------------------------------------------------------------
@@ -65,6 +69,12 @@ class TablePage {
   /** Set the page id of the next page in the table. */
   void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
 
+  /** @return the lsn of the last log record applied to this page, set through Page::SetLSN() */
+  auto GetLSN() const -> lsn_t { return lsn_; }
+
+  /** @return true if the page was initialized as a table page */
+  auto IsTablePage() const -> bool { return magic_ == TABLE_PAGE_MAGIC; }
+
   /** Get the next offset to insert, return nullopt if this tuple cannot fit in this page */
   auto GetNextTupleOffset(const TupleMeta &meta, const Tuple &tuple) const -> std::optional<uint16_t>;
 
@@ -101,8 +111,10 @@ class TablePage {
   using TupleInfo = std::tuple<uint16_t, uint16_t, TupleMeta>;
   char page_start_[0];
   page_id_t next_page_id_;
+  lsn_t lsn_;
   uint16_t num_tuples_;
   uint16_t num_deleted_tuples_;
+  uint32_t magic_;
   TupleInfo tuple_info_[0];
 
   static constexpr size_t TUPLE_INFO_SIZE = 16;
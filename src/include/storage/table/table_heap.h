@@ -16,6 +16,7 @@
 #include <mutex>  // NOLINT
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
@@ -31,6 +32,10 @@ namespace bustub {
 /**
  * TableHeap represents a physical table on disk.
  * This is just a doubly-linked list of pages.
+ *
+ * While logging is enabled, every change to a page is written ahead to the log and the page is stamped with the lsn
+ * of its record, see Page::SetLSN(). Changes made without a transaction are logged with INVALID_TXN_ID, so
+ * recovery redoes them but never undoes them.
  */
 class TableHeap {
   friend class TableIterator;
@@ -41,9 +46,9 @@ class TableHeap {
   /**
    * Create a table heap without a transaction. (open table)
    * @param buffer_pool_manager the buffer pool manager
-   * @param first_page_id the id of the first page
+   * @param log_manager the log manager the changes are logged to while logging is enabled, nullptr to never log
    */
-  explicit TableHeap(BufferPoolManager *bpm);
+  explicit TableHeap(BufferPoolManager *bpm, LogManager *log_manager = nullptr);
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return std::nullopt.
@@ -55,18 +60,40 @@ class TableHeap {
                    Transaction *txn = nullptr, table_oid_t oid = 0) -> std::optional<RID>;
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * Insert a batch of tuples into the table. The last page is fetched and latched once for the whole batch, a page
+   * the batch has filled is released as soon as the batch moves on to the next one.
+   * @param meta tuple meta of every tuple
+   * @param tuples tuples to insert
+   * @return rids of the inserted tuples, in the order of tuples
+   */
+  auto InsertTuples(const TupleMeta &meta, const std::vector<Tuple> &tuples, LockManager *lock_mgr = nullptr,
+                    Transaction *txn = nullptr, table_oid_t oid = 0) -> std::vector<RID>;
+
+  /**
+   * Update the meta of a tuple. Setting is_deleted_ is logged as MARKDELETE, clearing it as ROLLBACKDELETE.
    * @param meta new tuple meta
-   * @param[out] rid the rid of the inserted tuple
+   * @param rid the rid of the tuple
+   * @param txn the transaction the change is logged for
    */
-  void UpdateTupleMeta(const TupleMeta &meta, RID rid);
+  void UpdateTupleMeta(const TupleMeta &meta, RID rid, Transaction *txn = nullptr);
 
   /**
    * Read a tuple from the table.
    * @param rid rid of the tuple to read
+   * @param access_type how the page is accessed, table iterators pass AccessType::Scan
    * @return the meta and tuple
    */
-  auto GetTuple(RID rid) -> std::pair<TupleMeta, Tuple>;
+  auto GetTuple(RID rid, AccessType access_type = AccessType::Unknown) -> std::pair<TupleMeta, Tuple>;
+
+  /**
+   * Read a batch of tuples from the table. The pages holding them are pinned with one BufferPoolManager::FetchPages()
+   * call instead of one fetch per tuple.
+   * @param rids rids of the tuples to read
+   * @param access_type how the pages are accessed
+   * @return the metas and tuples, in the order of rids
+   */
+  auto GetTuples(const std::vector<RID> &rids, AccessType access_type = AccessType::Unknown)
+      -> std::vector<std::pair<TupleMeta, Tuple>>;
 
   /**
    * Read a tuple meta from the table. Note: if you want to get tuple and meta together, use `GetTuple` instead
@@ -85,6 +112,14 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /**
+   * Look up pages by their position in the page list, for read-ahead.
+   * @param page_idx position of the first page, the first page of the table is at 0
+   * @param max_pages maximum number of pages to return
+   * @return the ids of up to max_pages pages starting at page_idx
+   */
+  auto GetPageIds(size_t page_idx, size_t max_pages) -> std::vector<page_id_t>;
+
   /**
    * Update a tuple in place. SHOULD NOT BE USED UNLESS YOU WANT TO OPTIMIZE FOR PROJECT 4.
    * @param meta new tuple meta
@@ -104,11 +139,26 @@ class TableHeap {
   /** Used for binder tests */
   explicit TableHeap(bool create_table_heap = false);
 
+  /** @return true if changes have to be logged */
+  auto IsLogging() const -> bool { return enable_logging && log_manager_ != nullptr; }
+
+  /**
+   * Append a log record for a change of the table, on behalf of txn if it is not null.
+   * @return the lsn of the record, the changed pages have to be stamped with it before they are unlatched
+   */
+  auto AppendLogRecord(LogRecord *log_record, Transaction *txn) -> lsn_t;
+
+  /** Log the creation of the page new_page_id after prev_page_id, see AppendLogRecord(). */
+  auto LogNewPage(page_id_t prev_page_id, page_id_t new_page_id, Transaction *txn) -> lsn_t;
+
   BufferPoolManager *bpm_;
+  LogManager *log_manager_{nullptr};
   page_id_t first_page_id_{INVALID_PAGE_ID};
 
   std::mutex latch_;
   page_id_t last_page_id_{INVALID_PAGE_ID}; /* protected by latch_ */
+  std::vector<page_id_t> page_ids_;         /* ids of all pages in list order, protected by latch_ */
+  PageExtent extent_;                       /* page ids reserved for the next pages, protected by latch_ */
 };
 
 }  // namespace bustub
@@ -62,9 +62,17 @@ class TableIterator {
   auto operator++() -> TableIterator &;
 
  private:
+  /** Ask the buffer pool for the pages up to scan_prefetch_window after the current one that are not requested yet. */
+  void Prefetch();
+
   TableHeap *table_heap_;
   RID rid_;
 
+  // Position of the current page in the page list of the table, and of the first page not yet passed to
+  // BufferPoolManager::Prefetch().
+  size_t page_idx_{0};
+  size_t prefetch_idx_{1};
+
   // When creating table iterator, we will record the maximum RID that we should scan.
   // Otherwise we will have dead loops when updating while scanning. (In project 4, update should be implemented as
   // deletion + insertion.)
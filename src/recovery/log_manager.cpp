@@ -12,6 +12,10 @@
 
 #include "recovery/log_manager.h"
 
+#include <cstring>
+
+#include "common/macros.h"
+
 namespace bustub {
 /*
  * set enable_logging = true
@@ -22,33 +26,210 @@ namespace bustub {
  *
  * This thread runs forever until system shutdown/StopFlushThread
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  BUSTUB_ENSURE(disk_manager_->IsLogRecovered(), "the log must be recovered before logging is enabled");
+  disk_manager_->PrepareLogSegments();
+  enable_logging = true;
+  flush_thread_ = new std::thread(&LogManager::FlushLoop, this);
+}
 
 /*
  * Stop and join the flush thread, set enable_logging = false
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  std::thread *flush_thread;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (flush_thread_ == nullptr) {
+      return;
+    }
+    stop_flush_thread_ = true;
+    flush_thread = flush_thread_;
+  }
+  cv_.notify_one();
+  flush_thread->join();
+  delete flush_thread;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    flush_thread_ = nullptr;
+    stop_flush_thread_ = false;
+  }
+  // waiters that asked the flush thread for a flush write the log themselves from now on
+  flushed_cv_.notify_all();
+  enable_logging = false;
+}
+
+void LogManager::FlushLoop() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    cv_.wait_for(lock, log_timeout, [this] { return flush_requested_ || stop_flush_thread_; });
+    flush_requested_ = false;
+    // the records appended while the previous batch was written go out together
+    FlushBuffer(&lock);
+    if (stop_flush_thread_ && OffsetOf(reservation_.load()) == 0) {
+      return;
+    }
+  }
+}
+
+void LogManager::FlushBuffer(std::unique_lock<std::mutex> *lock) {
+  flushed_cv_.wait(*lock, [this] { return !flushing_; });
+
+  // close the buffer, reservations fail from here on and their appenders wait for room
+  uint64_t reservation = reservation_.load();
+  while (!reservation_.compare_exchange_weak(reservation, Pack(CLOSED, LsnOf(reservation)))) {
+  }
+  uint64_t size = OffsetOf(reservation);
+  if (size == 0) {
+    reservation_.store(reservation);
+    return;
+  }
+
+  // the appenders that reserved space before the buffer was closed are still copying their records
+  while (filled_.load(std::memory_order_acquire) < size) {
+    std::this_thread::yield();
+  }
+  std::swap(log_buffer_, flush_buffer_);
+  buffer_offset_.fetch_add(size, std::memory_order_relaxed);
+  filled_.store(0, std::memory_order_relaxed);
+  reservation_.store(Pack(0, LsnOf(reservation)), std::memory_order_release);
+  flushing_ = true;
+  flushed_cv_.notify_all();
+
+  bool has_flush_thread = flush_thread_ != nullptr;
+  lock->unlock();
+  if (!has_flush_thread) {
+    // logging is off, nobody commits while the first segment is created
+    disk_manager_->PrepareLogSegments();
+  }
+  disk_manager_->WriteLog(flush_buffer_, static_cast<int>(size));
+  lock->lock();
+
+  persistent_lsn_ = LsnOf(reservation) - 1;
+  flushing_ = false;
+  flushed_cv_.notify_all();
+
+  // the next write may go into the next segment, create it now that the commits of this one are released
+  lock->unlock();
+  disk_manager_->PrepareLogSegments();
+  lock->lock();
+}
+
+void LogManager::WaitUntilPersistent(lsn_t lsn) {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (persistent_lsn_ < lsn) {
+    if (flush_thread_ == nullptr) {
+      // the record is either in the buffer being written, which is waited for, or in the one written next
+      FlushBuffer(&lock);
+      return;
+    }
+    flush_requested_ = true;
+    cv_.notify_one();
+    flushed_cv_.wait(lock);
+  }
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
- *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
  */
-auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t { return INVALID_LSN; }
+auto LogManager::AppendLogRecord(LogRecord *log_record, size_t *offset) -> lsn_t {
+  int32_t size = log_record->GetSize();
+  BUSTUB_ENSURE(size <= LOG_BUFFER_SIZE, "log record is larger than the log buffer");
+
+  // reserve size bytes and the next lsn together, so that the records are in lsn order in the log
+  uint64_t reservation = reservation_.load(std::memory_order_acquire);
+  while (true) {
+    if (OffsetOf(reservation) + size > static_cast<uint64_t>(LOG_BUFFER_SIZE)) {
+      WaitForRoom(size);
+      reservation = reservation_.load(std::memory_order_acquire);
+      continue;
+    }
+    if (reservation_.compare_exchange_weak(reservation, reservation + Pack(size, 1), std::memory_order_acq_rel,
+                                           std::memory_order_acquire)) {
+      break;
+    }
+  }
+
+  // the buffer cannot be swapped before the reserved bytes are filled
+  log_record->lsn_ = LsnOf(reservation);
+  SerializeLogRecord(log_record, log_buffer_ + OffsetOf(reservation));
+  if (offset != nullptr) {
+    *offset = buffer_offset_.load(std::memory_order_relaxed) + OffsetOf(reservation);
+  }
+  filled_.fetch_add(size, std::memory_order_release);
+  return log_record->lsn_;
+}
+
+void LogManager::WaitForRoom(int32_t size) {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (OffsetOf(reservation_.load()) + size > static_cast<uint64_t>(LOG_BUFFER_SIZE)) {
+    if (flush_thread_ == nullptr) {
+      FlushBuffer(&lock);
+      continue;
+    }
+    flush_requested_ = true;
+    cv_.notify_one();
+    flushed_cv_.wait(lock);
+  }
+}
+
+void LogManager::SerializeLogRecord(LogRecord *log_record, char *buf) {
+  // header, see the layout in log_record.h
+  memcpy(buf, &log_record->size_, sizeof(int32_t));
+  memcpy(buf + 4, &log_record->lsn_, sizeof(lsn_t));
+  memcpy(buf + 8, &log_record->txn_id_, sizeof(txn_id_t));
+  memcpy(buf + 12, &log_record->prev_lsn_, sizeof(lsn_t));
+  memcpy(buf + 16, &log_record->log_record_type_, sizeof(LogRecordType));
+  char *pos = buf + LogRecord::HEADER_SIZE;
+
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      memcpy(pos, &log_record->insert_rid_, sizeof(RID));
+      log_record->insert_tuple_.SerializeTo(pos + sizeof(RID));
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(pos, &log_record->delete_rid_, sizeof(RID));
+      log_record->delete_tuple_.SerializeTo(pos + sizeof(RID));
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(pos, &log_record->update_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->old_tuple_.SerializeTo(pos);
+      pos += sizeof(int32_t) + log_record->old_tuple_.GetLength();
+      log_record->new_tuple_.SerializeTo(pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(pos, &log_record->prev_page_id_, sizeof(page_id_t));
+      memcpy(pos + sizeof(page_id_t), &log_record->page_id_, sizeof(page_id_t));
+      break;
+    case LogRecordType::END_CHECKPOINT: {
+      auto num_txns = static_cast<int32_t>(log_record->active_txns_.size());
+      auto num_pages = static_cast<int32_t>(log_record->dirty_pages_.size());
+      memcpy(pos, &log_record->prev_offset_, sizeof(size_t));
+      pos += sizeof(size_t);
+      memcpy(pos, &log_record->dirty_page_lsn_, sizeof(lsn_t));
+      pos += sizeof(lsn_t);
+      memcpy(pos, &num_txns, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      memcpy(pos, log_record->active_txns_.data(), num_txns * sizeof(CheckpointTxn));
+      pos += num_txns * sizeof(CheckpointTxn);
+      memcpy(pos, &num_pages, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      memcpy(pos, log_record->dirty_pages_.data(), num_pages * sizeof(CheckpointPage));
+      break;
+    }
+    default:
+      // BEGIN, COMMIT, ABORT and BEGIN_CHECKPOINT have only the header
+      break;
+  }
+}
 
 }  // namespace bustub
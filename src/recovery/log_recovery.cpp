@@ -0,0 +1,453 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_recovery.cpp
+//
+// Identification: src/recovery/log_recovery.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "recovery/log_recovery.h"
+
+#include <cstring>
+#include <utility>
+
+#include "common/macros.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+auto LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool {
+  // header, see the layout in log_record.h
+  int32_t size;
+  memcpy(&size, data, sizeof(int32_t));
+  if (size < LogRecord::HEADER_SIZE || size > LOG_BUFFER_SIZE) {
+    return false;
+  }
+  log_record->size_ = size;
+  memcpy(&log_record->lsn_, data + 4, sizeof(lsn_t));
+  memcpy(&log_record->txn_id_, data + 8, sizeof(txn_id_t));
+  memcpy(&log_record->prev_lsn_, data + 12, sizeof(lsn_t));
+  memcpy(&log_record->log_record_type_, data + 16, sizeof(LogRecordType));
+  const char *pos = data + LogRecord::HEADER_SIZE;
+
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      memcpy(&log_record->insert_rid_, pos, sizeof(RID));
+      log_record->insert_tuple_.DeserializeFrom(pos + sizeof(RID));
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(&log_record->delete_rid_, pos, sizeof(RID));
+      log_record->delete_tuple_.DeserializeFrom(pos + sizeof(RID));
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(&log_record->update_rid_, pos, sizeof(RID));
+      pos += sizeof(RID);
+      log_record->old_tuple_.DeserializeFrom(pos);
+      pos += sizeof(int32_t) + log_record->old_tuple_.GetLength();
+      log_record->new_tuple_.DeserializeFrom(pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(&log_record->prev_page_id_, pos, sizeof(page_id_t));
+      memcpy(&log_record->page_id_, pos + sizeof(page_id_t), sizeof(page_id_t));
+      break;
+    case LogRecordType::END_CHECKPOINT: {
+      int32_t num_txns;
+      int32_t num_pages;
+      memcpy(&log_record->prev_offset_, pos, sizeof(size_t));
+      pos += sizeof(size_t);
+      memcpy(&log_record->dirty_page_lsn_, pos, sizeof(lsn_t));
+      pos += sizeof(lsn_t);
+      memcpy(&num_txns, pos, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      if (num_txns < 0 || LogRecord::EndCheckpointSize(num_txns, 0) > size) {
+        return false;
+      }
+      log_record->active_txns_.resize(num_txns);
+      memcpy(log_record->active_txns_.data(), pos, num_txns * sizeof(CheckpointTxn));
+      pos += num_txns * sizeof(CheckpointTxn);
+      memcpy(&num_pages, pos, sizeof(int32_t));
+      pos += sizeof(int32_t);
+      if (num_pages < 0 || LogRecord::EndCheckpointSize(num_txns, num_pages) != size) {
+        return false;
+      }
+      log_record->dirty_pages_.resize(num_pages);
+      memcpy(log_record->dirty_pages_.data(), pos, num_pages * sizeof(CheckpointPage));
+      break;
+    }
+    case LogRecordType::BEGIN:
+    case LogRecordType::COMMIT:
+    case LogRecordType::ABORT:
+    case LogRecordType::BEGIN_CHECKPOINT:
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+auto LogRecovery::ReadLogRecord(size_t offset, LogRecord *log_record) -> bool {
+  if (!disk_manager_->ReadLog(log_buffer_, LogRecord::HEADER_SIZE, offset)) {
+    return false;
+  }
+  int32_t size;
+  memcpy(&size, log_buffer_, sizeof(int32_t));
+  if (size < LogRecord::HEADER_SIZE || size > LOG_BUFFER_SIZE || offset + size > disk_manager_->GetLogFileSize()) {
+    return false;
+  }
+  return disk_manager_->ReadLog(log_buffer_ + LogRecord::HEADER_SIZE, size - LogRecord::HEADER_SIZE,
+                                offset + LogRecord::HEADER_SIZE) &&
+         DeserializeLogRecord(log_buffer_, log_record);
+}
+
+void LogRecovery::ReadCheckpoint() {
+  size_t offset;
+  if (!disk_manager_->ReadMasterRecord(&offset)) {
+    return;
+  }
+  // follow the END_CHECKPOINT records of the checkpoint back to its BEGIN_CHECKPOINT record
+  while (true) {
+    LogRecord log_record;
+    BUSTUB_ENSURE(ReadLogRecord(offset, &log_record), "the master record points to no checkpoint");
+    if (log_record.log_record_type_ == LogRecordType::BEGIN_CHECKPOINT) {
+      break;
+    }
+    BUSTUB_ENSURE(log_record.log_record_type_ == LogRecordType::END_CHECKPOINT && log_record.prev_offset_ < offset,
+                  "the master record points to no checkpoint");
+    dirty_page_lsn_ = log_record.dirty_page_lsn_;
+    for (const auto &txn : log_record.active_txns_) {
+      active_txn_[txn.txn_id_] = txn.last_lsn_;
+      first_offsets_[txn.txn_id_] = txn.first_offset_;
+    }
+    for (const auto &page : log_record.dirty_pages_) {
+      dirty_pages_[page.page_id_] = page.rec_lsn_;
+    }
+    offset = log_record.prev_offset_;
+  }
+  redo_start_ = offset;
+}
+
+auto LogRecovery::NeedsRedo(page_id_t page_id, lsn_t lsn) const -> bool {
+  if (lsn >= dirty_page_lsn_) {
+    return true;
+  }
+  // the page was clean at the checkpoint, or written back after lsn
+  auto it = dirty_pages_.find(page_id);
+  return it != dirty_pages_.end() && lsn >= it->second;
+}
+
+void LogRecovery::Redo() {
+  ReadCheckpoint();
+
+  std::vector<RedoQueue> redo_queues(redo_threads_);
+  redo_queues_.swap(redo_queues);
+  std::vector<std::thread> workers;
+  for (size_t worker = 0; worker < redo_threads_; worker++) {
+    workers.emplace_back(&LogRecovery::RedoLoop, this, worker);
+  }
+
+  // read the log in chunks, a record that crosses the end of a chunk is read again at the start of the next one
+  size_t log_size = disk_manager_->GetLogFileSize();
+  size_t chunk_offset = redo_start_;
+  bool end_of_log = false;
+  while (!end_of_log && chunk_offset < log_size) {
+    auto chunk = std::make_shared<std::vector<char>>(std::min<size_t>(REDO_READ_SIZE, log_size - chunk_offset));
+    BUSTUB_ENSURE(disk_manager_->ReadLog(chunk->data(), static_cast<int>(chunk->size()), chunk_offset),
+                  "cannot read the log");
+
+    std::vector<RedoBatch> batches(redo_threads_);
+    size_t pos = 0;
+    while (true) {
+      if (pos + LogRecord::HEADER_SIZE > chunk->size()) {
+        end_of_log = chunk_offset + pos + LogRecord::HEADER_SIZE > log_size;
+        break;
+      }
+      const char *record = chunk->data() + pos;
+      int32_t size;
+      memcpy(&size, record, sizeof(int32_t));
+      // The log ends at zeros, at a record the crash cut off, or at the log from before its segment was recycled,
+      // whose lsns do not continue the ones before. Without checksums, torn records are recognized only this way.
+      lsn_t lsn;
+      memcpy(&lsn, record + 4, sizeof(lsn_t));
+      if (size < LogRecord::HEADER_SIZE || size > LOG_BUFFER_SIZE || chunk_offset + pos + size > log_size ||
+          (max_lsn_ != INVALID_LSN && lsn != max_lsn_ + 1)) {
+        end_of_log = true;
+        break;
+      }
+      if (pos + size > chunk->size()) {
+        break;
+      }
+
+      // analysis
+      txn_id_t txn_id;
+      LogRecordType type;
+      memcpy(&txn_id, record + 8, sizeof(txn_id_t));
+      memcpy(&type, record + 16, sizeof(LogRecordType));
+      max_lsn_ = lsn;
+      num_records_++;
+      if (txn_id != INVALID_TXN_ID) {
+        if (type == LogRecordType::COMMIT || type == LogRecordType::ABORT) {
+          active_txn_.erase(txn_id);
+          undo_offsets_.erase(txn_id);
+          first_offsets_.erase(txn_id);
+        } else {
+          active_txn_[txn_id] = lsn;
+        }
+      }
+
+      // dispatch the record to the workers owning the pages it changes
+      const char *payload = record + LogRecord::HEADER_SIZE;
+      switch (type) {
+        case LogRecordType::INSERT:
+        case LogRecordType::MARKDELETE:
+        case LogRecordType::APPLYDELETE:
+        case LogRecordType::ROLLBACKDELETE:
+        case LogRecordType::UPDATE: {
+          RID rid;
+          memcpy(&rid, payload, sizeof(RID));
+          if (NeedsRedo(rid.GetPageId(), lsn)) {
+            batches[OwnerOf(rid.GetPageId())].offsets_.push_back(pos);
+          }
+          if (txn_id != INVALID_TXN_ID) {
+            undo_offsets_[txn_id].push_back(chunk_offset + pos);
+          }
+          break;
+        }
+        case LogRecordType::NEWPAGE: {
+          page_id_t prev_page_id;
+          page_id_t page_id;
+          memcpy(&prev_page_id, payload, sizeof(page_id_t));
+          memcpy(&page_id, payload + sizeof(page_id_t), sizeof(page_id_t));
+          bool redo_page = NeedsRedo(page_id, lsn);
+          bool redo_prev_page = prev_page_id != INVALID_PAGE_ID && NeedsRedo(prev_page_id, lsn);
+          if (redo_page) {
+            batches[OwnerOf(page_id)].offsets_.push_back(pos);
+          }
+          if (redo_prev_page && (!redo_page || OwnerOf(prev_page_id) != OwnerOf(page_id))) {
+            batches[OwnerOf(prev_page_id)].offsets_.push_back(pos);
+          }
+          break;
+        }
+        default:
+          break;
+      }
+      pos += size;
+    }
+
+    for (size_t worker = 0; worker < redo_threads_; worker++) {
+      if (batches[worker].offsets_.empty()) {
+        continue;
+      }
+      batches[worker].chunk_ = chunk;
+      RedoQueue &queue = redo_queues_[worker];
+      std::unique_lock<std::mutex> lock(queue.latch_);
+      queue.cv_.wait(lock, [&queue] { return queue.batches_.size() < REDO_QUEUE_DEPTH; });
+      queue.batches_.push_back(std::move(batches[worker]));
+      queue.cv_.notify_all();
+    }
+    chunk_offset += pos;
+  }
+  log_end_ = chunk_offset;
+
+  for (size_t worker = 0; worker < redo_threads_; worker++) {
+    {
+      std::scoped_lock<std::mutex> lock(redo_queues_[worker].latch_);
+      redo_queues_[worker].closed_ = true;
+    }
+    redo_queues_[worker].cv_.notify_all();
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  // new records go right after the last valid one, with the next lsn
+  disk_manager_->TruncateLog(log_end_);
+  log_manager_->SetNextLSN(max_lsn_ + 1);
+}
+
+void LogRecovery::RedoLoop(size_t worker) {
+  RedoQueue &queue = redo_queues_[worker];
+  while (true) {
+    RedoBatch batch;
+    {
+      std::unique_lock<std::mutex> lock(queue.latch_);
+      queue.cv_.wait(lock, [&queue] { return !queue.batches_.empty() || queue.closed_; });
+      if (queue.batches_.empty()) {
+        return;
+      }
+      batch = std::move(queue.batches_.front());
+      queue.batches_.pop_front();
+      queue.cv_.notify_all();
+    }
+
+    for (size_t offset : batch.offsets_) {
+      LogRecord log_record;
+      BUSTUB_ENSURE(DeserializeLogRecord(batch.chunk_->data() + offset, &log_record), "cannot parse a log record");
+      RedoRecord(&log_record, worker);
+    }
+  }
+}
+
+template <typename F>
+void LogRecovery::RedoOnPage(page_id_t page_id, lsn_t lsn, F &&apply) {
+  auto guard = buffer_pool_manager_->FetchPageWrite(page_id);
+  BUSTUB_ENSURE(guard.IsValid(), "no frame left to redo a page in");
+  // a page that is not a table page yet, e.g. one a b+ tree used before, has no lsn of its own
+  auto table_page = guard.As<TablePage>();
+  lsn_t page_lsn = table_page->IsTablePage() ? table_page->GetLSN() : INVALID_LSN;
+  if (page_lsn >= lsn) {
+    return;
+  }
+  apply(guard.AsMut<TablePage>());
+  guard.SetLSN(lsn);
+  num_redone_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LogRecovery::RedoRecord(LogRecord *log_record, size_t worker) {
+  lsn_t lsn = log_record->lsn_;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT: {
+      const RID &rid = log_record->insert_rid_;
+      RedoOnPage(rid.GetPageId(), lsn, [log_record, &rid](TablePage *page) {
+        // a page holds the changes up to its lsn and none after, so the tuple lands in the slot it had
+        auto slot = page->InsertTuple({INVALID_TXN_ID, INVALID_TXN_ID, false}, log_record->insert_tuple_);
+        BUSTUB_ENSURE(slot.has_value() && *slot == rid.GetSlotNum(), "redo put a tuple into another slot");
+      });
+      break;
+    }
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE: {
+      const RID &rid = log_record->delete_rid_;
+      bool is_deleted = log_record->log_record_type_ != LogRecordType::ROLLBACKDELETE;
+      RedoOnPage(rid.GetPageId(), lsn, [&rid, is_deleted](TablePage *page) {
+        page->UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, is_deleted}, rid);
+      });
+      break;
+    }
+    case LogRecordType::UPDATE: {
+      const RID &rid = log_record->update_rid_;
+      RedoOnPage(rid.GetPageId(), lsn, [log_record, &rid](TablePage *page) {
+        page->UpdateTupleInPlaceUnsafe(page->GetTupleMeta(rid), log_record->new_tuple_, rid);
+      });
+      break;
+    }
+    case LogRecordType::NEWPAGE: {
+      page_id_t page_id = log_record->page_id_;
+      page_id_t prev_page_id = log_record->prev_page_id_;
+      if (OwnerOf(page_id) == worker) {
+        // the allocation map on disk may be older than the log
+        buffer_pool_manager_->MarkPageAllocated(page_id);
+        // the page may still hold what its page id was used for before, e.g. a b+ tree node, or read as zeros
+        RedoOnPage(page_id, lsn, [](TablePage *page) { page->Init(); });
+      }
+      if (prev_page_id != INVALID_PAGE_ID && OwnerOf(prev_page_id) == worker) {
+        RedoOnPage(prev_page_id, lsn, [page_id](TablePage *page) { page->SetNextPageId(page_id); });
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void LogRecovery::CollectUndoOffsets() {
+  // losers of the checkpoint may have records before it
+  size_t undo_start = redo_start_;
+  for (const auto &[txn_id, first_offset] : first_offsets_) {
+    undo_start = std::min(undo_start, first_offset);
+  }
+
+  std::vector<char> chunk;
+  for (size_t chunk_offset = undo_start; chunk_offset < redo_start_;) {
+    chunk.resize(std::min<size_t>(REDO_READ_SIZE, redo_start_ - chunk_offset));
+    BUSTUB_ENSURE(disk_manager_->ReadLog(chunk.data(), static_cast<int>(chunk.size()), chunk_offset),
+                  "cannot read the log");
+    size_t pos = 0;
+    while (pos + LogRecord::HEADER_SIZE <= chunk.size()) {
+      const char *record = chunk.data() + pos;
+      int32_t size;
+      txn_id_t txn_id;
+      LogRecordType type;
+      memcpy(&size, record, sizeof(int32_t));
+      memcpy(&txn_id, record + 8, sizeof(txn_id_t));
+      memcpy(&type, record + 16, sizeof(LogRecordType));
+      BUSTUB_ENSURE(size >= LogRecord::HEADER_SIZE && size <= LOG_BUFFER_SIZE, "cannot parse a log record");
+      if (pos + size > chunk.size()) {
+        break;
+      }
+      bool changes_page = type == LogRecordType::INSERT || type == LogRecordType::MARKDELETE ||
+                          type == LogRecordType::APPLYDELETE || type == LogRecordType::ROLLBACKDELETE ||
+                          type == LogRecordType::UPDATE;
+      if (changes_page && first_offsets_.count(txn_id) != 0) {
+        undo_offsets_[txn_id].push_back(chunk_offset + pos);
+      }
+      pos += size;
+    }
+    chunk_offset += pos;
+  }
+}
+
+void LogRecovery::Undo() {
+  CollectUndoOffsets();
+
+  // roll back the changes of all losers in one backward pass over the log
+  std::vector<size_t> offsets;
+  for (const auto &[txn_id, txn_offsets] : undo_offsets_) {
+    offsets.insert(offsets.end(), txn_offsets.begin(), txn_offsets.end());
+  }
+  std::sort(offsets.rbegin(), offsets.rend());
+  for (size_t offset : offsets) {
+    LogRecord log_record;
+    BUSTUB_ENSURE(ReadLogRecord(offset, &log_record), "cannot read a log record");
+    UndoRecord(&log_record);
+  }
+
+  // The rollback is not logged, so it has to be on disk before the aborts are. Until then the next recovery rolls the
+  // losers back again, which is harmless: every change is set back to the state the log says it replaced.
+  if (!active_txn_.empty()) {
+    buffer_pool_manager_->FlushAllPages();
+    lsn_t lsn = INVALID_LSN;
+    for (const auto &[txn_id, last_lsn] : active_txn_) {
+      LogRecord log_record(txn_id, last_lsn, LogRecordType::ABORT);
+      lsn = log_manager_->AppendLogRecord(&log_record);
+    }
+    log_manager_->WaitUntilPersistent(lsn);
+  }
+  active_txn_.clear();
+  undo_offsets_.clear();
+  first_offsets_.clear();
+}
+
+void LogRecovery::UndoRecord(LogRecord *log_record) {
+  auto type = log_record->log_record_type_;
+  const RID &rid = type == LogRecordType::INSERT   ? log_record->insert_rid_
+                   : type == LogRecordType::UPDATE ? log_record->update_rid_
+                                                   : log_record->delete_rid_;
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  BUSTUB_ENSURE(guard.IsValid(), "no frame left to undo a page in");
+  auto page = guard.AsMut<TablePage>();
+  switch (type) {
+    case LogRecordType::INSERT:
+    case LogRecordType::ROLLBACKDELETE:
+      page->UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, true}, rid);
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+      page->UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, false}, rid);
+      break;
+    case LogRecordType::UPDATE:
+      page->UpdateTupleInPlaceUnsafe(page->GetTupleMeta(rid), log_record->old_tuple_, rid);
+      break;
+    default:
+      break;
+  }
+  num_undone_++;
+}
+
+}  // namespace bustub
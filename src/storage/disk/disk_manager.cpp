@@ -10,9 +10,16 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
 #include <cstring>
+#include <filesystem>
 #include <iostream>
 #include <mutex>  // NOLINT
 #include <string>
@@ -20,108 +27,476 @@
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/macros.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 static char *buffer_used;
 
+/** Write size bytes at offset, @return false on an I/O error */
+static auto PWriteAll(int fd, const char *data, size_t size, size_t offset) -> bool {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t written = pwrite(fd, data + done, size - done, static_cast<off_t>(offset + done));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    done += written;
+  }
+  return true;
+}
+
+/** Make the creation, renaming and removal of files in the directory of file_name durable */
+static void SyncDirectory(const std::string &file_name) {
+  std::filesystem::path dir = std::filesystem::path(file_name).parent_path();
+  int fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0 || fsync(fd) != 0) {
+    LOG_DEBUG("I/O error while syncing directory");
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, DiskIOMode io_mode) : file_name_(db_file), io_mode_(io_mode) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  alloc_map_name_ = file_name_.substr(0, n) + ".alloc";
+  warmup_name_ = file_name_.substr(0, n) + ".warm";
+  master_name_ = file_name_.substr(0, n) + ".master";
 
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  auto open_db_file = [this, &db_file](int flags) {
+    int fd = open(db_file.c_str(), flags | (io_mode_ == DiskIOMode::Direct ? O_DIRECT : 0), 0644);
+    // file systems like tmpfs refuse O_DIRECT
+    if (fd < 0 && errno == EINVAL && io_mode_ == DiskIOMode::Direct) {
+      LOG_WARN("O_DIRECT is not supported for the db file, falling back to buffered I/O");
+      io_mode_ = DiskIOMode::Buffered;
+      fd = open(db_file.c_str(), flags, 0644);
+    }
+    return fd;
+  };
+  db_fd_ = open_db_file(O_RDWR);
   // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
+  bool new_db_file = db_fd_ < 0;
+  if (new_db_file) {
     // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
+    db_fd_ = open_db_file(O_RDWR | O_CREAT | O_TRUNC);
+    if (db_fd_ < 0) {
+      throw Exception("can't open db file");
     }
   }
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) != 0) {
+    throw Exception("can't open db file");
+  }
+  db_file_size_ = stat_buf.st_size;
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  // an allocation map, warm-up list or master record left behind by a removed db file describes pages that no longer
+  // exist
+  if (!new_db_file) {
+    alloc_map_io_.open(alloc_map_name_, std::ios::binary | std::ios::in | std::ios::out);
+  } else {
+    remove(warmup_name_.c_str());
+    remove(master_name_.c_str());
+  }
+
+  // the log segments are "<db>.log.<segment>", the ones of a removed db file belong to a log that no longer applies
+  std::filesystem::path log_path(log_name_);
+  std::string prefix = log_path.filename().string() + ".";
+  std::error_code ec;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(log_path.has_parent_path() ? log_path.parent_path() : ".", ec)) {
+    std::string name = entry.path().filename().string();
+    if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+        name.find_first_not_of("0123456789", prefix.size()) != std::string::npos) {
+      continue;
+    }
+    if (new_db_file) {
+      std::filesystem::remove(entry.path(), ec);
+      continue;
+    }
+    int fd = open(entry.path().c_str(), O_RDWR);
+    if (fd < 0) {
+      throw Exception("can't open dblog file");
+    }
+    log_segments_[std::stoull(name.substr(prefix.size()))] = fd;
+  }
+  // where the log really ends is only known after recovery, which truncates it there
+  log_end_ = log_segments_.empty() ? 0 : (log_segments_.rbegin()->first + 1) * LOG_SEGMENT_SIZE;
+  log_recovered_ = log_segments_.empty();
   // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
+  if (!alloc_map_io_.is_open()) {
+    alloc_map_io_.clear();
     // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+    alloc_map_io_.open(alloc_map_name_, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
+    if (!alloc_map_io_.is_open()) {
+      throw Exception("can't open allocation map file");
     }
   }
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() {
+  // the streams close themselves, the descriptor of a disk manager that was not shut down has to be closed here
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+  for (const auto &[segment, fd] : log_segments_) {
+    close(fd);
+  }
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
+  SyncPages();
   {
     std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+    alloc_map_io_.close();
+    if (db_fd_ >= 0) {
+      close(db_fd_);
+      db_fd_ = -1;
+    }
+  }
+  std::scoped_lock scoped_log_io_latch(log_io_latch_);
+  for (const auto &[segment, fd] : log_segments_) {
+    close(fd);
   }
-  log_io_.close();
+  log_segments_.clear();
 }
 
 /**
  * Write the contents of the specified page into disk file
+ * Positional, so writes and reads of other pages are not serialized with it; durable only after SyncPages()
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
-  // set write cursor to offset
+  if (!IsAligned(page_data)) {
+    alignas(DIRECT_IO_ALIGNMENT) static thread_local char aligned_data[BUSTUB_PAGE_SIZE];
+    memcpy(aligned_data, page_data, BUSTUB_PAGE_SIZE);
+    page_data = aligned_data;
+  }
+  off_t offset = static_cast<off_t>(page_id) * BUSTUB_PAGE_SIZE;
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, BUSTUB_PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+  size_t done = 0;
+  while (done < BUSTUB_PAGE_SIZE) {
+    ssize_t written = pwrite(db_fd_, page_data + done, BUSTUB_PAGE_SIZE - done, offset + done);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // check for I/O error
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    done += written;
+  }
+  GrowFileSize(offset + BUSTUB_PAGE_SIZE);
+}
+
+/**
+ * Write pages with consecutive ids into disk file, IOV_MAX pages per pwritev call
+ */
+void DiskManager::WritePages(page_id_t first_page_id, const std::vector<const char *> &pages_data) {
+  if (db_fd_ < 0 || !std::all_of(pages_data.begin(), pages_data.end(), [this](auto data) { return IsAligned(data); })) {
+    // disk managers without a db file only know how to write single pages, and O_DIRECT needs aligned buffers
+    for (size_t i = 0; i < pages_data.size(); i++) {
+      WritePage(first_page_id + static_cast<page_id_t>(i), pages_data[i]);
+    }
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+
+  num_writes_ += pages_data.size();
+  std::vector<iovec> iov(pages_data.size());
+  for (size_t i = 0; i < pages_data.size(); i++) {
+    iov[i].iov_base = const_cast<char *>(pages_data[i]);  // NOLINT
+    iov[i].iov_len = BUSTUB_PAGE_SIZE;
+  }
+
+  size_t next = 0;
+  off_t offset = static_cast<off_t>(first_page_id) * BUSTUB_PAGE_SIZE;
+  GrowFileSize(offset + pages_data.size() * BUSTUB_PAGE_SIZE);
+  while (next < iov.size()) {
+    int count = static_cast<int>(std::min<size_t>(iov.size() - next, IOV_MAX));
+    ssize_t written = pwritev(db_fd_, &iov[next], count, offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    offset += written;
+    // skip the pages written in full and resume a short write in the middle of a page
+    while (written > 0) {
+      auto done = std::min<size_t>(written, iov[next].iov_len);
+      iov[next].iov_base = static_cast<char *>(iov[next].iov_base) + done;
+      iov[next].iov_len -= done;
+      written -= done;
+      if (iov[next].iov_len == 0) {
+        next++;
+      }
+    }
+  }
+}
+
+/**
+ * Sync the db file to disk
+ */
+void DiskManager::SyncPages() {
+  if (db_fd_ < 0) {
+    return;
+  }
+  if (fsync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+  }
 }
 
 /**
  * Read the contents of the specified page into the given memory area
+ * Positional, so reads and writes of other pages proceed in parallel
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * BUSTUB_PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (!IsAligned(page_data)) {
+    alignas(DIRECT_IO_ALIGNMENT) static thread_local char aligned_data[BUSTUB_PAGE_SIZE];
+    DiskManager::ReadPage(page_id, aligned_data);
+    memcpy(page_data, aligned_data, BUSTUB_PAGE_SIZE);
+    return;
+  }
+  off_t offset = static_cast<off_t>(page_id) * BUSTUB_PAGE_SIZE;
+  // check if read beyond file length, the size is tracked in memory instead of asking the file system every time
+  if (offset > static_cast<off_t>(db_file_size_.load(std::memory_order_acquire))) {
     LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, BUSTUB_PAGE_SIZE);
-    if (db_io_.bad()) {
+    memset(page_data, 0, BUSTUB_PAGE_SIZE);
+    return;
+  }
+  size_t done = 0;
+  while (done < BUSTUB_PAGE_SIZE) {
+    ssize_t read_count = pread(db_fd_, page_data + done, BUSTUB_PAGE_SIZE - done, offset + done);
+    if (read_count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
       LOG_DEBUG("I/O error while reading");
       return;
     }
-    // if file ends before reading BUSTUB_PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < BUSTUB_PAGE_SIZE) {
+    if (read_count == 0) {
+      // if file ends before reading BUSTUB_PAGE_SIZE
       LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+      memset(page_data + done, 0, BUSTUB_PAGE_SIZE - done);
+      return;
+    }
+    done += read_count;
+  }
+}
+
+/**
+ * Read pages with consecutive ids from disk file, IOV_MAX pages per preadv call
+ */
+void DiskManager::ReadPages(page_id_t first_page_id, const std::vector<char *> &pages_data) {
+  if (db_fd_ < 0 || !std::all_of(pages_data.begin(), pages_data.end(), [this](auto data) { return IsAligned(data); })) {
+    // disk managers without a db file only know how to read single pages, and O_DIRECT needs aligned buffers
+    for (size_t i = 0; i < pages_data.size(); i++) {
+      ReadPage(first_page_id + static_cast<page_id_t>(i), pages_data[i]);
+    }
+    return;
+  }
+
+  std::vector<iovec> iov(pages_data.size());
+  for (size_t i = 0; i < pages_data.size(); i++) {
+    iov[i].iov_base = pages_data[i];
+    iov[i].iov_len = BUSTUB_PAGE_SIZE;
+  }
+
+  size_t next = 0;
+  off_t offset = static_cast<off_t>(first_page_id) * BUSTUB_PAGE_SIZE;
+  while (next < iov.size()) {
+    int count = static_cast<int>(std::min<size_t>(iov.size() - next, IOV_MAX));
+    ssize_t read_count = preadv(db_fd_, &iov[next], count, offset);
+    if (read_count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error while reading");
+      return;
+    }
+    if (read_count == 0) {
+      // the file ends before the last page, the rest reads as zeros
+      for (; next < iov.size(); next++) {
+        memset(iov[next].iov_base, 0, iov[next].iov_len);
+      }
+      return;
+    }
+    offset += read_count;
+    // skip the pages read in full and resume a short read in the middle of a page
+    while (read_count > 0) {
+      auto done = std::min<size_t>(read_count, iov[next].iov_len);
+      iov[next].iov_base = static_cast<char *>(iov[next].iov_base) + done;
+      iov[next].iov_len -= done;
+      read_count -= done;
+      if (iov[next].iov_len == 0) {
+        next++;
+      }
     }
   }
 }
 
+/**
+ * Write a page of the page allocation map into the allocation map file
+ */
+void DiskManager::WriteAllocationMapPage(size_t map_page_idx, const char *page_data) {
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  alloc_map_io_.seekp(map_page_idx * BUSTUB_PAGE_SIZE);
+  alloc_map_io_.write(page_data, BUSTUB_PAGE_SIZE);
+  if (alloc_map_io_.bad()) {
+    LOG_DEBUG("I/O error while writing allocation map");
+    return;
+  }
+  alloc_map_io_.flush();
+}
+
+/**
+ * Read a page of the page allocation map from the allocation map file
+ * @return: false means the allocation map is shorter
+ */
+auto DiskManager::ReadAllocationMapPage(size_t map_page_idx, char *page_data) -> bool {
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  size_t offset = map_page_idx * BUSTUB_PAGE_SIZE;
+  int file_size = GetFileSize(alloc_map_name_);
+  if (file_size < 0 || offset >= static_cast<size_t>(file_size)) {
+    return false;
+  }
+
+  alloc_map_io_.seekp(offset);
+  alloc_map_io_.read(page_data, BUSTUB_PAGE_SIZE);
+  if (alloc_map_io_.bad()) {
+    LOG_DEBUG("I/O error while reading allocation map");
+    return false;
+  }
+  int read_count = alloc_map_io_.gcount();
+  if (read_count < BUSTUB_PAGE_SIZE) {
+    alloc_map_io_.clear();
+    memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+  }
+  return true;
+}
+
+/**
+ * Write the warm-up list into a temporary file and rename it over the previous list
+ * Format: the number of page ids, followed by the page ids
+ */
+void DiskManager::WriteWarmupList(const std::vector<page_id_t> &page_ids) {
+  if (warmup_name_.empty()) {
+    return;
+  }
+  std::string tmp_name = warmup_name_ + ".tmp";
+  std::ofstream warmup_io(tmp_name, std::ios::binary | std::ios::trunc | std::ios::out);
+  uint64_t count = page_ids.size();
+  warmup_io.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  warmup_io.write(reinterpret_cast<const char *>(page_ids.data()),
+                  static_cast<std::streamsize>(page_ids.size() * sizeof(page_id_t)));
+  warmup_io.close();
+  if (warmup_io.fail()) {
+    LOG_DEBUG("I/O error while writing warm-up list");
+    remove(tmp_name.c_str());
+    return;
+  }
+  if (rename(tmp_name.c_str(), warmup_name_.c_str()) != 0) {
+    LOG_DEBUG("cannot replace warm-up list");
+    remove(tmp_name.c_str());
+  }
+}
+
+/**
+ * Read the warm-up list file
+ * @return: no page ids if the file is missing or truncated
+ */
+auto DiskManager::ReadWarmupList() -> std::vector<page_id_t> {
+  std::vector<page_id_t> page_ids;
+  if (warmup_name_.empty()) {
+    return page_ids;
+  }
+  std::ifstream warmup_io(warmup_name_, std::ios::binary | std::ios::in);
+  uint64_t count = 0;
+  if (!warmup_io.read(reinterpret_cast<char *>(&count), sizeof(count))) {
+    return page_ids;
+  }
+  int file_size = GetFileSize(warmup_name_);
+  size_t ids_size = file_size < 0 ? 0 : static_cast<size_t>(file_size) - sizeof(count);
+  if (file_size < 0 || ids_size % sizeof(page_id_t) != 0 || count != ids_size / sizeof(page_id_t)) {
+    LOG_DEBUG("ignoring malformed warm-up list");
+    return page_ids;
+  }
+  page_ids.resize(count);
+  if (!warmup_io.read(reinterpret_cast<char *>(page_ids.data()),
+                      static_cast<std::streamsize>(count * sizeof(page_id_t)))) {
+    page_ids.clear();
+  }
+  return page_ids;
+}
+
+/**
+ * Write the master record into a temporary file, sync it and rename it over the previous record
+ * Format: the log file offset
+ */
+void DiskManager::WriteMasterRecord(size_t offset) {
+  if (master_name_.empty()) {
+    return;
+  }
+  std::string tmp_name = master_name_ + ".tmp";
+  int fd = open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_DEBUG("cannot create master record");
+    return;
+  }
+  uint64_t record = offset;
+  bool written = write(fd, &record, sizeof(record)) == static_cast<ssize_t>(sizeof(record)) && fdatasync(fd) == 0;
+  close(fd);
+  if (!written) {
+    LOG_DEBUG("I/O error while writing master record");
+    remove(tmp_name.c_str());
+    return;
+  }
+  if (rename(tmp_name.c_str(), master_name_.c_str()) != 0) {
+    LOG_DEBUG("cannot replace master record");
+    remove(tmp_name.c_str());
+  }
+}
+
+/**
+ * Read the master record file
+ * @return: false if the file is missing or truncated
+ */
+auto DiskManager::ReadMasterRecord(size_t *offset) -> bool {
+  if (master_name_.empty()) {
+    return false;
+  }
+  int fd = open(master_name_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  uint64_t record;
+  bool read_ok = read(fd, &record, sizeof(record)) == static_cast<ssize_t>(sizeof(record));
+  close(fd);
+  if (read_ok) {
+    *offset = record;
+  }
+  return read_ok;
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
@@ -134,6 +509,8 @@ void DiskManager::WriteLog(char *log_data, int size) {
   if (size == 0) {  // no effect on num_flushes_ if log buffer is empty
     return;
   }
+  // appending at the end of the last segment would put the records behind zeros that recovery stops at
+  BUSTUB_ENSURE(log_recovered_, "the log must be recovered before it is appended to");
 
   flush_log_ = true;
 
@@ -143,16 +520,28 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
 
   num_flushes_ += 1;
-  // sequence write
-  log_io_.write(log_data, size);
-
-  // check for I/O error
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while writing log");
-    return;
+  // sequence write, split at the ends of the segments
+  size_t offset = log_end_.load();
+  size_t done = 0;
+  while (done < static_cast<size_t>(size)) {
+    size_t segment = (offset + done) / LOG_SEGMENT_SIZE;
+    size_t segment_offset = (offset + done) % LOG_SEGMENT_SIZE;
+    size_t count = std::min<size_t>(size - done, LOG_SEGMENT_SIZE - segment_offset);
+    int fd;
+    {
+      // recycling only touches segments below the last checkpoint, never the ones written here
+      std::scoped_lock scoped_log_io_latch(log_io_latch_);
+      fd = GetLogSegment(segment);
+    }
+    BUSTUB_ENSURE(fd >= 0, "log segment was not prepared, see PrepareLogSegments()");
+    // the log records count as persistent once this returns, so they have to be on disk, not in the page cache
+    if (!PWriteAll(fd, log_data + done, count, segment_offset) || fdatasync(fd) != 0) {
+      LOG_DEBUG("I/O error while writing log");
+      return;
+    }
+    done += count;
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
+  log_end_ = offset + size;
   flush_log_ = false;
 }
 
@@ -161,27 +550,158 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
-  if (offset >= GetFileSize(log_name_)) {
+auto DiskManager::ReadLog(char *log_data, int size, size_t offset) -> bool {
+  size_t end = GetLogFileSize();
+  if (offset >= end) {
     // LOG_DEBUG("end of log file");
-    // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
+  // past the end of the log, the segments hold zeros or the log from before they were recycled
+  size_t valid = std::min<size_t>(size, end - offset);
+  memset(log_data + valid, 0, size - valid);
+  std::scoped_lock scoped_log_io_latch(log_io_latch_);
+  size_t read_count = 0;
+  while (read_count < valid) {
+    size_t segment = (offset + read_count) / LOG_SEGMENT_SIZE;
+    size_t segment_offset = (offset + read_count) % LOG_SEGMENT_SIZE;
+    size_t count = std::min<size_t>(valid - read_count, LOG_SEGMENT_SIZE - segment_offset);
+    int fd = GetLogSegment(segment);
+    if (fd < 0) {
+      // recycled, or never written
+      return false;
+    }
+    size_t done = 0;
+    while (done < count) {
+      ssize_t bytes = pread(fd, log_data + read_count + done, count - done, static_cast<off_t>(segment_offset + done));
+      if (bytes < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        LOG_DEBUG("I/O error while reading log");
+        return false;
+      }
+      if (bytes == 0) {
+        break;
+      }
+      done += bytes;
+    }
+    // if the segment ends before reading "count", e.g. because a crash interrupted its creation
+    if (done < count) {
+      memset(log_data + read_count + done, 0, count - done);
+    }
+    read_count += count;
+  }
+  return true;
+}
 
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while reading log");
-    return false;
+auto DiskManager::GetLogFileSize() -> size_t { return log_end_; }
+
+void DiskManager::TruncateLog(size_t size) {
+  // Segments keep their size, so the bytes after the new end are zeroed instead. They hold at most the rest of one
+  // log buffer from the write a crash interrupted, everything further is from before a segment was recycled and does
+  // not continue the lsns of the log.
+  log_end_ = size;
+  log_recovered_ = true;
+  std::vector<char> zeros(LOG_BUFFER_SIZE, 0);
+  std::scoped_lock scoped_log_io_latch(log_io_latch_);
+  size_t done = 0;
+  while (done < zeros.size()) {
+    size_t segment = (size + done) / LOG_SEGMENT_SIZE;
+    size_t segment_offset = (size + done) % LOG_SEGMENT_SIZE;
+    size_t count = std::min<size_t>(zeros.size() - done, LOG_SEGMENT_SIZE - segment_offset);
+    int fd = GetLogSegment(segment);
+    if (fd >= 0 && (!PWriteAll(fd, zeros.data(), count, segment_offset) || fdatasync(fd) != 0)) {
+      LOG_DEBUG("I/O error while truncating log");
+    }
+    done += count;
+  }
+}
+
+void DiskManager::PrepareLogSegments() {
+  // the segments to create are only known once the end of the log is
+  if (log_name_.empty() || !log_recovered_) {
+    return;
+  }
+  std::scoped_lock scoped_log_create_latch(log_create_latch_);
+  size_t first_segment = log_end_ / LOG_SEGMENT_SIZE;
+  for (size_t segment = first_segment; segment <= first_segment + 1; segment++) {
+    {
+      std::scoped_lock scoped_log_io_latch(log_io_latch_);
+      if (GetLogSegment(segment) >= 0) {
+        continue;
+      }
+    }
+    // written without log_io_latch_, so that log writes to the segments that exist go on meanwhile
+    int fd = CreateLogSegment(segment);
+    if (fd < 0) {
+      LOG_DEBUG("cannot create log segment");
+      return;
+    }
+    std::scoped_lock scoped_log_io_latch(log_io_latch_);
+    log_segments_[segment] = fd;
   }
-  // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
-  if (read_count < size) {
-    log_io_.clear();
-    memset(log_data + read_count, 0, size - read_count);
+}
+
+void DiskManager::RecycleLogSegments(size_t offset) {
+  // a segment being created must not be renamed over
+  std::scoped_lock scoped_latches(log_create_latch_, log_io_latch_);
+  size_t end = log_end_;
+  // the segments that start at or after the end of the log are spares, the next spare goes after the last one
+  size_t spares = 0;
+  size_t next_segment = (end + LOG_SEGMENT_SIZE - 1) / LOG_SEGMENT_SIZE;
+  for (const auto &[segment, fd] : log_segments_) {
+    if (segment * LOG_SEGMENT_SIZE >= end) {
+      spares++;
+    }
+    next_segment = std::max(next_segment, segment + 1);
   }
 
-  return true;
+  bool changed = false;
+  while (!log_segments_.empty() && (log_segments_.begin()->first + 1) * LOG_SEGMENT_SIZE <= offset) {
+    auto [segment, fd] = *log_segments_.begin();
+    log_segments_.erase(log_segments_.begin());
+    changed = true;
+    // renaming a segment reuses its blocks, the log writes to it need no allocation and no zeroing
+    if (spares < LOG_SEGMENT_SPARES &&
+        rename(LogSegmentName(segment).c_str(), LogSegmentName(next_segment).c_str()) == 0) {
+      log_segments_[next_segment++] = fd;
+      spares++;
+      continue;
+    }
+    close(fd);
+    if (remove(LogSegmentName(segment).c_str()) != 0) {
+      LOG_DEBUG("cannot remove log segment");
+    }
+  }
+  if (changed) {
+    SyncDirectory(log_name_);
+  }
+}
+
+auto DiskManager::GetLogSegment(size_t segment) -> int {
+  auto it = log_segments_.find(segment);
+  return it == log_segments_.end() ? -1 : it->second;
+}
+
+auto DiskManager::CreateLogSegment(size_t segment) -> int {
+  // written in full once, so that log writes neither allocate blocks nor change the size of the file
+  std::string name = LogSegmentName(segment);
+  int fd = open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return -1;
+  }
+  std::vector<char> zeros(REDO_READ_SIZE, 0);
+  bool written = true;
+  for (size_t done = 0; written && done < LOG_SEGMENT_SIZE; done += zeros.size()) {
+    written = PWriteAll(fd, zeros.data(), std::min<size_t>(zeros.size(), LOG_SEGMENT_SIZE - done), done);
+  }
+  if (!written || fdatasync(fd) != 0) {
+    close(fd);
+    remove(name.c_str());
+    return -1;
+  }
+  SyncDirectory(name);
+  return fd;
 }
 
 /**
@@ -199,6 +719,15 @@ auto DiskManager::GetNumWrites() const -> int { return num_writes_; }
  */
 auto DiskManager::GetFlushState() const -> bool { return flush_log_; }
 
+/**
+ * Private helper function to raise the tracked db file size to at least size
+ */
+void DiskManager::GrowFileSize(size_t size) {
+  size_t file_size = db_file_size_.load(std::memory_order_relaxed);
+  while (file_size < size && !db_file_size_.compare_exchange_weak(file_size, size, std::memory_order_release)) {
+  }
+}
+
 /**
  * Private helper function to get disk file size
  */
@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.cpp
+//
+// Identification: src/storage/disk/disk_scheduler.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace bustub {
+
+DiskScheduler::DiskScheduler(DiskManager *disk_manager, size_t num_workers) : disk_manager_(disk_manager) {
+  for (size_t i = 0; i < std::max<size_t>(num_workers, 1); ++i) {
+    workers_.emplace_back(&DiskScheduler::RunWorker, this);
+  }
+}
+
+DiskScheduler::~DiskScheduler() {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    enable_ = false;
+  }
+  cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void DiskScheduler::Schedule(DiskRequest request) {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    queue_.push_back(std::move(request));
+  }
+  cv_.notify_one();
+}
+
+void DiskScheduler::Schedule(std::vector<DiskRequest> requests) {
+  if (requests.empty()) {
+    return;
+  }
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (auto &request : requests) {
+      queue_.push_back(std::move(request));
+    }
+  }
+  cv_.notify_all();
+}
+
+auto DiskScheduler::ScheduleRead(page_id_t page_id, char *data) -> std::future<bool> {
+  auto promise = CreatePromise();
+  auto future = promise.get_future();
+  Schedule({false, data, page_id, std::move(promise)});
+  return future;
+}
+
+auto DiskScheduler::ScheduleWrite(page_id_t page_id, const char *data) -> std::future<bool> {
+  auto promise = CreatePromise();
+  auto future = promise.get_future();
+  Schedule({true, const_cast<char *>(data), page_id, std::move(promise)});  // NOLINT
+  return future;
+}
+
+void DiskScheduler::RunWorker() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    cv_.wait(lock, [this] { return !enable_ || !queue_.empty(); });
+    // requests queued before the shutdown are still carried out, their callers wait for them
+    if (queue_.empty()) {
+      return;
+    }
+
+    auto batch = TakeBatch();
+    lock.unlock();
+    ExecuteBatch(&batch);
+    lock.lock();
+  }
+}
+
+auto DiskScheduler::TakeBatch() -> std::vector<DiskRequest> {
+  std::vector<DiskRequest> batch;
+  batch.push_back(std::move(queue_.front()));
+  queue_.pop_front();
+  bool is_write = batch.front().is_write_;
+  page_id_t first_page_id = batch.front().page_id_;
+  page_id_t last_page_id = first_page_id;
+
+  // a request found may make one skipped before adjacent, so look again until the run stops growing
+  bool grown = true;
+  while (grown && batch.size() < static_cast<size_t>(DISK_SCHEDULER_BATCH)) {
+    grown = false;
+    for (auto it = queue_.begin(); it != queue_.end() && batch.size() < static_cast<size_t>(DISK_SCHEDULER_BATCH);) {
+      if (it->is_write_ != is_write || (it->page_id_ != last_page_id + 1 && it->page_id_ != first_page_id - 1)) {
+        ++it;
+        continue;
+      }
+      first_page_id = std::min(first_page_id, it->page_id_);
+      last_page_id = std::max(last_page_id, it->page_id_);
+      batch.push_back(std::move(*it));
+      it = queue_.erase(it);
+      grown = true;
+    }
+  }
+
+  std::sort(batch.begin(), batch.end(),
+            [](const DiskRequest &a, const DiskRequest &b) { return a.page_id_ < b.page_id_; });
+  return batch;
+}
+
+void DiskScheduler::ExecuteBatch(std::vector<DiskRequest> *batch) {
+  DiskRequest &first = batch->front();
+  if (batch->size() == 1) {
+    if (first.is_write_) {
+      disk_manager_->WritePage(first.page_id_, first.data_);
+    } else {
+      disk_manager_->ReadPage(first.page_id_, first.data_);
+    }
+  } else if (first.is_write_) {
+    std::vector<const char *> pages_data;
+    for (const auto &request : *batch) {
+      pages_data.push_back(request.data_);
+    }
+    disk_manager_->WritePages(first.page_id_, pages_data);
+  } else {
+    std::vector<char *> pages_data;
+    for (const auto &request : *batch) {
+      pages_data.push_back(request.data_);
+    }
+    disk_manager_->ReadPages(first.page_id_, pages_data);
+  }
+
+  for (auto &request : *batch) {
+    request.callback_.set_value(true);
+  }
+}
+
+}  // namespace bustub
@@ -54,39 +54,113 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *txn) -> bool {
-  // Declaration of context instance.
-  ReadPageGuard head_guard = bpm_->FetchPageRead(header_page_id_);
-  const auto *root_page = head_guard.As<BPlusTreeHeaderPage>();
-
-  if (root_page->root_page_id_ == INVALID_PAGE_ID) {
-    return false;
-  }
   if (DEBUG) {
     std::cout << "GetValue " << key << std::endl;
   }
-  Context ctx;
-  // ctx.root_page_id_ = root_page_id;
-  ReadPageGuard guard = bpm_->FetchPageRead(root_page->root_page_id_);
-  // ctx.read_set_.push_back(guard);
+  page_id_t leaf_page_id;
+  ReadPageGuard guard = FindLeafRead(&key, &leaf_page_id, nullptr);
+  if (!guard.IsValid()) {
+    return false;
+  }
 
-  const auto *head = guard.As<BPlusTreePage>();
-  if (head->GetSize() == 0) {
+  auto *leaf_page = guard.As<LeafPage>();
+  if (leaf_page->GetSize() == 0) {
     return false;
   }
 
-  page_id_t next_page_id = INVALID_PAGE_ID;
-  while (!head->IsLeafPage()) {
+  return FindValueType(key, leaf_page, 0, leaf_page->GetSize() - 1, result);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafRead(const KeyType *key, page_id_t *leaf_page_id, std::vector<page_id_t> *upcoming_leaves)
+    -> ReadPageGuard {
+  ReadPageGuard leaf;
+  for (int attempt = 0; attempt < OPTIMISTIC_READ_RETRIES; attempt++) {
+    if (TryFindLeafOptimistic(key, leaf_page_id, upcoming_leaves, &leaf)) {
+      return leaf;
+    }
+  }
+
+  // too much write traffic on the way down, latch couple instead
+  ReadPageGuard head_guard = bpm_->FetchPageRead(header_page_id_);
+  page_id_t page_id = head_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    return leaf;
+  }
+
+  ReadPageGuard guard = bpm_->FetchPageRead(page_id);
+  head_guard.Drop();
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
     auto *inner_page = guard.As<InternalPage>();
-    FindNextPage(key, inner_page, 0, head->GetSize() - 1, &next_page_id);
-    guard = bpm_->FetchPageRead(next_page_id);
-    // ctx.read_set_.push_back(guard);
+    int child_index = 0;
+    if (key != nullptr) {
+      child_index = FindNextPage(*key, inner_page, 0, inner_page->GetSize() - 1, &page_id);
+    } else {
+      page_id = inner_page->ValueAt(0);
+    }
+    if (upcoming_leaves != nullptr) {
+      CollectSiblings(inner_page, child_index, upcoming_leaves);
+    }
+    guard = bpm_->FetchPageRead(page_id);
+  }
 
-    head = guard.As<BPlusTreePage>();
+  *leaf_page_id = page_id;
+  return guard;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::TryFindLeafOptimistic(const KeyType *key, page_id_t *leaf_page_id,
+                                           std::vector<page_id_t> *upcoming_leaves, ReadPageGuard *leaf) -> bool {
+  OptimisticReadGuard parent = bpm_->FetchPageOptimistic(header_page_id_);
+  page_id_t page_id = parent.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (!parent.Validate()) {
+    return false;
+  }
+  if (page_id == INVALID_PAGE_ID) {
+    return true;
   }
 
-  auto *leaf_page = guard.As<LeafPage>();
+  while (true) {
+    OptimisticReadGuard guard = bpm_->FetchPageOptimistic(page_id);
+    // page_id is only a page of this tree as long as the parent still points to it
+    if (!guard.IsValid() || !parent.Validate()) {
+      return false;
+    }
+
+    if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+      *leaf = guard.UpgradeRead();
+      // a writer may have split or merged the leaf while the latch was awaited
+      if (!parent.Validate()) {
+        leaf->Drop();
+        return false;
+      }
+      *leaf_page_id = page_id;
+      return true;
+    }
 
-  return FindValueType(key, leaf_page, 0, head->GetSize() - 1, result);
+    // the page may be torn by a writer, keep the size in bounds until it is validated
+    auto *inner_page = guard.As<InternalPage>();
+    int size = inner_page->GetSize();
+    if (size <= 0 || size > internal_max_size_) {
+      return false;
+    }
+    int child_index = 0;
+    page_id_t child_page_id;
+    if (key != nullptr) {
+      child_index = FindNextPage(*key, inner_page, 0, size - 1, &child_page_id);
+    } else {
+      child_page_id = inner_page->ValueAt(0);
+    }
+    if (upcoming_leaves != nullptr) {
+      CollectSiblings(inner_page, child_index, upcoming_leaves);
+    }
+    if (!guard.Validate()) {
+      return false;
+    }
+
+    parent = std::move(guard);
+    page_id = child_page_id;
+  }
 }
 
 // @Return index of value
@@ -118,6 +192,15 @@ auto BPLUSTREE_TYPE::FindNextPage(const KeyType &key, const InternalPage *inner_
   return mid + 1;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CollectSiblings(const InternalPage *inner_page, int child_index,
+                                     std::vector<page_id_t> *siblings) {
+  siblings->clear();
+  for (int i = child_index + 1; i <= inner_page->GetSize(); i++) {
+    siblings->push_back(inner_page->ValueAt(i));
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::FindKeyIndex(const KeyType &key, const LeafPage *leaf_page, int left, int right, int *index)
     -> bool {
@@ -200,7 +283,7 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
   if (head_page->root_page_id_ == INVALID_PAGE_ID) {  // empty tree
     // start new tree, update root page id
     page_id_t root_page_id = INVALID_PAGE_ID;
-    BasicPageGuard root_guard = bpm_->NewPageGuarded(&root_page_id);
+    BasicPageGuard root_guard = bpm_->NewPageGuarded(&root_page_id, &extent_);
     if (!root_guard.IsValid()) {
       return false;
     }
@@ -274,7 +357,7 @@ auto BPLUSTREE_TYPE::TrySplitFullPage(page_id_t root_page_id, WritePageGuard *gu
   if (context.IsRootPage(root_page_id)) {  // root page need to split
     BUSTUB_ASSERT(context.header_page_ != std::nullopt, "TrySplitFullPage context.header_page_ should not be nullopt");
     page_id_t new_root_id = INVALID_PAGE_ID;
-    BasicPageGuard new_root_guard = bpm_->NewPageGuarded(&new_root_id);
+    BasicPageGuard new_root_guard = bpm_->NewPageGuarded(&new_root_id, &extent_);
     if (new_root_guard.IsValid()) {
       page_id_t right_page_id = INVALID_PAGE_ID;
       KeyType first_key{};
@@ -313,7 +396,7 @@ auto BPLUSTREE_TYPE::TrySplitFullPage(page_id_t root_page_id, WritePageGuard *gu
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::SplitRightSidePage(WritePageGuard *full_page_guard, page_id_t *new_page_id, KeyType *key) -> bool {
-  BasicPageGuard new_guard = bpm_->NewPageGuarded(new_page_id);
+  BasicPageGuard new_guard = bpm_->NewPageGuarded(new_page_id, &extent_);
   if (!new_guard.IsValid()) {
     return false;
   }
@@ -545,27 +628,15 @@ auto BPLUSTREE_TYPE::Redistribute(WritePageGuard *guard, WritePageGuard *bro_gua
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
-  ReadPageGuard head_guard = bpm_->FetchPageRead(header_page_id_);
-  const auto *root_page = head_guard.As<BPlusTreeHeaderPage>();
-
-  if (root_page->root_page_id_ == INVALID_PAGE_ID) {  // non-initial tree
+  // the right siblings of the leaf under its parent, the iterator reads them ahead
+  std::vector<page_id_t> upcoming_leaves;
+  page_id_t left_most_page_id;
+  ReadPageGuard left_most_guard = FindLeafRead(nullptr, &left_most_page_id, &upcoming_leaves);
+  if (!left_most_guard.IsValid() || left_most_guard.As<BPlusTreePage>()->GetSize() == 0) {  // empty tree
     return End();
   }
 
-  ReadPageGuard left_most_guard = bpm_->FetchPageRead(root_page->root_page_id_);
-  page_id_t left_most_page_id = root_page->root_page_id_;
-  if (left_most_guard.As<BPlusTreePage>()->GetSize() == 0) {  // empty tree
-    return End();
-  }
-
-  while (!left_most_guard.As<BPlusTreePage>()->IsLeafPage()) {
-    auto *inner_page = left_most_guard.As<InternalPage>();
-
-    left_most_page_id = inner_page->ValueAt(0);
-    left_most_guard = bpm_->FetchPageRead(left_most_page_id);
-  }
-
-  return INDEXITERATOR_TYPE(bpm_, left_most_page_id, std::move(left_most_guard));
+  return INDEXITERATOR_TYPE(bpm_, left_most_page_id, std::move(left_most_guard), 0, std::move(upcoming_leaves));
 }
 
 /*
@@ -575,32 +646,18 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
-  ReadPageGuard head_guard = bpm_->FetchPageRead(header_page_id_);
-  const auto *root_page = head_guard.As<BPlusTreeHeaderPage>();
-
-  if (root_page->root_page_id_ == INVALID_PAGE_ID) {
-    return End();
-  }
-
-  ReadPageGuard guard = bpm_->FetchPageRead(root_page->root_page_id_);
-  page_id_t next_page_id = root_page->root_page_id_;
-  const auto *head = guard.As<BPlusTreePage>();
-  if (head->GetSize() == 0) {
+  // the right siblings of the leaf under its parent, the iterator reads them ahead
+  std::vector<page_id_t> upcoming_leaves;
+  page_id_t leaf_page_id;
+  ReadPageGuard guard = FindLeafRead(&key, &leaf_page_id, &upcoming_leaves);
+  if (!guard.IsValid() || guard.As<BPlusTreePage>()->GetSize() == 0) {
     return End();
   }
 
-  while (!head->IsLeafPage()) {
-    auto *inner_page = guard.As<InternalPage>();
-    FindNextPage(key, inner_page, 0, head->GetSize() - 1, &next_page_id);
-    guard = bpm_->FetchPageRead(next_page_id);
-
-    head = guard.As<BPlusTreePage>();
-  }
-
   auto *leaf_page = guard.As<LeafPage>();
   int index = 0;
   if (FindKeyIndex(key, leaf_page, 0, leaf_page->GetSize() - 1, &index)) {
-    return INDEXITERATOR_TYPE(bpm_, next_page_id, std::move(guard), index);
+    return INDEXITERATOR_TYPE(bpm_, leaf_page_id, std::move(guard), index, std::move(upcoming_leaves));
   }
 
   return End();
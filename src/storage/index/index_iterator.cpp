@@ -1,6 +1,7 @@
 /**
  * index_iterator.cpp
  */
+#include <algorithm>
 #include <cassert>
 #include <memory>
 
@@ -24,11 +25,35 @@ INDEXITERATOR_TYPE::~IndexIterator() = default;  // NOLINT
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, page_id_t current_page_id, ReadPageGuard &&current_page,
-                                  int current_index)
+                                  int current_index, std::vector<page_id_t> upcoming_leaves)
     : bpm_(bpm),
       current_page_id_(current_page_id),
       current_page_(std::move(current_page)),
-      current_index_(current_index) {}
+      current_index_(current_index),
+      upcoming_leaves_(upcoming_leaves.begin(), upcoming_leaves.end()) {
+  Prefetch();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::Prefetch() {
+  if (scan_prefetch_window == 0 || current_page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+
+  if (upcoming_leaves_.empty()) {
+    page_id_t next_page_id = current_page_.As<LeafPage>()->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      return;
+    }
+    upcoming_leaves_.push_back(next_page_id);
+  }
+
+  size_t end = std::min(upcoming_leaves_.size(), scan_prefetch_window);
+  if (prefetched_ < end) {
+    bpm_->Prefetch({upcoming_leaves_.begin() + prefetched_, upcoming_leaves_.begin() + end});
+    prefetched_ = end;
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::IsEnd() -> bool { return current_page_id_ == INVALID_PAGE_ID && current_index_ == 0; }
@@ -56,10 +81,21 @@ auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
     current_page_id_ = next_page_id;
     current_page_ = bpm_->FetchPageRead(next_page_id);
     current_index_ = 0;
-  } else {
-    current_index_++;
+
+    if (!upcoming_leaves_.empty() && upcoming_leaves_.front() == next_page_id) {
+      upcoming_leaves_.pop_front();
+      prefetched_ = prefetched_ > 0 ? prefetched_ - 1 : 0;
+    } else {
+      // the tree changed since the upcoming leaves were collected
+      upcoming_leaves_.clear();
+      prefetched_ = 0;
+    }
+    Prefetch();
+    return *this;
   }
 
+  current_index_++;
+
   if (current_index_ == page->GetSize() && leaf_page->GetNextPageId() == INVALID_PAGE_ID) {
     current_page_id_ = INVALID_PAGE_ID;
     current_index_ = 0;
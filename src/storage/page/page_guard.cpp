@@ -67,6 +67,31 @@ void ReadPageGuard::Drop() {
 
 ReadPageGuard::~ReadPageGuard() { Drop(); }  // NOLINT
 
+OptimisticReadGuard::OptimisticReadGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {
+  version_ = page->GetVersion();
+  while ((version_ & 1) != 0) {
+    // a writer holds the latch, wait for it instead of spinning
+    page->RLatch();
+    page->RUnlatch();
+    version_ = page->GetVersion();
+  }
+}
+
+auto OptimisticReadGuard::Validate() -> bool {
+  // keep the reads done through the guard before the second look at the version
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return guard_.page_->version_.load(std::memory_order_relaxed) == version_;
+}
+
+auto OptimisticReadGuard::UpgradeRead() -> ReadPageGuard {
+  ReadPageGuard read_guard;
+  if (guard_.IsValid()) {
+    guard_.page_->RLatch();
+    read_guard.guard_ = std::move(guard_);
+  }
+  return read_guard;
+}
+
 WritePageGuard::WritePageGuard(WritePageGuard &&that) noexcept { guard_ = BasicPageGuard(std::move(that.guard_)); }
 
 auto WritePageGuard::operator=(WritePageGuard &&that) noexcept -> WritePageGuard & {
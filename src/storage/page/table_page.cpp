@@ -24,8 +24,10 @@ namespace bustub {
 
 void TablePage::Init() {
   next_page_id_ = INVALID_PAGE_ID;
+  lsn_ = INVALID_LSN;
   num_tuples_ = 0;
   num_deleted_tuples_ = 0;
+  magic_ = TABLE_PAGE_MAGIC;
 }
 
 auto TablePage::GetNextTupleOffset(const TupleMeta &meta, const Tuple &tuple) const -> std::optional<uint16_t> {
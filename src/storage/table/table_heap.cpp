@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
 #include <mutex>  // NOLINT
 #include <random>
@@ -27,14 +28,24 @@
 
 namespace bustub {
 
-TableHeap::TableHeap(BufferPoolManager *bpm) : bpm_(bpm) {
+/** @return the id logged for changes made by txn, which may be null */
+static auto TxnIdOf(Transaction *txn) -> txn_id_t { return txn == nullptr ? INVALID_TXN_ID : txn->GetTransactionId(); }
+
+/** @return the prev lsn logged for changes made by txn, which may be null */
+static auto PrevLSNOf(Transaction *txn) -> lsn_t { return txn == nullptr ? INVALID_LSN : txn->GetPrevLSN(); }
+
+TableHeap::TableHeap(BufferPoolManager *bpm, LogManager *log_manager) : bpm_(bpm), log_manager_(log_manager) {
   // Initialize the first table page.
-  auto guard = bpm->NewPageGuarded(&first_page_id_);
+  auto guard = bpm->NewPageGuarded(&first_page_id_, &extent_);
   last_page_id_ = first_page_id_;
+  page_ids_.push_back(first_page_id_);
   auto first_page = guard.AsMut<TablePage>();
   BUSTUB_ASSERT(first_page != nullptr,
                 "Couldn't create a page for the table heap. Have you completed the buffer pool manager project?");
   first_page->Init();
+  if (IsLogging()) {
+    guard.SetLSN(LogNewPage(INVALID_PAGE_ID, first_page_id_, nullptr));
+  }
 }
 
 TableHeap::TableHeap(bool create_table_heap) : bpm_(nullptr) {}
@@ -53,13 +64,18 @@ auto TableHeap::InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManag
     BUSTUB_ENSURE(page->GetNumTuples() != 0, "tuple is too large, cannot insert");
 
     page_id_t next_page_id = INVALID_PAGE_ID;
-    auto npg = bpm_->NewPage(&next_page_id);
+    auto npg = bpm_->NewPage(&next_page_id, &extent_);
     BUSTUB_ENSURE(next_page_id != INVALID_PAGE_ID, "cannot allocate page");
 
     page->SetNextPageId(next_page_id);
 
     auto next_page = reinterpret_cast<TablePage *>(npg->GetData());
     next_page->Init();
+    if (IsLogging()) {
+      lsn_t lsn = LogNewPage(last_page_id_, next_page_id, txn);
+      page_guard.SetLSN(lsn);
+      npg->SetLSN(lsn);
+    }
 
     page_guard.Drop();
 
@@ -68,12 +84,17 @@ auto TableHeap::InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManag
     auto next_page_guard = WritePageGuard{bpm_, npg};
 
     last_page_id_ = next_page_id;
+    page_ids_.push_back(next_page_id);
     page_guard = std::move(next_page_guard);
   }
   auto last_page_id = last_page_id_;
 
   auto page = page_guard.AsMut<TablePage>();
   auto slot_id = *page->InsertTuple(meta, tuple);
+  if (IsLogging()) {
+    LogRecord record(TxnIdOf(txn), PrevLSNOf(txn), LogRecordType::INSERT, RID(last_page_id, slot_id), tuple);
+    page_guard.SetLSN(AppendLogRecord(&record, txn));
+  }
 
   // only allow one insertion at a time, otherwise it will deadlock.
   guard.unlock();
@@ -88,26 +109,144 @@ auto TableHeap::InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManag
   return RID(last_page_id, slot_id);
 }
 
-void TableHeap::UpdateTupleMeta(const TupleMeta &meta, RID rid) {
+auto TableHeap::InsertTuples(const TupleMeta &meta, const std::vector<Tuple> &tuples, LockManager *lock_mgr,
+                             Transaction *txn, table_oid_t oid) -> std::vector<RID> {
+  std::vector<RID> rids;
+  if (tuples.empty()) {
+    return rids;
+  }
+  rids.reserve(tuples.size());
+
+  std::unique_lock<std::mutex> guard(latch_);
+  // Only the page the batch is writing to is latched. A page the batch has filled is unpinned dirty before its latch
+  // is released, so that a flush never finds it clean and unlatched with changes in it.
+  Page *pg = bpm_->FetchPage(last_page_id_);
+  BUSTUB_ENSURE(pg != nullptr, "cannot fetch the last page");
+  pg->WLatch();
+  for (const auto &tuple : tuples) {
+    auto page = reinterpret_cast<TablePage *>(pg->GetData());
+    if (page->GetNextTupleOffset(meta, tuple) == std::nullopt) {
+      // if there's no tuple in the page, and we can't insert the tuple, then this tuple is too large.
+      BUSTUB_ENSURE(page->GetNumTuples() != 0, "tuple is too large, cannot insert");
+
+      page_id_t next_page_id = INVALID_PAGE_ID;
+      auto npg = bpm_->NewPage(&next_page_id, &extent_);
+      BUSTUB_ENSURE(next_page_id != INVALID_PAGE_ID, "cannot allocate page");
+      npg->WLatch();
+
+      auto next_page = reinterpret_cast<TablePage *>(npg->GetData());
+      next_page->Init();
+      page->SetNextPageId(next_page_id);
+      if (IsLogging()) {
+        lsn_t lsn = LogNewPage(last_page_id_, next_page_id, txn);
+        pg->SetLSN(lsn);
+        npg->SetLSN(lsn);
+      }
+
+      bpm_->UnpinPage(last_page_id_, true);
+      pg->WUnlatch();
+      pg = npg;
+      last_page_id_ = next_page_id;
+      page_ids_.push_back(next_page_id);
+      page = next_page;
+    }
+
+    auto slot_id = *page->InsertTuple(meta, tuple);
+    rids.emplace_back(last_page_id_, slot_id);
+    if (IsLogging()) {
+      LogRecord record(TxnIdOf(txn), PrevLSNOf(txn), LogRecordType::INSERT, rids.back(), tuple);
+      pg->SetLSN(AppendLogRecord(&record, txn));
+    }
+  }
+
+  // only allow one insertion at a time, otherwise it will deadlock.
+  guard.unlock();
+
+  if (lock_mgr != nullptr) {
+    for (const auto &rid : rids) {
+      BUSTUB_ENSURE(lock_mgr->LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, rid),
+                    "failed to lock when inserting new tuple");
+    }
+  }
+
+  page_id_t last_page_id = pg->GetPageId();
+  bpm_->UnpinPage(last_page_id, true);
+  pg->WUnlatch();
+
+  return rids;
+}
+
+void TableHeap::UpdateTupleMeta(const TupleMeta &meta, RID rid, Transaction *txn) {
   auto page_guard = bpm_->FetchPageWrite(rid.GetPageId());
   auto page = page_guard.AsMut<TablePage>();
   page->UpdateTupleMeta(meta, rid);
+  if (IsLogging()) {
+    // only the deleted flag changes, the tuple itself is not needed to redo or undo that
+    auto type = meta.is_deleted_ ? LogRecordType::MARKDELETE : LogRecordType::ROLLBACKDELETE;
+    LogRecord record(TxnIdOf(txn), PrevLSNOf(txn), type, rid, Tuple{});
+    page_guard.SetLSN(AppendLogRecord(&record, txn));
+  }
 }
 
-auto TableHeap::GetTuple(RID rid) -> std::pair<TupleMeta, Tuple> {
-  auto page_guard = bpm_->FetchPageRead(rid.GetPageId());
+auto TableHeap::GetTuple(RID rid, AccessType access_type) -> std::pair<TupleMeta, Tuple> {
+  auto page_guard = bpm_->FetchPageRead(rid.GetPageId(), access_type);
   auto page = page_guard.As<TablePage>();
   auto [meta, tuple] = page->GetTuple(rid);
   tuple.rid_ = rid;
   return std::make_pair(meta, std::move(tuple));
 }
 
+auto TableHeap::GetTuples(const std::vector<RID> &rids, AccessType access_type)
+    -> std::vector<std::pair<TupleMeta, Tuple>> {
+  // pin every page once, in page id order so that read latches are always taken in the same order
+  std::vector<page_id_t> page_ids;
+  page_ids.reserve(rids.size());
+  for (const auto &rid : rids) {
+    page_ids.push_back(rid.GetPageId());
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  page_ids.erase(std::unique(page_ids.begin(), page_ids.end()), page_ids.end());
+  std::vector<ReadPageGuard> page_guards = bpm_->FetchPagesRead(page_ids, access_type);
+
+  std::vector<std::pair<TupleMeta, Tuple>> tuples;
+  tuples.reserve(rids.size());
+  std::vector<size_t> unfetched;
+  for (size_t i = 0; i < rids.size(); ++i) {
+    size_t page_idx = std::lower_bound(page_ids.begin(), page_ids.end(), rids[i].GetPageId()) - page_ids.begin();
+    if (!page_guards[page_idx].IsValid()) {
+      // the buffer pool could not hold the whole batch
+      unfetched.push_back(i);
+      tuples.emplace_back();
+      continue;
+    }
+    auto [meta, tuple] = page_guards[page_idx].As<TablePage>()->GetTuple(rids[i]);
+    tuple.rid_ = rids[i];
+    tuples.emplace_back(meta, std::move(tuple));
+  }
+
+  page_guards.clear();
+  for (size_t i : unfetched) {
+    tuples[i] = GetTuple(rids[i], access_type);
+  }
+  return tuples;
+}
+
 auto TableHeap::GetTupleMeta(RID rid) -> TupleMeta {
   auto page_guard = bpm_->FetchPageRead(rid.GetPageId());
   auto page = page_guard.As<TablePage>();
   return page->GetTupleMeta(rid);
 }
 
+auto TableHeap::GetPageIds(size_t page_idx, size_t max_pages) -> std::vector<page_id_t> {
+  std::scoped_lock<std::mutex> guard(latch_);
+  if (page_idx >= page_ids_.size()) {
+    return {};
+  }
+
+  auto end = page_ids_.begin() + std::min(page_ids_.size(), page_idx + max_pages);
+  return {page_ids_.begin() + page_idx, end};
+}
+
 auto TableHeap::MakeIterator() -> TableIterator {
   std::unique_lock<std::mutex> guard(latch_);
   auto last_page_id = last_page_id_;
@@ -120,6 +259,19 @@ auto TableHeap::MakeIterator() -> TableIterator {
 
 auto TableHeap::MakeEagerIterator() -> TableIterator { return {this, {first_page_id_, 0}, {INVALID_PAGE_ID, 0}}; }
 
+auto TableHeap::AppendLogRecord(LogRecord *log_record, Transaction *txn) -> lsn_t {
+  lsn_t lsn = log_manager_->AppendLogRecord(log_record);
+  if (txn != nullptr) {
+    txn->SetPrevLSN(lsn);
+  }
+  return lsn;
+}
+
+auto TableHeap::LogNewPage(page_id_t prev_page_id, page_id_t new_page_id, Transaction *txn) -> lsn_t {
+  LogRecord record(TxnIdOf(txn), PrevLSNOf(txn), LogRecordType::NEWPAGE, prev_page_id, new_page_id);
+  return AppendLogRecord(&record, txn);
+}
+
 void TableHeap::UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid) {
   auto page_guard = bpm_->FetchPageWrite(rid.GetPageId());
   auto page = page_guard.AsMut<TablePage>();
@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer_test.cpp
+//
+// Identification: test/buffer/arc_replacer_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(ARCReplacerTest, SampleTest) {
+  ARCReplacer replacer(4);
+
+  // Scenario: frames 0-3 hold pages 100-103, page 100 is accessed again and moves to T2.
+  for (frame_id_t frame_id = 0; frame_id < 4; ++frame_id) {
+    replacer.RecordAccess(frame_id, AccessType::Get, 100 + frame_id);
+    replacer.SetEvictable(frame_id, true);
+  }
+  replacer.RecordAccess(0);
+  EXPECT_EQ((std::vector<frame_id_t>{1, 2, 3, 0}), replacer.EvictionCandidates(4));
+
+  // Scenario: T1 is above its target size 0, its least recently used frame goes and page 101 is remembered in B1.
+  int value;
+  ASSERT_EQ(true, replacer.Evict(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: page 101 comes back, which grows the target size of T1 and puts the page into T2.
+  replacer.RecordAccess(1, AccessType::Get, 101);
+  replacer.SetEvictable(1, true);
+  EXPECT_EQ(1, replacer.GetTargetT1Size());
+  EXPECT_EQ((std::vector<frame_id_t>{2, 0, 1, 3}), replacer.EvictionCandidates(4));
+
+  // Scenario: evicting from T2 remembers the page in B2, and its return shrinks the target size again.
+  ASSERT_EQ(true, replacer.Evict(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_EQ(true, replacer.Evict(&value));
+  EXPECT_EQ(0, value);
+  replacer.RecordAccess(0, AccessType::Get, 100);
+  replacer.SetEvictable(0, true);
+  EXPECT_EQ(0, replacer.GetTargetT1Size());
+
+  ReplacerStats stats = replacer.GetStats();
+  EXPECT_EQ(2, stats.cold_evictions_);
+  EXPECT_EQ(1, stats.hot_evictions_);
+}
+
+TEST(ARCReplacerTest, PinTest) {
+  ARCReplacer replacer(3);
+
+  // Scenario: pinned frames are skipped, Remove() forgets a frame without remembering its page.
+  for (frame_id_t frame_id = 0; frame_id < 3; ++frame_id) {
+    replacer.RecordAccess(frame_id, AccessType::Get, frame_id);
+    replacer.SetEvictable(frame_id, true);
+  }
+  replacer.SetEvictable(0, false);
+  EXPECT_EQ(2, replacer.Size());
+  EXPECT_EQ((std::vector<frame_id_t>{1, 2}), replacer.EvictionCandidates(3));
+  EXPECT_EQ(false, replacer.Evict(0));
+  replacer.Remove(1);
+  replacer.RecordAccess(1, AccessType::Get, 1);
+  replacer.SetEvictable(1, true);
+  EXPECT_EQ(0, replacer.GetTargetT1Size());
+  EXPECT_EQ((std::vector<frame_id_t>{2, 1}), replacer.EvictionCandidates(3));
+}
+
+}  // namespace bustub
@@ -12,15 +12,31 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <cstring>
 #include <limits>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
+/** An in-memory disk manager that counts the pages read from it. */
+class CountingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+    reads_++;
+  }
+  std::atomic<size_t> reads_{0};
+};
+
 // NOLINTNEXTLINE
 // Check whether pages containing terminal characters can be recovered
 TEST(BufferPoolManagerTest, BinaryDataTest) {
@@ -91,6 +107,7 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.alloc");
 
   delete bpm;
   delete disk_manager;
@@ -149,9 +166,801 @@ TEST(BufferPoolManagerTest, SampleTest) {
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
   remove("test.db");
+  remove("test.alloc");
 
   delete bpm;
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ShardedTest) {
+  const size_t buffer_pool_size = 10;
+  const size_t num_shards = 2;
+  const size_t k = 5;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, num_shards);
+  ASSERT_EQ(num_shards, bpm->GetNumShards());
+
+  // Scenario: consecutive page ids alternate between the shards, so the whole pool can be filled.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  // Scenario: a new page whose shard is full goes to another one. Page 10 would land in shard 0, so page 11 takes
+  // the frame of page 1 in shard 1 instead. The ids passed over are given back, page 10 comes once shard 0 has room.
+  EXPECT_EQ(true, bpm->UnpinPage(1, true));
+  auto *page11 = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page11);
+  EXPECT_EQ(11, page_id_temp);
+  snprintf(page11->GetData(), BUSTUB_PAGE_SIZE, "page 11");
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(true, bpm->UnpinPage(0, true));
+  auto *page10 = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page10);
+  EXPECT_EQ(10, page_id_temp);
+  snprintf(page10->GetData(), BUSTUB_PAGE_SIZE, "page 10");
+  EXPECT_EQ(true, bpm->UnpinPage(10, true));
+  EXPECT_EQ(true, bpm->UnpinPage(11, true));
+
+  for (page_id_t page_id = 2; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: many threads hammering all shards always see the data they wrote.
+  std::vector<page_id_t> page_ids = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  while (page_ids.size() < 50) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    page_ids.push_back(page_id_temp);
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < 4; ++thread_id) {
+    threads.emplace_back([&bpm, &page_ids, thread_id] {
+      for (size_t i = 0; i < 200; ++i) {
+        page_id_t page_id = page_ids[(i * 7 + thread_id) % page_ids.size()];
+        auto *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        page->RLatch();
+        EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+        page->RUnlatch();
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, IOOutsideLatchTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (page_id_t page_id = 0; page_id < 6; ++page_id) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Pages 0 and 1 have been evicted, page 5 is resident.
+  disk_manager->SetLatency(200);
+
+  // Scenario: several threads missing on the same page share a single read and all see the same frame.
+  std::atomic<bool> miss_done = false;
+  std::vector<Page *> fetched(3, nullptr);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < fetched.size(); ++i) {
+    threads.emplace_back([&bpm, &fetched, &miss_done, i] {
+      fetched[i] = bpm->FetchPage(0);
+      miss_done = true;
+    });
+  }
+
+  // Scenario: while the miss is in flight (write-back of a dirty victim, then the read), hits are not blocked.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto *page5 = bpm->FetchPage(5);
+  ASSERT_NE(nullptr, page5);
+  EXPECT_FALSE(miss_done);
+  EXPECT_EQ(0, strcmp(page5->GetData(), "page 5"));
+  EXPECT_EQ(true, bpm->UnpinPage(5, false));
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (auto *page : fetched) {
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(fetched[0], page);
+    EXPECT_EQ(0, strcmp(page->GetData(), "page 0"));
+  }
+  EXPECT_EQ(3, fetched[0]->GetPinCount());
+  for (size_t i = 0; i < fetched.size(); ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ScanRingTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t k = 5;
+
+  auto disk_manager = std::make_unique<CountingDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (page_id_t page_id = 0; page_id < 40; ++page_id) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Pages 0..3 form the working set, accessed fewer than k times so LRU-K alone would not protect them.
+  for (page_id_t page_id = 0; page_id < 4; ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a scan over all other pages only recycles its own ring of frames.
+  for (page_id_t page_id = 4; page_id < 40; ++page_id) {
+    auto *page = bpm->FetchPage(page_id, AccessType::Scan);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false, AccessType::Scan));
+  }
+
+  size_t reads = disk_manager->reads_;
+  for (page_id_t page_id = 0; page_id < 4; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(reads, disk_manager->reads_);
+
+  // Scenario: the same pass with regular accesses washes the working set out.
+  for (page_id_t page_id = 4; page_id < 40; ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  reads = disk_manager->reads_;
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  EXPECT_EQ(reads + 1, disk_manager->reads_);
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, BackgroundWriterTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: the writer cleans the next 4 frames in eviction order, in the background.
+  bpm->StartBackgroundWriter(4);
+  for (int i = 0; i < 500 && bpm->GetBackgroundWriteCount() < 4; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(4, bpm->GetBackgroundWriteCount());
+  EXPECT_EQ(0, bpm->GetForegroundWriteCount());
+
+  // Scenario: evicting those frames does not write anything in the foreground.
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(0, bpm->GetForegroundWriteCount());
+
+  // Scenario: the pages still dirty are written by whoever evicts them.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(1, bpm->GetForegroundWriteCount());
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+
+  // Scenario: the cleaned pages are intact on disk.
+  for (page_id_t page_id = 0; page_id < 4; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const size_t buffer_pool_size = 16;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<CountingDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < 2 * buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: pages 0..7 were evicted, prefetching reads them back in the background.
+  std::vector<page_id_t> page_ids{0, 1, 2, 3, 4, 5, 6, 7};
+  bpm->Prefetch(page_ids);
+  for (int i = 0; i < 500 && disk_manager->reads_ < page_ids.size(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(page_ids.size(), disk_manager->reads_);
+
+  // Scenario: fetching them afterwards does not touch the disk.
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(page_ids.size(), disk_manager->reads_);
+
+  // Scenario: prefetching resident pages is a no-op.
+  bpm->Prefetch(page_ids);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(page_ids.size(), disk_manager->reads_);
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, WarmupTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<CountingDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size + 2; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(3));
+    EXPECT_EQ(true, bpm->UnpinPage(3, false));
+  }
+
+  // Scenario: the resident pages are listed hottest first, the page reused is ahead of those seen once.
+  std::vector<page_id_t> expected{3, 5, 4, 2};
+  EXPECT_EQ(expected, bpm->GetWarmupList());
+  bpm->DumpWarmupList();
+  EXPECT_EQ(expected, disk_manager->ReadWarmupList());
+
+  // Scenario: after a restart with a smaller buffer pool, the hottest pages that still exist are read back.
+  EXPECT_EQ(true, bpm->DeletePage(5));
+  bpm->FlushAllPages();
+  bpm = std::make_unique<BufferPoolManager>(buffer_pool_size / 2, disk_manager.get(), k);
+  size_t reads = disk_manager->reads_;
+  EXPECT_EQ(2, bpm->StartWarmup());
+  for (int i = 0; i < 500 && disk_manager->reads_ < reads + 2; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(reads + 2, disk_manager->reads_);
+  for (page_id_t page_id : {3, 4}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(reads + 2, disk_manager->reads_);
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, FrameAllocationTest) {
+  const size_t buffer_pool_size = 10;
+  const size_t k = 5;
+
+  for (auto frame_allocation : {FrameAllocation::PerFrame, FrameAllocation::Arena, FrameAllocation::HugePageArena}) {
+    auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+    auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, 1,
+                                                   frame_allocation);
+
+    // Scenario: arena frames are contiguous and page aligned.
+    if (bpm->GetFrameAllocation() != FrameAllocation::PerFrame) {
+      char *arena = bpm->GetPages()[0].GetData();
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(arena) % BUSTUB_PAGE_SIZE);
+      for (size_t i = 0; i < buffer_pool_size; ++i) {
+        EXPECT_EQ(arena + i * BUSTUB_PAGE_SIZE, bpm->GetPages()[i].GetData());
+      }
+    }
+
+    // Scenario: pages survive being evicted and read back, whatever frame they land in.
+    page_id_t page_id_temp;
+    for (size_t i = 0; i < 2 * buffer_pool_size; ++i) {
+      auto *page = bpm->NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+      EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    }
+    for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(2 * buffer_pool_size); ++page_id) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, AllocationMapTest) {
+  const size_t buffer_pool_size = 10;
+  const size_t k = 5;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (page_id_t page_id = 0; page_id < 6; ++page_id) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(page_id, page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: deleted page ids are reused lowest first, whether or not the page was resident.
+  EXPECT_EQ(true, bpm->DeletePage(3));
+  EXPECT_EQ(true, bpm->DeletePage(1));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(1, page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  EXPECT_EQ(true, bpm->DeletePage(1));
+  // Deleting an unallocated page id twice must not hand it out twice.
+  EXPECT_EQ(true, bpm->DeletePage(1));
+
+  // Scenario: the allocation map survives a restart once it has been flushed.
+  bpm->FlushAllPages();
+  bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    page_ids.push_back(page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ((std::vector<page_id_t>{1, 3, 6, 7}), page_ids);
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, StatsTest) {
+  const size_t buffer_pool_size = 2;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  // page 0 was evicted to make room for page 2, page 2 is still resident
+  ASSERT_NE(nullptr, bpm->FetchPage(2));
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(true, bpm->FlushPage(0));
+
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.Get(BufferPoolStat::Hit));
+  EXPECT_EQ(1, stats.Get(BufferPoolStat::Miss));
+  EXPECT_EQ(2, stats.Get(BufferPoolStat::Eviction));
+  EXPECT_EQ(2, stats.Get(BufferPoolStat::ForegroundWrite));
+  EXPECT_EQ(1, stats.Get(BufferPoolStat::Flush));
+  EXPECT_EQ(1, stats.Get(BufferPoolStat::NoFreeFrame));
+  EXPECT_EQ(2, stats.cold_evictions_ + stats.hot_evictions_);
+  EXPECT_DOUBLE_EQ(0.5, stats.HitRate());
+  EXPECT_NE(std::string::npos, stats.ToJson().find("\"evictions\": 2"));
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, LockFreeHitTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t k = 2;
+  const size_t num_threads = 8;
+  const size_t rounds = 2000;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, 2);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: concurrent fetches of resident pages all hit and see the right frame.
+  std::vector<std::thread> threads;
+  std::atomic<size_t> wrong_pages{0};
+  for (size_t thread_id = 0; thread_id < num_threads; ++thread_id) {
+    threads.emplace_back([&bpm, &wrong_pages, thread_id] {
+      for (size_t i = 0; i < rounds; ++i) {
+        auto page_id = static_cast<page_id_t>((thread_id + i) % buffer_pool_size);
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr || page->GetPageId() != page_id ||
+            std::string(page->GetData()) != "page " + std::to_string(page_id)) {
+          wrong_pages++;
+          continue;
+        }
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, wrong_pages);
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(num_threads * rounds, stats.Get(BufferPoolStat::Hit));
+  EXPECT_EQ(0, stats.Get(BufferPoolStat::Miss));
+
+  // Scenario: every pin has been dropped again, so each page can be deleted.
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    EXPECT_EQ(true, bpm->DeletePage(page_id));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, LockFreeHitEvictionOrderTest) {
+  const size_t buffer_pool_size = 3;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: hits taken without the shard latch still count for the replacer. Page 0 has been accessed k times
+  // by now, so page 1 is the victim for page 3.
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(2));
+  EXPECT_EQ(true, bpm->UnpinPage(2, false));
+  EXPECT_EQ(0, bpm->GetStats().Get(BufferPoolStat::Miss));
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_EQ(true, bpm->UnpinPage(1, false));
+  EXPECT_EQ(1, bpm->GetStats().Get(BufferPoolStat::Miss));
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, PinnedFrameParkingTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  std::vector<page_id_t> pinned;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    pinned.push_back(page_id_temp);
+  }
+  EXPECT_EQ(true, bpm->UnpinPage(pinned.back(), false));
+  pinned.pop_back();
+
+  // Scenario: pinned frames found by an eviction are set aside, the one unpinned frame keeps being reused.
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: once unpinned, the set-aside frames can be evicted again.
+  for (page_id_t page_id : pinned) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, BatchFetchTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, 2);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < 8; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: a batch mixing resident pages, misses of both shards and a duplicate pins every entry once.
+  std::vector<page_id_t> page_ids{7, 0, 2, 7};
+  auto pages = bpm->FetchPages(page_ids);
+  ASSERT_EQ(page_ids.size(), pages.size());
+  for (size_t i = 0; i < pages.size(); ++i) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(page_ids[i], pages[i]->GetPageId());
+    EXPECT_EQ("page " + std::to_string(page_ids[i]), std::string(pages[i]->GetData()));
+  }
+  EXPECT_EQ(2, pages[0]->GetPinCount());
+  EXPECT_EQ(1, pages[1]->GetPinCount());
+
+  // Scenario: shard 1 has two frames, one of them pinned twice by page 7, so page 1 gets the other one and page 3
+  // cannot be fetched.
+  auto more_pages = bpm->FetchPages({1, 3});
+  ASSERT_NE(nullptr, more_pages[0]);
+  EXPECT_EQ(nullptr, more_pages[1]);
+  EXPECT_EQ(true, bpm->UnpinPage(1, false));
+
+  // Scenario: each entry holds one pin.
+  for (page_id_t page_id : page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(false, bpm->UnpinPage(0, false));
+  EXPECT_EQ(0, pages[0]->GetPinCount());
+
+  auto guards = bpm->FetchPagesRead({1, 4, 3});
+  for (auto &guard : guards) {
+    ASSERT_EQ(true, guard.IsValid());
+    EXPECT_EQ("page " + std::to_string(guard.PageId()), std::string(guard.GetData()));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ReplacerPolicyTest) {
+  const size_t buffer_pool_size = 3;
+  const size_t k = 2;
+
+  for (auto policy : {ReplacerPolicy::LRUK, ReplacerPolicy::LRU, ReplacerPolicy::Clock, ReplacerPolicy::TwoQueue,
+                      ReplacerPolicy::ARC}) {
+    ReplacerPolicy parsed;
+    ASSERT_EQ(true, ParseReplacerPolicy(ReplacerPolicyName(policy), &parsed));
+    EXPECT_EQ(policy, parsed);
+  }
+  ReplacerPolicy parsed;
+  EXPECT_EQ(false, ParseReplacerPolicy("mru", &parsed));
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, 1,
+                                                 DEFAULT_FRAME_ALLOCATION, ReplacerPolicy::Clock);
+  EXPECT_EQ(ReplacerPolicy::Clock, bpm->GetReplacerPolicy());
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: switching the policy keeps resident pages, and the new replacer still never evicts a pinned page.
+  auto *page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  bpm->SetReplacerPolicy(ReplacerPolicy::ARC);
+  EXPECT_EQ(ReplacerPolicy::ARC, bpm->GetReplacerPolicy());
+  for (size_t i = 0; i < 2 * buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(0, bpm->GetStats().Get(BufferPoolStat::Miss));
+  EXPECT_EQ(page0, bpm->FetchPage(0));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  // Scenario: evictions of the replaced replacer are still counted.
+  bpm->SetReplacerPolicy(ReplacerPolicy::TwoQueue);
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(2 * buffer_pool_size, stats.Get(BufferPoolStat::Eviction));
+  EXPECT_EQ(2 * buffer_pool_size, stats.cold_evictions_ + stats.hot_evictions_);
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  const size_t buffer_pool_size = 10;
+  const size_t k = 2;
+
+  class RunDiskManager : public DiskManagerUnlimitedMemory {
+   public:
+    void WritePage(page_id_t page_id, char const *page_data) override {
+      single_writes_.push_back(page_id);
+      DiskManagerUnlimitedMemory::WritePage(page_id, page_data);
+      num_writes_++;
+    }
+    void WritePages(page_id_t first_page_id, const std::vector<const char *> &pages_data) override {
+      runs_.emplace_back(first_page_id, pages_data.size());
+      for (size_t i = 0; i < pages_data.size(); i++) {
+        DiskManagerUnlimitedMemory::WritePage(first_page_id + i, pages_data[i]);
+      }
+      num_writes_ += pages_data.size();
+    }
+    void SyncPages() override { syncs_++; }
+    std::vector<page_id_t> single_writes_;
+    std::vector<std::pair<page_id_t, size_t>> runs_;
+    std::atomic<size_t> num_writes_{0};
+    size_t syncs_{0};
+  };
+
+  auto disk_manager = std::make_unique<RunDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, 2);
+
+  page_id_t page_id_temp;
+  for (page_id_t page_id = 0; page_id < 8; ++page_id) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, page_id != 3));
+  }
+
+  // Scenario: dirty pages of both shards are written in page id order, runs of consecutive pages at once. A page
+  // latched by a writer is written on its own, only once the writer has released it.
+  {
+    auto guard = bpm->FetchPageWrite(6);
+    guard.GetDataMut()[0] = 'P';
+    std::thread flusher([&] { bpm->FlushAllPages(); });
+    for (int i = 0; i < 500 && disk_manager->num_writes_ < 6; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(6, disk_manager->num_writes_);
+    guard.GetDataMut()[1] = 'A';
+    guard.Drop();
+    flusher.join();
+  }
+  EXPECT_EQ((std::vector<std::pair<page_id_t, size_t>>{{0, 3}, {4, 2}, {7, 1}}), disk_manager->runs_);
+  EXPECT_EQ((std::vector<page_id_t>{6}), disk_manager->single_writes_);
+  EXPECT_EQ(1, disk_manager->syncs_);
+  EXPECT_EQ(7, bpm->GetStats().Get(BufferPoolStat::Flush));
+
+  char data[BUSTUB_PAGE_SIZE];
+  disk_manager->DiskManagerUnlimitedMemory::ReadPage(6, data);
+  EXPECT_EQ(std::string("PAge 6"), std::string(data));
+
+  // Scenario: only pages dirtied since are written by the next flush.
+  disk_manager->runs_.clear();
+  disk_manager->single_writes_.clear();
+  bpm->FetchPageWrite(5).GetDataMut()[0] = 'P';
+  bpm->FlushAllPages();
+  EXPECT_EQ((std::vector<std::pair<page_id_t, size_t>>{{5, 1}}), disk_manager->runs_);
+  EXPECT_EQ(0, disk_manager->single_writes_.size());
+
+  disk_manager->DiskManagerUnlimitedMemory::ReadPage(5, data);
+  EXPECT_EQ(std::string("Page 5"), std::string(data));
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ExtentTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(0, page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+
+  // Scenario: two owners allocating in turns each get contiguous pages, starting at an extent boundary.
+  PageExtent table_extent;
+  PageExtent index_extent;
+  for (page_id_t i = 0; i < PAGE_EXTENT_SIZE + 1; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp, &table_extent));
+    EXPECT_EQ(i < PAGE_EXTENT_SIZE ? PAGE_EXTENT_SIZE + i : 3 * PAGE_EXTENT_SIZE, page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+    if (i < 2) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp, &index_extent));
+      EXPECT_EQ(2 * PAGE_EXTENT_SIZE + i, page_id_temp);
+      EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+    }
+  }
+
+  // Scenario: single pages fill the ids skipped to align the first extent.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(1, page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+
+  // Scenario: an extent whose pages were all deleted is reserved again before the file grows.
+  for (page_id_t page_id = PAGE_EXTENT_SIZE; page_id < 2 * PAGE_EXTENT_SIZE; ++page_id) {
+    EXPECT_EQ(true, bpm->DeletePage(page_id));
+  }
+  PageExtent other_extent;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp, &other_extent));
+  EXPECT_EQ(PAGE_EXTENT_SIZE, page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ResizeTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t num_shards = 2;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, num_shards);
+
+  // Pages 0 to 3 stay pinned, pages alternate between the two shards of two frames each.
+  page_id_t page_id_temp;
+  std::vector<Page *> pages;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    pages.push_back(bpm->NewPage(&page_id_temp));
+    ASSERT_NE(nullptr, pages.back());
+    snprintf(pages.back()->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  // Scenario: sizes below one frame per shard or beyond the reservation are refused.
+  EXPECT_EQ(false, bpm->Resize(num_shards - 1));
+  EXPECT_EQ(false, bpm->Resize(MAX_BUFFER_POOL_SIZE + 1));
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+
+  // Scenario: growing adds free frames to every shard, and the pages already pinned do not move.
+  ASSERT_EQ(true, bpm->Resize(2 * buffer_pool_size));
+  EXPECT_EQ(2 * buffer_pool_size, bpm->GetPoolSize());
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_EQ(pages[i], bpm->FetchPage(i));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  // Scenario: shrinking writes back and gives up the unpinned frames beyond the new size right away, a pinned one
+  // keeps its page until it is unpinned.
+  auto *page6 = bpm->FetchPage(6);
+  ASSERT_NE(nullptr, page6);
+  ASSERT_EQ(true, bpm->Resize(buffer_pool_size));
+  EXPECT_EQ(buffer_pool_size, bpm->GetPoolSize());
+  EXPECT_EQ(0, strcmp(page6->GetData(), "page 6"));
+  EXPECT_EQ(nullptr, bpm->FetchPage(4));
+  EXPECT_EQ(true, bpm->UnpinPage(6, false));
+  EXPECT_EQ(INVALID_PAGE_ID, page6->GetPageId());
+
+  // Scenario: the pages of the frames given up are read back into the frames left.
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  EXPECT_EQ(true, bpm->UnpinPage(1, false));
+  for (page_id_t page_id : {4, 5, 6, 7}) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), page->GetData());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: frames given up are reused when the buffer pool grows again, all but the two still pinned.
+  ASSERT_EQ(true, bpm->Resize(2 * buffer_pool_size));
+  size_t new_pages = 0;
+  while (bpm->NewPage(&page_id_temp) != nullptr) {
+    new_pages++;
+  }
+  EXPECT_EQ(2 * buffer_pool_size - 2, new_pages);
+}
+
 }  // namespace bustub
@@ -19,44 +19,69 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
-  // Scenario: unpin six elements, i.e. add them to the replacer.
-  clock_replacer.Unpin(1);
-  clock_replacer.Unpin(2);
-  clock_replacer.Unpin(3);
-  clock_replacer.Unpin(4);
-  clock_replacer.Unpin(5);
-  clock_replacer.Unpin(6);
-  clock_replacer.Unpin(1);
+  // Scenario: add six elements to the replacer. Element 1 is accessed twice.
+  for (frame_id_t frame_id = 1; frame_id <= 6; ++frame_id) {
+    clock_replacer.RecordAccess(frame_id);
+    clock_replacer.SetEvictable(frame_id, true);
+  }
+  clock_replacer.RecordAccess(1);
   EXPECT_EQ(6, clock_replacer.Size());
 
-  // Scenario: get three victims from the clock.
+  // Scenario: get three victims from the clock. The first sweep clears every reference bit.
   int value;
-  clock_replacer.Victim(&value);
+  clock_replacer.Evict(&value);
   EXPECT_EQ(1, value);
-  clock_replacer.Victim(&value);
+  clock_replacer.Evict(&value);
   EXPECT_EQ(2, value);
-  clock_replacer.Victim(&value);
+  clock_replacer.Evict(&value);
   EXPECT_EQ(3, value);
 
   // Scenario: pin elements in the replacer.
   // Note that 3 has already been victimized, so pinning 3 should have no effect.
-  clock_replacer.Pin(3);
-  clock_replacer.Pin(4);
+  clock_replacer.SetEvictable(3, false);
+  clock_replacer.SetEvictable(4, false);
   EXPECT_EQ(2, clock_replacer.Size());
 
-  // Scenario: unpin 4. We expect that the reference bit of 4 will be set to 1.
-  clock_replacer.Unpin(4);
+  // Scenario: unpin 4 after accessing it. We expect that the reference bit of 4 will be set to 1.
+  clock_replacer.RecordAccess(4);
+  clock_replacer.SetEvictable(4, true);
 
   // Scenario: continue looking for victims. We expect these victims.
-  clock_replacer.Victim(&value);
+  EXPECT_EQ((std::vector<frame_id_t>{5, 6, 4}), clock_replacer.EvictionCandidates(7));
+  clock_replacer.Evict(&value);
   EXPECT_EQ(5, value);
-  clock_replacer.Victim(&value);
+  clock_replacer.Evict(&value);
   EXPECT_EQ(6, value);
-  clock_replacer.Victim(&value);
+  clock_replacer.Evict(&value);
   EXPECT_EQ(4, value);
+  EXPECT_EQ(false, clock_replacer.Evict(&value));
+
+  ReplacerStats stats = clock_replacer.GetStats();
+  EXPECT_EQ(2, stats.hot_evictions_);
+  EXPECT_EQ(4, stats.cold_evictions_);
+}
+
+TEST(ClockReplacerTest, ScanTest) {
+  ClockReplacer clock_replacer(4);
+
+  // Scenario: a frame brought in by a scan gets no second chance, and re-reading it in a scan does not give it one.
+  clock_replacer.RecordAccess(0);
+  clock_replacer.RecordAccess(1, AccessType::Scan);
+  clock_replacer.RecordAccess(1, AccessType::Scan);
+  clock_replacer.SetEvictable(0, true);
+  clock_replacer.SetEvictable(1, true);
+  int value;
+  ASSERT_EQ(true, clock_replacer.Evict(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(1, clock_replacer.GetStats().ignored_scan_accesses_);
+
+  // Scenario: Remove() stops tracking without counting an eviction.
+  clock_replacer.Remove(0);
+  EXPECT_EQ(0, clock_replacer.Size());
+  EXPECT_EQ(1, clock_replacer.GetStats().cold_evictions_);
 }
 
 }  // namespace bustub
@@ -12,6 +12,7 @@
 #include <thread>  // NOLINT
 #include <vector>
 
+#include "common/exception.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
@@ -95,4 +96,75 @@ TEST(LRUKReplacerTest, SampleTest) {
   ASSERT_EQ(false, lru_replacer.Evict(&value));
   ASSERT_EQ(0, lru_replacer.Size());
 }
+
+TEST(LRUKReplacerTest, KthAccessTest) {
+  LRUKReplacer lru_replacer(3, 2);
+  frame_id_t value;
+
+  // Scenario: timestamps 0..5 are handed out as frame 0, 1, 0, 1, 2, 2 are accessed.
+  // Backward 2-distances: frame 0 -> since ts 0, frame 1 -> since ts 1, frame 2 -> since ts 4.
+  for (frame_id_t frame_id : {0, 1, 0, 1, 2, 2}) {
+    lru_replacer.RecordAccess(frame_id);
+  }
+  for (frame_id_t frame_id = 0; frame_id < 3; ++frame_id) {
+    lru_replacer.SetEvictable(frame_id, true);
+  }
+
+  // Scenario: a third access to frame 0 moves its 2nd most recent access to ts 2, so frame 1 is the oldest now.
+  lru_replacer.RecordAccess(0);
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+
+  // Scenario: an evicted frame starts over with fewer than k accesses and goes before any fully accessed frame.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.SetEvictable(1, true);
+  ASSERT_EQ(3, lru_replacer.Size());
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+
+  // Scenario: removing a non-evictable frame is an error, removing an unknown frame is a no-op.
+  lru_replacer.RecordAccess(0);
+  ASSERT_THROW(lru_replacer.Remove(0), Exception);
+  lru_replacer.Remove(1);
+  lru_replacer.SetEvictable(0, true);
+  lru_replacer.Remove(0);
+  ASSERT_EQ(0, lru_replacer.Size());
+  ASSERT_EQ(false, lru_replacer.Evict(&value));
+}
+
+TEST(LRUKReplacerTest, RecordAccessAtTest) {
+  LRUKReplacer lru_replacer(3, 2);
+
+  // Scenario: frame 0 is hit at times h1 and h2, but the hits are not recorded right away.
+  lru_replacer.RecordAccess(0);
+  size_t h1 = lru_replacer.Now();
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2);
+  size_t h2 = lru_replacer.Now();
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2);
+  for (frame_id_t frame_id = 0; frame_id < 3; ++frame_id) {
+    lru_replacer.SetEvictable(frame_id, true);
+  }
+
+  // Scenario: recorded late and out of order, the hits keep their times. Frame 0 is as old as frame 1 and goes first,
+  // recorded as accesses of now it would go last.
+  lru_replacer.RecordAccessAt(0, h2);
+  lru_replacer.RecordAccessAt(0, h1);
+  ASSERT_EQ((std::vector<frame_id_t>{0, 1, 2}), lru_replacer.EvictionCandidates(3));
+
+  // Scenario: an access older than the last k does not change the rank.
+  lru_replacer.RecordAccessAt(1, 0);
+  ASSERT_EQ((std::vector<frame_id_t>{0, 1, 2}), lru_replacer.EvictionCandidates(3));
+
+  // Scenario: a time the clock has not reached counts as now.
+  size_t now = lru_replacer.Now();
+  lru_replacer.RecordAccessAt(0, now + 100);
+  ASSERT_EQ(now + 1, lru_replacer.Now());
+  ASSERT_EQ((std::vector<frame_id_t>{1, 2, 0}), lru_replacer.EvictionCandidates(3));
+}
 }  // namespace bustub
@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer_test.cpp
+//
+// Identification: test/buffer/two_queue_replacer_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <vector>
+
+#include "buffer/two_queue_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(TwoQueueReplacerTest, SampleTest) {
+  // A1in is kept at 2 frames, A1out remembers 4 pages.
+  TwoQueueReplacer replacer(8);
+
+  // Scenario: frames 0-3 hold pages 100-103. Accesses while in A1in are correlated and change nothing.
+  for (frame_id_t frame_id = 0; frame_id < 4; ++frame_id) {
+    replacer.RecordAccess(frame_id, AccessType::Get, 100 + frame_id);
+    replacer.SetEvictable(frame_id, true);
+  }
+  replacer.RecordAccess(0);
+  EXPECT_EQ(4, replacer.Size());
+  EXPECT_EQ((std::vector<frame_id_t>{0, 1, 2, 3}), replacer.EvictionCandidates(8));
+
+  // Scenario: A1in is too large, so its oldest frames go first and their pages are remembered in A1out.
+  int value;
+  ASSERT_EQ(true, replacer.Evict(&value));
+  EXPECT_EQ(0, value);
+  ASSERT_EQ(true, replacer.Evict(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: page 100 comes back while remembered and goes to Am. Page 104 is new and goes to A1in.
+  replacer.RecordAccess(0, AccessType::Get, 100);
+  replacer.SetEvictable(0, true);
+  replacer.RecordAccess(1, AccessType::Get, 104);
+  replacer.SetEvictable(1, true);
+
+  // Scenario: A1in holds 3 frames, 1 more than it is kept at: one victim comes from it, then Am is evicted.
+  EXPECT_EQ((std::vector<frame_id_t>{2, 0, 3, 1}), replacer.EvictionCandidates(8));
+  ASSERT_EQ(true, replacer.Evict(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_EQ(true, replacer.Evict(&value));
+  EXPECT_EQ(0, value);
+
+  ReplacerStats stats = replacer.GetStats();
+  EXPECT_EQ(3, stats.cold_evictions_);
+  EXPECT_EQ(1, stats.hot_evictions_);
+}
+
+TEST(TwoQueueReplacerTest, ScanTest) {
+  TwoQueueReplacer replacer(4);
+
+  // Scenario: a page that a scan brings back is not promoted to Am.
+  replacer.RecordAccess(0, AccessType::Scan, 7);
+  replacer.SetEvictable(0, true);
+  int value;
+  ASSERT_EQ(true, replacer.Evict(&value));
+  replacer.RecordAccess(0, AccessType::Scan, 7);
+  replacer.RecordAccess(0, AccessType::Scan);
+  replacer.SetEvictable(0, true);
+  replacer.RecordAccess(1, AccessType::Get, 8);
+  replacer.SetEvictable(1, true);
+  ASSERT_EQ(true, replacer.Evict(&value));
+  EXPECT_EQ(0, value);
+  EXPECT_EQ(1, replacer.GetStats().ignored_scan_accesses_);
+  EXPECT_EQ(0, replacer.GetStats().hot_evictions_);
+}
+
+}  // namespace bustub
@@ -0,0 +1,223 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_manager_test.cpp
+//
+// Identification: test/recovery/log_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class LogManagerTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log.0");
+    remove("test.log.1");
+    remove("test.alloc");
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log.0");
+    remove("test.log.1");
+    remove("test.alloc");
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, AppendTest) {
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::INTEGER);
+  Schema schema(columns);
+  Tuple tuple({ValueFactory::GetIntegerValue(15445)}, &schema);
+
+  // Scenario: without a flush thread, records stay in the buffer until someone waits for them.
+  LogRecord begin(0, INVALID_LSN, LogRecordType::BEGIN);
+  EXPECT_EQ(0, log_manager->AppendLogRecord(&begin));
+  LogRecord insert(0, 0, LogRecordType::INSERT, RID(3, 4), tuple);
+  EXPECT_EQ(1, log_manager->AppendLogRecord(&insert));
+  EXPECT_EQ(INVALID_LSN, log_manager->GetPersistentLSN());
+  log_manager->WaitUntilPersistent(1);
+  EXPECT_EQ(1, log_manager->GetPersistentLSN());
+  EXPECT_EQ(1, disk_manager->GetNumFlushes());
+
+  // Scenario: the records are in the log file in lsn order, with the layout described in log_record.h.
+  char buf[128];
+  ASSERT_TRUE(disk_manager->ReadLog(buf, sizeof(buf), 0));
+  EXPECT_EQ(20, *reinterpret_cast<int32_t *>(buf));
+  EXPECT_EQ(0, *reinterpret_cast<lsn_t *>(buf + 4));
+  EXPECT_EQ(LogRecordType::BEGIN, *reinterpret_cast<LogRecordType *>(buf + 16));
+  char *record = buf + 20;
+  EXPECT_EQ(insert.GetSize(), *reinterpret_cast<int32_t *>(record));
+  EXPECT_EQ(1, *reinterpret_cast<lsn_t *>(record + 4));
+  EXPECT_EQ(0, *reinterpret_cast<lsn_t *>(record + 12));
+  EXPECT_EQ(LogRecordType::INSERT, *reinterpret_cast<LogRecordType *>(record + 16));
+  EXPECT_EQ(RID(3, 4), *reinterpret_cast<RID *>(record + 20));
+  Tuple logged_tuple;
+  logged_tuple.DeserializeFrom(record + 20 + sizeof(RID));
+  EXPECT_EQ(15445, logged_tuple.GetValue(&schema, 0).GetAs<int32_t>());
+
+  // Scenario: a full buffer is written out to make room.
+  int flushes = disk_manager->GetNumFlushes();
+  for (int i = 0; i < LOG_BUFFER_SIZE / 20 + 1; i++) {
+    LogRecord commit(i, INVALID_LSN, LogRecordType::COMMIT);
+    log_manager->AppendLogRecord(&commit);
+  }
+  EXPECT_EQ(flushes + 1, disk_manager->GetNumFlushes());
+
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, GroupCommitTest) {
+  const int num_threads = 16;
+  const int commits_per_thread = 50;
+
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  auto lock_manager = std::make_unique<LockManager>();
+  auto txn_manager = std::make_unique<TransactionManager>(lock_manager.get(), log_manager.get());
+  lock_manager->txn_manager_ = txn_manager.get();
+
+  log_manager->RunFlushThread();
+  ASSERT_TRUE(enable_logging);
+
+  // Scenario: a commit returns only once its commit record is persistent, and concurrent commits share log writes.
+  std::vector<std::thread> threads;
+  std::atomic<int> not_persistent{0};
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < commits_per_thread; i++) {
+        auto *txn = txn_manager->Begin();
+        txn_manager->Commit(txn);
+        if (log_manager->GetPersistentLSN() < txn->GetPrevLSN()) {
+          not_persistent++;
+        }
+        delete txn;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, not_persistent);
+  EXPECT_EQ(2 * num_threads * commits_per_thread - 1, log_manager->GetPersistentLSN());
+  EXPECT_LT(disk_manager->GetNumFlushes(), num_threads * commits_per_thread);
+
+  log_manager->StopFlushThread();
+  EXPECT_FALSE(enable_logging);
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, WriteAheadTest) {
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  auto bpm = std::make_unique<BufferPoolManager>(4, disk_manager.get(), LRUK_REPLACER_K, log_manager.get());
+  log_manager->RunFlushThread();
+
+  LogRecord begin(0, INVALID_LSN, LogRecordType::BEGIN);
+  lsn_t lsn = log_manager->AppendLogRecord(&begin);
+
+  // Scenario: a page whose lsn was never set is written back without forcing the log, whatever its data looks like.
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  memset(page->GetData(), 0x7f, BUSTUB_PAGE_SIZE);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  EXPECT_TRUE(bpm->FlushPage(page_id));
+  EXPECT_EQ(INVALID_LSN, log_manager->GetPersistentLSN());
+
+  // Scenario: once it carries an lsn, it is written back only after the log up to that lsn.
+  page = bpm->FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  page->WLatch();
+  page->SetLSN(lsn);
+  page->WUnlatch();
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  EXPECT_TRUE(bpm->FlushPage(page_id));
+  EXPECT_EQ(lsn, log_manager->GetPersistentLSN());
+
+  log_manager->StopFlushThread();
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, ConcurrentAppendTest) {
+  const int num_threads = 8;
+  const int records_per_thread = 2000;
+
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  log_manager->RunFlushThread();
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::INTEGER);
+  columns.emplace_back("B", TypeId::VARCHAR, 64);
+  Schema schema(columns);
+
+  // Scenario: records appended concurrently, across many buffer swaps, all end up whole in the log.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < records_per_thread; i++) {
+        Tuple tuple({ValueFactory::GetIntegerValue(t), ValueFactory::GetVarcharValue(std::string(i % 64, 'a' + t))},
+                    &schema);
+        LogRecord record(t, INVALID_LSN, LogRecordType::INSERT, RID(t, i), tuple);
+        log_manager->AppendLogRecord(&record);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  log_manager->StopFlushThread();
+  EXPECT_EQ(num_threads * records_per_thread - 1, log_manager->GetPersistentLSN());
+
+  // Scenario: lsns have no gaps and follow the order of the records in the log.
+  std::vector<int> next_record(num_threads, 0);
+  int offset = 0;
+  char buf[LOG_BUFFER_SIZE];
+  for (lsn_t lsn = 0; lsn < num_threads * records_per_thread; lsn++) {
+    ASSERT_TRUE(disk_manager->ReadLog(buf, sizeof(buf), offset));
+    int32_t size = *reinterpret_cast<int32_t *>(buf);
+    ASSERT_EQ(lsn, *reinterpret_cast<lsn_t *>(buf + 4));
+    auto txn_id = *reinterpret_cast<txn_id_t *>(buf + 8);
+    ASSERT_EQ(RID(txn_id, next_record[txn_id]), *reinterpret_cast<RID *>(buf + 20));
+    Tuple tuple;
+    tuple.DeserializeFrom(buf + 20 + sizeof(RID));
+    EXPECT_EQ(txn_id, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+    EXPECT_EQ(std::string(next_record[txn_id] % 64, 'a' + txn_id), tuple.GetValue(&schema, 1).ToString());
+    next_record[txn_id]++;
+    offset += size;
+  }
+  EXPECT_FALSE(disk_manager->ReadLog(buf, sizeof(buf), offset));
+
+  disk_manager->ShutDown();
+}
+
+}  // namespace bustub
@@ -0,0 +1,428 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_recovery_test.cpp
+//
+// Identification: test/recovery/log_recovery_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "recovery/checkpoint_manager.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_recovery.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page_guard.h"
+#include "storage/page/table_page.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class LogRecoveryTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log.0");
+    remove("test.log.1");
+    remove("test.alloc");
+    remove("test.master");
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log.0");
+    remove("test.log.1");
+    remove("test.alloc");
+    remove("test.master");
+  }
+};
+
+// NOLINTNEXTLINE
+TEST_F(LogRecoveryTest, RedoUndoTest) {
+  const int num_committed = 1000;
+  const int num_lost = 100;
+  const size_t pool_size = 8;
+
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  auto lock_manager = std::make_unique<LockManager>();
+  auto txn_manager = std::make_unique<TransactionManager>(lock_manager.get(), log_manager.get());
+  lock_manager->txn_manager_ = txn_manager.get();
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::INTEGER);
+  Schema schema(columns);
+
+  std::vector<RID> committed;
+  std::vector<RID> lost;
+  page_id_t first_page_id;
+  {
+    auto bpm = std::make_unique<BufferPoolManager>(pool_size, disk_manager.get(), LRUK_REPLACER_K, log_manager.get());
+    log_manager->RunFlushThread();
+    TableHeap table_heap(bpm.get(), log_manager.get());
+    first_page_id = table_heap.GetFirstPageId();
+
+    auto *winner = txn_manager->Begin();
+    for (int i = 0; i < num_committed; i++) {
+      Tuple tuple({ValueFactory::GetIntegerValue(i)}, &schema);
+      committed.push_back(*table_heap.InsertTuple({INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple, nullptr, winner));
+    }
+    for (int i = 0; i < num_committed; i += 10) {
+      table_heap.UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, true}, committed[i], winner);
+    }
+    txn_manager->Commit(winner);
+    delete winner;
+
+    auto *loser = txn_manager->Begin();
+    for (int i = 0; i < num_lost; i++) {
+      Tuple tuple({ValueFactory::GetIntegerValue(-i)}, &schema);
+      lost.push_back(*table_heap.InsertTuple({INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple, nullptr, loser));
+    }
+    table_heap.UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, true}, committed[1], loser);
+    log_manager->WaitUntilPersistent(log_manager->GetNextLSN() - 1);
+    delete loser;
+
+    // Scenario: the system crashes, the dirty pages left in the buffer pool are never written back.
+    log_manager->StopFlushThread();
+  }
+  lsn_t next_lsn = log_manager->GetNextLSN();
+
+  auto bpm = std::make_unique<BufferPoolManager>(pool_size, disk_manager.get(), LRUK_REPLACER_K, log_manager.get());
+  log_manager = std::make_unique<LogManager>(disk_manager.get());
+  LogRecovery recovery(disk_manager.get(), bpm.get(), log_manager.get(), 3);
+  recovery.Redo();
+  EXPECT_EQ(1, recovery.GetNumLosers());
+  EXPECT_GT(recovery.GetNumRedone(), 0);
+  EXPECT_EQ(next_lsn, log_manager->GetNextLSN());
+  recovery.Undo();
+  EXPECT_EQ(num_lost + 1, recovery.GetNumUndone());
+
+  // Scenario: the committed changes are back, the ones of the loser are rolled back.
+  for (int i = 0; i < num_committed; i++) {
+    auto guard = bpm->FetchPageRead(committed[i].GetPageId());
+    auto [meta, tuple] = guard.As<TablePage>()->GetTuple(committed[i]);
+    EXPECT_EQ(i, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+    EXPECT_EQ(i % 10 == 0, meta.is_deleted_);
+  }
+  for (const auto &rid : lost) {
+    auto guard = bpm->FetchPageRead(rid.GetPageId());
+    EXPECT_TRUE(guard.As<TablePage>()->GetTupleMeta(rid).is_deleted_);
+  }
+
+  // Scenario: the pages are linked as before the crash.
+  int num_tuples = 0;
+  for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID;) {
+    auto guard = bpm->FetchPageRead(page_id);
+    num_tuples += guard.As<TablePage>()->GetNumTuples();
+    page_id = guard.As<TablePage>()->GetNextPageId();
+  }
+  EXPECT_EQ(num_committed + num_lost, num_tuples);
+
+  // Scenario: the loser is aborted in the log, recovering again finds nothing to do.
+  bpm = std::make_unique<BufferPoolManager>(pool_size, disk_manager.get(), LRUK_REPLACER_K, log_manager.get());
+  log_manager = std::make_unique<LogManager>(disk_manager.get());
+  LogRecovery second_recovery(disk_manager.get(), bpm.get(), log_manager.get());
+  second_recovery.Redo();
+  EXPECT_EQ(0, second_recovery.GetNumLosers());
+  EXPECT_EQ(0, second_recovery.GetNumRedone());
+  EXPECT_EQ(next_lsn + 1, log_manager->GetNextLSN());
+  second_recovery.Undo();
+  EXPECT_EQ(0, second_recovery.GetNumUndone());
+
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogRecoveryTest, CheckpointTest) {
+  const int num_tuples = 500;
+  const size_t pool_size = 8;
+
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  auto lock_manager = std::make_unique<LockManager>();
+  auto txn_manager = std::make_unique<TransactionManager>(lock_manager.get(), log_manager.get());
+  lock_manager->txn_manager_ = txn_manager.get();
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::INTEGER);
+  Schema schema(columns);
+
+  std::vector<RID> committed;
+  std::vector<RID> lost;
+  size_t num_records_before;
+  {
+    auto bpm = std::make_unique<BufferPoolManager>(pool_size, disk_manager.get(), LRUK_REPLACER_K, log_manager.get());
+    CheckpointManager checkpoint_manager(txn_manager.get(), log_manager.get(), bpm.get());
+    log_manager->RunFlushThread();
+    TableHeap table_heap(bpm.get(), log_manager.get());
+    auto insert = [&](Transaction *txn, int value, std::vector<RID> *rids) {
+      Tuple tuple({ValueFactory::GetIntegerValue(value)}, &schema);
+      rids->push_back(*table_heap.InsertTuple({INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple, nullptr, txn));
+    };
+
+    auto *loser = txn_manager->Begin();
+    auto *winner = txn_manager->Begin();
+    for (int i = 0; i < num_tuples; i++) {
+      insert(winner, i, &committed);
+      insert(loser, -i, &lost);
+    }
+    txn_manager->Commit(winner);
+    delete winner;
+    num_records_before = log_manager->GetNextLSN();
+
+    // Scenario: a checkpoint is taken while the loser is active and keeps changing pages.
+    checkpoint_manager.BeginCheckpoint();
+    insert(loser, -num_tuples, &lost);
+    checkpoint_manager.EndCheckpoint();
+
+    winner = txn_manager->Begin();
+    for (int i = num_tuples; i < num_tuples + num_tuples / 10; i++) {
+      insert(winner, i, &committed);
+      insert(loser, -i - 1, &lost);
+    }
+    txn_manager->Commit(winner);
+    delete winner;
+    log_manager->WaitUntilPersistent(log_manager->GetNextLSN() - 1);
+    delete loser;
+
+    // Scenario: the system crashes, the dirty pages left in the buffer pool are never written back.
+    log_manager->StopFlushThread();
+  }
+
+  // Scenario: recovery starts at the checkpoint but still rolls back all changes of the loser.
+  auto bpm = std::make_unique<BufferPoolManager>(pool_size, disk_manager.get(), LRUK_REPLACER_K, log_manager.get());
+  log_manager = std::make_unique<LogManager>(disk_manager.get());
+  LogRecovery recovery(disk_manager.get(), bpm.get(), log_manager.get(), 2);
+  recovery.Redo();
+  EXPECT_GT(recovery.GetRedoStart(), 0);
+  EXPECT_LT(recovery.GetNumRecords(), num_records_before);
+  EXPECT_EQ(1, recovery.GetNumLosers());
+  recovery.Undo();
+  EXPECT_EQ(lost.size(), recovery.GetNumUndone());
+
+  for (size_t i = 0; i < committed.size(); i++) {
+    auto guard = bpm->FetchPageRead(committed[i].GetPageId());
+    auto [meta, tuple] = guard.As<TablePage>()->GetTuple(committed[i]);
+    EXPECT_EQ(i, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+    EXPECT_FALSE(meta.is_deleted_);
+  }
+  for (const auto &rid : lost) {
+    auto guard = bpm->FetchPageRead(rid.GetPageId());
+    EXPECT_TRUE(guard.As<TablePage>()->GetTupleMeta(rid).is_deleted_);
+  }
+
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogRecoveryTest, CheckpointDuringWriteBackTest) {
+  // holds the write of one page until released, and drops all writes once the system has crashed
+  class SlowDiskManager : public DiskManager {
+   public:
+    using DiskManager::DiskManager;
+    void WritePage(page_id_t page_id, const char *page_data) override {
+      if (page_id == slow_page_id_) {
+        std::unique_lock<std::mutex> lock(latch_);
+        writing_ = true;
+        cv_.notify_all();
+        cv_.wait(lock, [this] { return released_; });
+      }
+      if (!crashed_) {
+        DiskManager::WritePage(page_id, page_data);
+      }
+    }
+    void WaitForWrite() {
+      std::unique_lock<std::mutex> lock(latch_);
+      cv_.wait(lock, [this] { return writing_; });
+    }
+    void Release() {
+      std::scoped_lock<std::mutex> lock(latch_);
+      released_ = true;
+      cv_.notify_all();
+    }
+    std::atomic<page_id_t> slow_page_id_{INVALID_PAGE_ID};
+    std::atomic<bool> crashed_{false};
+
+   private:
+    std::mutex latch_;
+    std::condition_variable cv_;
+    bool writing_{false};
+    bool released_{false};
+  };
+  const size_t pool_size = 8;
+
+  auto disk_manager = std::make_unique<SlowDiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  auto lock_manager = std::make_unique<LockManager>();
+  auto txn_manager = std::make_unique<TransactionManager>(lock_manager.get(), log_manager.get());
+  lock_manager->txn_manager_ = txn_manager.get();
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::INTEGER);
+  Schema schema(columns);
+
+  std::vector<RID> committed;
+  {
+    auto bpm = std::make_unique<BufferPoolManager>(pool_size, disk_manager.get(), LRUK_REPLACER_K, log_manager.get());
+    CheckpointManager checkpoint_manager(txn_manager.get(), log_manager.get(), bpm.get());
+    log_manager->RunFlushThread();
+    TableHeap table_heap(bpm.get(), log_manager.get());
+    auto insert = [&](int value) {
+      auto *txn = txn_manager->Begin();
+      Tuple tuple({ValueFactory::GetIntegerValue(value)}, &schema);
+      committed.push_back(*table_heap.InsertTuple({INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple, nullptr, txn));
+      txn_manager->Commit(txn);
+      delete txn;
+    };
+
+    // Scenario: a checkpoint begins while the page is clean, a committed insert changes it afterwards.
+    insert(0);
+    bpm->FlushAllPages();
+    page_id_t page_id = table_heap.GetFirstPageId();
+    checkpoint_manager.BeginCheckpoint();
+    insert(1);
+
+    // Scenario: the checkpoint ends while a write-back of the page is in flight.
+    disk_manager->slow_page_id_ = page_id;
+    std::thread flusher([&] { bpm->FlushPage(page_id); });
+    disk_manager->WaitForWrite();
+    checkpoint_manager.EndCheckpoint();
+
+    // Scenario: the system crashes before the write-back lands.
+    disk_manager->crashed_ = true;
+    disk_manager->Release();
+    flusher.join();
+    log_manager->StopFlushThread();
+  }
+
+  // Scenario: the checkpoint listed the page with a recovery lsn from before the insert, recovery redoes it.
+  auto bpm = std::make_unique<BufferPoolManager>(pool_size, disk_manager.get(), LRUK_REPLACER_K, log_manager.get());
+  log_manager = std::make_unique<LogManager>(disk_manager.get());
+  LogRecovery recovery(disk_manager.get(), bpm.get(), log_manager.get());
+  recovery.Redo();
+  EXPECT_GT(recovery.GetRedoStart(), 0);
+  recovery.Undo();
+  for (size_t i = 0; i < committed.size(); i++) {
+    auto guard = bpm->FetchPageRead(committed[i].GetPageId());
+    ASSERT_GT(guard.As<TablePage>()->GetNumTuples(), committed[i].GetSlotNum());
+    auto [meta, tuple] = guard.As<TablePage>()->GetTuple(committed[i]);
+    EXPECT_EQ(i, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+    EXPECT_FALSE(meta.is_deleted_);
+  }
+
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogRecoveryTest, ReusedPageTest) {
+  const int num_tuples = 10;
+  const size_t pool_size = 8;
+
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  auto lock_manager = std::make_unique<LockManager>();
+  auto txn_manager = std::make_unique<TransactionManager>(lock_manager.get(), log_manager.get());
+  lock_manager->txn_manager_ = txn_manager.get();
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::INTEGER);
+  Schema schema(columns);
+
+  std::vector<RID> committed;
+  page_id_t first_page_id;
+  {
+    auto bpm = std::make_unique<BufferPoolManager>(pool_size, disk_manager.get(), LRUK_REPLACER_K, log_manager.get());
+    log_manager->RunFlushThread();
+    TableHeap table_heap(bpm.get(), log_manager.get());
+    first_page_id = table_heap.GetFirstPageId();
+
+    auto *winner = txn_manager->Begin();
+    for (int i = 0; i < num_tuples; i++) {
+      Tuple tuple({ValueFactory::GetIntegerValue(i)}, &schema);
+      committed.push_back(*table_heap.InsertTuple({INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple, nullptr, winner));
+    }
+    txn_manager->Commit(winner);
+    delete winner;
+
+    // Scenario: the system crashes, the dirty pages left in the buffer pool are never written back.
+    log_manager->StopFlushThread();
+  }
+
+  // Scenario: the page id had been used by a b+ tree page before, which is what the disk still holds. Its size is
+  // where a table page keeps its lsn and is larger than any lsn in the log.
+  char stale[BUSTUB_PAGE_SIZE] = {};
+  int32_t size = 1 << 20;
+  memcpy(stale + 4, &size, sizeof(int32_t));
+  disk_manager->WritePage(first_page_id, stale);
+
+  // Scenario: recovery initializes the page anew and redoes the inserts on it.
+  auto bpm = std::make_unique<BufferPoolManager>(pool_size, disk_manager.get(), LRUK_REPLACER_K, log_manager.get());
+  log_manager = std::make_unique<LogManager>(disk_manager.get());
+  LogRecovery recovery(disk_manager.get(), bpm.get(), log_manager.get());
+  recovery.Redo();
+  recovery.Undo();
+  {
+    auto guard = bpm->FetchPageRead(first_page_id);
+    EXPECT_TRUE(guard.As<TablePage>()->IsTablePage());
+    EXPECT_EQ(num_tuples, guard.As<TablePage>()->GetNumTuples());
+  }
+  for (int i = 0; i < num_tuples; i++) {
+    auto guard = bpm->FetchPageRead(committed[i].GetPageId());
+    auto [meta, tuple] = guard.As<TablePage>()->GetTuple(committed[i]);
+    EXPECT_EQ(i, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+    EXPECT_FALSE(meta.is_deleted_);
+  }
+
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogRecoveryTest, TornTailTest) {
+  auto disk_manager = std::make_unique<DiskManager>("test.db");
+  auto log_manager = std::make_unique<LogManager>(disk_manager.get());
+  for (txn_id_t txn_id = 0; txn_id < 10; txn_id++) {
+    LogRecord commit(txn_id, INVALID_LSN, LogRecordType::COMMIT);
+    log_manager->AppendLogRecord(&commit);
+  }
+  log_manager->WaitUntilPersistent(9);
+  size_t log_size = disk_manager->GetLogFileSize();
+
+  // Scenario: the crash cut the last record off, recovery drops it and the log goes on after the last whole one.
+  char torn[30] = {};
+  int32_t size = 100;
+  memcpy(torn, &size, sizeof(int32_t));
+  disk_manager->WriteLog(torn, sizeof(torn));
+  ASSERT_EQ(log_size + sizeof(torn), disk_manager->GetLogFileSize());
+
+  auto bpm = std::make_unique<BufferPoolManager>(8, disk_manager.get(), LRUK_REPLACER_K, log_manager.get());
+  log_manager = std::make_unique<LogManager>(disk_manager.get());
+  LogRecovery recovery(disk_manager.get(), bpm.get(), log_manager.get());
+  recovery.Redo();
+  recovery.Undo();
+  EXPECT_EQ(10, recovery.GetNumRecords());
+  EXPECT_EQ(log_size, recovery.GetLogSize());
+  EXPECT_EQ(log_size, disk_manager->GetLogFileSize());
+  EXPECT_EQ(10, log_manager->GetNextLSN());
+
+  disk_manager->ShutDown();
+}
+
+}  // namespace bustub
@@ -10,10 +10,18 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <unistd.h>
+#include <atomic>
 #include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
+#include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
@@ -23,13 +31,19 @@ class DiskManagerTest : public ::testing::Test {
   // This function is called before every test.
   void SetUp() override {
     remove("test.db");
-    remove("test.log");
+    remove("test.log.0");
+    remove("test.log.1");
+    remove("test.alloc");
+    remove("test.warm");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
-    remove("test.log");
+    remove("test.log.0");
+    remove("test.log.1");
+    remove("test.alloc");
+    remove("test.warm");
   };
 };
 
@@ -55,6 +69,102 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  std::vector<std::vector<char>> data(3, std::vector<char>(BUSTUB_PAGE_SIZE));
+  std::vector<const char *> pages_data;
+  for (size_t i = 0; i < data.size(); i++) {
+    std::memset(data[i].data(), 'a' + i, BUSTUB_PAGE_SIZE);
+    pages_data.push_back(data[i].data());
+  }
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Scenario: a vectored write lands every page at its own offset, also past the end of the file.
+  dm.WritePages(2, pages_data);
+  dm.SyncPages();
+  for (size_t i = 0; i < data.size(); i++) {
+    dm.ReadPage(2 + i, buf);
+    EXPECT_EQ(std::memcmp(buf, data[i].data(), sizeof(buf)), 0);
+  }
+  EXPECT_EQ(3, dm.GetNumWrites());
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWriteTest) {
+  const int num_threads = 4;
+  const int pages_per_thread = 64;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Scenario: threads writing and reading back their own pages do not see each other's data.
+  std::vector<std::thread> threads;
+  std::atomic<int> mismatches{0};
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&dm, &mismatches, t] {
+      char data[BUSTUB_PAGE_SIZE];
+      char buf[BUSTUB_PAGE_SIZE];
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id = i * num_threads + t;
+        std::memset(data, 'a' + t, sizeof(data));
+        std::memcpy(data, &page_id, sizeof(page_id));
+        dm.WritePage(page_id, data);
+        dm.ReadPage(page_id, buf);
+        if (std::memcmp(buf, data, sizeof(buf)) != 0) {
+          mismatches++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, mismatches);
+  EXPECT_EQ(num_threads * pages_per_thread, dm.GetNumWrites());
+
+  // Scenario: a page past the end of the file reads as zeros.
+  char buf[BUSTUB_PAGE_SIZE];
+  std::memset(buf, 'x', sizeof(buf));
+  dm.ReadPage(num_threads * pages_per_thread + 1, buf);
+  EXPECT_EQ(std::string(BUSTUB_PAGE_SIZE, '\0'), std::string(buf, BUSTUB_PAGE_SIZE));
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIOTest) {
+  std::string db_file("test.db");
+  // file systems without O_DIRECT support fall back to buffered I/O, which must behave the same
+  auto dm = DiskManager(db_file, DiskIOMode::Direct);
+
+  alignas(DIRECT_IO_ALIGNMENT) char aligned[2][BUSTUB_PAGE_SIZE];
+  std::memset(aligned[0], 'a', BUSTUB_PAGE_SIZE);
+  std::memset(aligned[1], 'b', BUSTUB_PAGE_SIZE);
+
+  // Scenario: aligned single and batched transfers.
+  dm.WritePages(0, {aligned[0], aligned[1]});
+  alignas(DIRECT_IO_ALIGNMENT) char read_back[2][BUSTUB_PAGE_SIZE];
+  dm.ReadPages(0, {read_back[0], read_back[1]});
+  EXPECT_EQ(0, std::memcmp(read_back[0], aligned[0], BUSTUB_PAGE_SIZE));
+  EXPECT_EQ(0, std::memcmp(read_back[1], aligned[1], BUSTUB_PAGE_SIZE));
+
+  // Scenario: buffers that are not aligned go through a bounce buffer.
+  auto unaligned = std::make_unique<char[]>(BUSTUB_PAGE_SIZE + 1);
+  std::memset(unaligned.get() + 1, 'c', BUSTUB_PAGE_SIZE);
+  dm.WritePage(2, unaligned.get() + 1);
+  std::memset(unaligned.get() + 1, 0, BUSTUB_PAGE_SIZE);
+  dm.ReadPage(2, unaligned.get() + 1);
+  EXPECT_EQ(std::string(BUSTUB_PAGE_SIZE, 'c'), std::string(unaligned.get() + 1, BUSTUB_PAGE_SIZE));
+  dm.ReadPages(1, {read_back[0], unaligned.get() + 1});
+  EXPECT_EQ(0, std::memcmp(read_back[0], aligned[1], BUSTUB_PAGE_SIZE));
+  EXPECT_EQ(std::string(BUSTUB_PAGE_SIZE, 'c'), std::string(unaligned.get() + 1, BUSTUB_PAGE_SIZE));
+
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
@@ -65,6 +175,7 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
 
   dm.ReadLog(buf, sizeof(buf), 0);  // tolerate empty read
 
+  dm.PrepareLogSegments();
   dm.WriteLog(data, sizeof(data));
   dm.ReadLog(buf, sizeof(buf), 0);
   EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
@@ -72,6 +183,110 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LogSegmentTest) {
+  std::string db_file("test.db");
+  std::vector<char> buffers[2] = {std::vector<char>(LOG_BUFFER_SIZE), std::vector<char>(LOG_BUFFER_SIZE)};
+  std::vector<char> buf(1024);
+  auto matches = [&buf](size_t offset) {
+    for (size_t i = 0; i < buf.size(); i++) {
+      if (buf[i] != static_cast<char>((offset + i) % 251)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  size_t log_size = 0;
+  {
+    auto dm = DiskManager(db_file);
+
+    // Scenario: a log write never creates a segment, they are created ahead of the writes that go to them.
+    EXPECT_THROW(dm.WriteLog(buffers[1].data(), static_cast<int>(buffers[1].size())), std::logic_error);
+    EXPECT_FALSE(std::filesystem::exists("test.log.0"));
+    dm.PrepareLogSegments();
+    EXPECT_EQ(0, dm.GetLogFileSize());
+    EXPECT_EQ(static_cast<uintmax_t>(LOG_SEGMENT_SIZE), std::filesystem::file_size("test.log.0"));
+    EXPECT_EQ(static_cast<uintmax_t>(LOG_SEGMENT_SIZE), std::filesystem::file_size("test.log.1"));
+
+    for (size_t i = 0; log_size < LOG_SEGMENT_SIZE + LOG_BUFFER_SIZE; i++) {
+      auto &buffer = buffers[i % 2];
+      for (size_t j = 0; j < buffer.size(); j++) {
+        buffer[j] = static_cast<char>((log_size + j) % 251);
+      }
+      dm.WriteLog(buffer.data(), static_cast<int>(buffer.size()));
+      log_size += buffer.size();
+      dm.PrepareLogSegments();
+    }
+    EXPECT_EQ(log_size, dm.GetLogFileSize());
+    EXPECT_EQ(static_cast<uintmax_t>(LOG_SEGMENT_SIZE), std::filesystem::file_size("test.log.2"));
+    EXPECT_FALSE(std::filesystem::exists("test.log.3"));
+
+    // Scenario: a read crosses the end of the first segment.
+    ASSERT_TRUE(dm.ReadLog(buf.data(), static_cast<int>(buf.size()), LOG_SEGMENT_SIZE - 512));
+    EXPECT_TRUE(matches(LOG_SEGMENT_SIZE - 512));
+
+    // Scenario: the first segment is no longer needed and becomes a spare after the current one.
+    dm.RecycleLogSegments(LOG_SEGMENT_SIZE);
+    EXPECT_FALSE(dm.ReadLog(buf.data(), static_cast<int>(buf.size()), 0));
+    EXPECT_FALSE(std::filesystem::exists("test.log.0"));
+    EXPECT_EQ(static_cast<uintmax_t>(LOG_SEGMENT_SIZE), std::filesystem::file_size("test.log.3"));
+    ASSERT_TRUE(dm.ReadLog(buf.data(), static_cast<int>(buf.size()), LOG_SEGMENT_SIZE));
+    EXPECT_TRUE(matches(LOG_SEGMENT_SIZE));
+    dm.ShutDown();
+  }
+
+  // Scenario: until it is truncated, the reopened log ends with its last segment and can not be appended to.
+  {
+    auto dm = DiskManager(db_file);
+    EXPECT_EQ(4 * static_cast<size_t>(LOG_SEGMENT_SIZE), dm.GetLogFileSize());
+    EXPECT_FALSE(dm.IsLogRecovered());
+    EXPECT_THROW(dm.WriteLog(buffers[0].data(), static_cast<int>(buffers[0].size())), std::logic_error);
+    EXPECT_THROW(LogManager(&dm).RunFlushThread(), std::logic_error);
+    dm.TruncateLog(log_size);
+    EXPECT_TRUE(dm.IsLogRecovered());
+    EXPECT_EQ(log_size, dm.GetLogFileSize());
+    ASSERT_TRUE(dm.ReadLog(buf.data(), static_cast<int>(buf.size()), log_size - buf.size()));
+    EXPECT_TRUE(matches(log_size - buf.size()));
+    dm.ShutDown();
+  }
+  remove("test.log.1");
+  remove("test.log.2");
+  remove("test.log.3");
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WarmupListTest) {
+  std::string db_file("test.db");
+  std::vector<page_id_t> page_ids{5, 1, 3};
+  {
+    auto dm = DiskManager(db_file);
+    EXPECT_EQ(std::vector<page_id_t>{}, dm.ReadWarmupList());
+    dm.WriteWarmupList(page_ids);
+    EXPECT_EQ(page_ids, dm.ReadWarmupList());
+    dm.ShutDown();
+  }
+
+  // Scenario: the list survives a restart, but not the removal of the db file it belongs to.
+  {
+    auto dm = DiskManager(db_file);
+    EXPECT_EQ(page_ids, dm.ReadWarmupList());
+    dm.ShutDown();
+  }
+  remove("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    EXPECT_EQ(std::vector<page_id_t>{}, dm.ReadWarmupList());
+    dm.WriteWarmupList(page_ids);
+    dm.ShutDown();
+  }
+
+  // Scenario: a truncated list is ignored.
+  truncate("test.warm", sizeof(uint64_t) + sizeof(page_id_t));
+  auto dm = DiskManager(db_file);
+  EXPECT_EQ(std::vector<page_id_t>{}, dm.ReadWarmupList());
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
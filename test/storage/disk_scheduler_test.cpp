@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler_test.cpp
+//
+// Identification: test/storage/disk_scheduler_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/disk_scheduler.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(DiskSchedulerTest, ScheduleTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  auto dm = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto scheduler = std::make_unique<DiskScheduler>(dm.get());
+
+  // Scenario: a read scheduled after the write of the same page completed sees the data.
+  EXPECT_EQ(true, scheduler->ScheduleWrite(0, data).get());
+  EXPECT_EQ(true, scheduler->ScheduleRead(0, buf).get());
+  EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+
+  // Scenario: requests scheduled with their own promises complete before the scheduler is gone.
+  auto promise = DiskScheduler::CreatePromise();
+  auto future = promise.get_future();
+  scheduler->Schedule({true, data, 1, std::move(promise)});
+  scheduler.reset();
+  EXPECT_EQ(true, future.get());
+}
+
+// NOLINTNEXTLINE
+TEST(DiskSchedulerTest, CoalesceTest) {
+  class BatchDiskManager : public DiskManagerUnlimitedMemory {
+   public:
+    void WritePage(page_id_t page_id, const char *page_data) override {
+      // the first write holds the only worker until the test queued the rest
+      if (page_id == 0) {
+        release_.get_future().wait();
+      }
+      DiskManagerUnlimitedMemory::WritePage(page_id, page_data);
+    }
+    void WritePages(page_id_t first_page_id, const std::vector<const char *> &pages_data) override {
+      std::scoped_lock<std::mutex> lock(mutex_);
+      write_runs_.emplace_back(first_page_id, pages_data.size());
+      DiskManager::WritePages(first_page_id, pages_data);
+    }
+    void ReadPages(page_id_t first_page_id, const std::vector<char *> &pages_data) override {
+      std::scoped_lock<std::mutex> lock(mutex_);
+      read_runs_.emplace_back(first_page_id, pages_data.size());
+      DiskManager::ReadPages(first_page_id, pages_data);
+    }
+    std::promise<void> release_;
+    std::mutex mutex_;
+    std::vector<std::pair<page_id_t, size_t>> write_runs_;
+    std::vector<std::pair<page_id_t, size_t>> read_runs_;
+  };
+
+  std::vector<std::vector<char>> data(6, std::vector<char>(BUSTUB_PAGE_SIZE));
+  for (size_t i = 0; i < data.size(); i++) {
+    std::memset(data[i].data(), 'a' + i, BUSTUB_PAGE_SIZE);
+  }
+  auto dm = std::make_unique<BatchDiskManager>();
+  auto scheduler = std::make_unique<DiskScheduler>(dm.get(), 1);
+
+  // Scenario: adjacent writes queued one by one and out of order go to disk in one call, others are left alone.
+  std::vector<std::future<bool>> futures;
+  futures.push_back(scheduler->ScheduleWrite(0, data[0].data()));
+  for (page_id_t page_id : {4, 2, 5, 3}) {
+    futures.push_back(scheduler->ScheduleWrite(page_id, data[page_id].data()));
+  }
+  dm->release_.set_value();
+  for (auto &future : futures) {
+    EXPECT_EQ(true, future.get());
+  }
+  EXPECT_EQ((std::vector<std::pair<page_id_t, size_t>>{{2, 4}}), dm->write_runs_);
+
+  // Scenario: reads scheduled together are coalesced the same way, and each buffer gets its own page.
+  std::vector<std::vector<char>> bufs(4, std::vector<char>(BUSTUB_PAGE_SIZE));
+  std::vector<DiskRequest> requests;
+  futures.clear();
+  for (page_id_t page_id : {3, 2, 5, 4}) {
+    auto promise = DiskScheduler::CreatePromise();
+    futures.push_back(promise.get_future());
+    requests.push_back({false, bufs[page_id - 2].data(), page_id, std::move(promise)});
+  }
+  scheduler->Schedule(std::move(requests));
+  for (auto &future : futures) {
+    EXPECT_EQ(true, future.get());
+  }
+  EXPECT_EQ((std::vector<std::pair<page_id_t, size_t>>{{2, 4}}), dm->read_runs_);
+  for (size_t i = 0; i < bufs.size(); i++) {
+    EXPECT_EQ(data[i + 2], bufs[i]);
+  }
+}
+
+}  // namespace bustub
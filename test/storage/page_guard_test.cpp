@@ -11,8 +11,11 @@
 //===----------------------------------------------------------------------===//
 
 #include <cstdio>
+#include <cstring>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "storage/disk/disk_manager_memory.h"
@@ -48,4 +51,70 @@ TEST(PageGuardTest, SampleTest) {
   disk_manager->ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST(PageGuardTest, OptimisticReadTest) {
+  const size_t buffer_pool_size = 5;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_shared<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_shared<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+
+  // Scenario: an optimistic guard pins the page without taking its latch, and stays valid until a writer latches it.
+  {
+    auto guard = bpm->FetchPageOptimistic(page_id_temp);
+    EXPECT_EQ(1, page0->GetPinCount());
+    EXPECT_EQ(true, guard.Validate());
+    {
+      auto reader = bpm->FetchPageRead(page_id_temp);
+      EXPECT_EQ(true, guard.Validate());
+    }
+    {
+      auto writer = bpm->FetchPageWrite(page_id_temp);
+      writer.GetDataMut()[0] = 'a';
+      EXPECT_EQ(false, guard.Validate());
+    }
+    EXPECT_EQ(false, guard.Validate());
+  }
+  EXPECT_EQ(0, page0->GetPinCount());
+
+  // Scenario: upgrading keeps the single pin and takes the read latch.
+  {
+    auto guard = bpm->FetchPageOptimistic(page_id_temp);
+    auto reader = guard.UpgradeRead();
+    EXPECT_EQ(false, guard.IsValid());
+    EXPECT_EQ(1, page0->GetPinCount());
+    EXPECT_EQ('a', reader.GetData()[0]);
+  }
+  EXPECT_EQ(0, page0->GetPinCount());
+
+  // Scenario: a validated read never sees a half written page.
+  {
+    auto guard = bpm->FetchPageWrite(page_id_temp);
+    memset(guard.GetDataMut(), 'a', 64);
+  }
+  std::thread writer([&bpm, page_id_temp] {
+    for (char i = 0; i < 100; ++i) {
+      auto guard = bpm->FetchPageWrite(page_id_temp);
+      char *data = guard.GetDataMut();
+      for (size_t j = 0; j < 64; ++j) {
+        data[j] = i;
+      }
+    }
+  });
+  for (size_t i = 0; i < 1000; ++i) {
+    auto guard = bpm->FetchPageOptimistic(page_id_temp);
+    std::vector<char> copy(guard.GetData(), guard.GetData() + 64);
+    if (guard.Validate()) {
+      EXPECT_EQ(std::vector<char>(64, copy[0]), copy);
+    }
+  }
+  writer.join();
+
+  disk_manager->ShutDown();
+}
+
 }  // namespace bustub
@@ -1,4 +1,9 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -13,12 +18,13 @@
 #include "argparse/argparse.hpp"
 #include "binder/binder.h"
 #include "buffer/buffer_pool_manager.h"
-#include "buffer/lru_k_replacer.h"
+#include "buffer/replacer.h"
 #include "common/config.h"
 #include "common/exception.h"
 #include "common/util/string_util.h"
 #include "fmt/core.h"
 #include "fmt/std.h"
+#include "storage/disk/disk_manager.h"
 #include "storage/disk/disk_manager_memory.h"
 
 #include <sys/time.h>
@@ -34,6 +40,52 @@ static const size_t BUSTUB_GET_THREAD = 8;
 static const size_t LRU_K_SIZE = 16;
 static const size_t BUSTUB_PAGE_CNT = 6400;
 static const size_t BUSTUB_BPM_SIZE = 64;
+static const size_t BUSTUB_MAX_SCALING_THREAD = 64;
+
+/**
+ * Disk manager that counts the reads of every page, which tells a buffer pool miss from a hit. Reads are carried out
+ * by the threads of the disk scheduler, so they are counted by page rather than by the thread that fetched the page.
+ * Base is the in-memory disk manager by default, or the file based one with --db-file.
+ */
+template <typename Base>
+class CountingDiskManager : public Base {
+ public:
+  using Base::Base;
+
+  void ReadPage(bustub::page_id_t page_id, char *page_data) override {
+    CountRead(page_id);
+    Base::ReadPage(page_id, page_data);
+  }
+
+  void ReadPages(bustub::page_id_t first_page_id, const std::vector<char *> &pages_data) override {
+    // without a db file the base class reads page by page through ReadPage(), which counts already
+    if (this->db_fd_ >= 0) {
+      for (size_t i = 0; i < pages_data.size(); i++) {
+        CountRead(first_page_id + static_cast<bustub::page_id_t>(i));
+      }
+    }
+    Base::ReadPages(first_page_id, pages_data);
+  }
+
+ private:
+  static void CountRead(bustub::page_id_t page_id);
+};
+
+/** Reads of every page so far, see CountingDiskManager. Sized by main() once the number of pages is known. */
+static std::unique_ptr<std::atomic<uint64_t>[]> reads_of_page;
+static size_t reads_of_page_cnt = 0;
+
+template <typename Base>
+void CountingDiskManager<Base>::CountRead(bustub::page_id_t page_id) {
+  if (page_id >= 0 && static_cast<size_t>(page_id) < reads_of_page_cnt) {
+    reads_of_page[page_id]++;
+  }
+}
+
+/** @return the number of times the page was read so far */
+auto Reads(bustub::page_id_t page_id) -> uint64_t {
+  return page_id >= 0 && static_cast<size_t>(page_id) < reads_of_page_cnt ? reads_of_page[page_id].load() : 0;
+}
 
 struct BpmTotalMetrics {
   uint64_t scan_cnt_{0};
@@ -100,16 +152,433 @@ struct BpmMetrics {
   }
 };
 
+/**
+ * Run the same zipfian point-lookup workload with 1, 2, 4, ..., BUSTUB_MAX_SCALING_THREAD threads and report how
+ * the throughput scales with the number of threads.
+ */
+void RunScaling(bustub::BufferPoolManager *bpm, const std::vector<bustub::page_id_t> &page_ids,
+                uint64_t duration_ms) {
+  using bustub::AccessType;
+
+  size_t steps = 0;
+  for (size_t thread_cnt = 1; thread_cnt <= BUSTUB_MAX_SCALING_THREAD; thread_cnt *= 2) {
+    steps++;
+  }
+  uint64_t step_ms = std::max<uint64_t>(duration_ms / steps, 1);
+  double base_throughput = 0;
+
+  fmt::print("<<< BEGIN\n");
+  for (size_t thread_cnt = 1; thread_cnt <= BUSTUB_MAX_SCALING_THREAD; thread_cnt *= 2) {
+    BpmTotalMetrics total_metrics;
+    total_metrics.Begin();
+
+    std::vector<std::thread> threads;
+    for (size_t thread_id = 0; thread_id < thread_cnt; thread_id++) {
+      threads.emplace_back([bpm, &page_ids, step_ms, &total_metrics] {
+        std::random_device r;
+        std::default_random_engine gen(r());
+        zipfian_int_distribution<size_t> dist(0, page_ids.size() - 1, 0.8);
+
+        uint64_t cnt = 0;
+        uint64_t start = ClockMs();
+        while (ClockMs() - start < step_ms) {
+          auto page_idx = dist(gen);
+          auto *page = bpm->FetchPage(page_ids[page_idx], AccessType::Get);
+          if (page == nullptr) {
+            continue;
+          }
+
+          page->RLatch();
+          char ch = page->GetData()[page_idx % 1024];
+          page->RUnlatch();
+          if (ch == 0) {
+            throw std::runtime_error("invalid data");
+          }
+
+          bpm->UnpinPage(page->GetPageId(), false, AccessType::Get);
+          cnt++;
+        }
+
+        total_metrics.ReportGet(cnt);
+      });
+    }
+
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    auto elapsed = std::max<uint64_t>(ClockMs() - total_metrics.start_time_, 1);
+    auto throughput = total_metrics.get_cnt_ / static_cast<double>(elapsed) * 1000;
+    if (thread_cnt == 1) {
+      base_throughput = throughput;
+    }
+    fmt::print("threads={:<3} get: {:<12.3f} speedup: {:.2f}x\n", thread_cnt, throughput,
+               base_throughput > 0 ? throughput / base_throughput : 0);
+  }
+  fmt::print(">>> END\n");
+}
+
+/**
+ * Measure the latency of buffer pool hits while other threads keep missing on cold pages. Half of the pool is pinned
+ * by the benchmark itself so that the get threads always hit, the scan threads walk over the remaining pages and pay
+ * the disk latency on every fetch.
+ */
+void RunHitLatency(bustub::BufferPoolManager *bpm, const std::vector<bustub::page_id_t> &page_ids, size_t bpm_size,
+                   uint64_t duration_ms) {
+  using bustub::AccessType;
+
+  size_t hot_cnt = std::max<size_t>(bpm_size / 2, 1);
+  for (size_t i = 0; i < hot_cnt; i++) {
+    if (bpm->FetchPage(page_ids[i], AccessType::Get) == nullptr) {
+      throw std::runtime_error("cannot pin hot page");
+    }
+  }
+
+  BpmTotalMetrics total_metrics;
+  total_metrics.Begin();
+
+  std::mutex latency_mutex;
+  std::vector<uint64_t> hit_latency_us;
+  std::vector<std::thread> threads;
+
+  for (size_t thread_id = 0; thread_id < BUSTUB_SCAN_THREAD; thread_id++) {
+    threads.emplace_back([thread_id, bpm, &page_ids, hot_cnt, duration_ms, &total_metrics] {
+      BpmMetrics metrics(fmt::format("miss {:>2}", thread_id), duration_ms);
+      metrics.Begin();
+
+      size_t cold_cnt = page_ids.size() - hot_cnt;
+      size_t page_idx = cold_cnt * thread_id / BUSTUB_SCAN_THREAD;
+      while (!metrics.ShouldFinish()) {
+        auto *page = bpm->FetchPage(page_ids[hot_cnt + page_idx], AccessType::Get);
+        page_idx = (page_idx + 1) % cold_cnt;
+        if (page == nullptr) {
+          continue;
+        }
+        bpm->UnpinPage(page->GetPageId(), false, AccessType::Get);
+        metrics.Tick();
+        metrics.Report();
+      }
+
+      total_metrics.ReportScan(metrics.cnt_);
+    });
+  }
+
+  for (size_t thread_id = 0; thread_id < BUSTUB_GET_THREAD; thread_id++) {
+    threads.emplace_back([thread_id, bpm, &page_ids, hot_cnt, duration_ms, &total_metrics, &latency_mutex,
+                          &hit_latency_us] {
+      std::random_device r;
+      std::default_random_engine gen(r());
+      std::uniform_int_distribution<size_t> dist(0, hot_cnt - 1);
+      std::vector<uint64_t> latency_us;
+
+      BpmMetrics metrics(fmt::format("hit  {:>2}", thread_id), duration_ms);
+      metrics.Begin();
+
+      while (!metrics.ShouldFinish()) {
+        auto page_idx = dist(gen);
+        auto start = std::chrono::steady_clock::now();
+        auto *page = bpm->FetchPage(page_ids[page_idx], AccessType::Get);
+        auto end = std::chrono::steady_clock::now();
+        if (page == nullptr) {
+          throw std::runtime_error("hot page is not resident");
+        }
+        latency_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+
+        bpm->UnpinPage(page->GetPageId(), false, AccessType::Get);
+        metrics.Tick();
+        metrics.Report();
+      }
+
+      total_metrics.ReportGet(metrics.cnt_);
+      std::unique_lock<std::mutex> l(latency_mutex);
+      hit_latency_us.insert(hit_latency_us.end(), latency_us.begin(), latency_us.end());
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (size_t i = 0; i < hot_cnt; i++) {
+    bpm->UnpinPage(page_ids[i], false, AccessType::Get);
+  }
+
+  std::sort(hit_latency_us.begin(), hit_latency_us.end());
+  uint64_t sum = 0;
+  for (auto latency : hit_latency_us) {
+    sum += latency;
+  }
+  auto percentile = [&hit_latency_us](double p) -> uint64_t {
+    if (hit_latency_us.empty()) {
+      return 0;
+    }
+    return hit_latency_us[static_cast<size_t>(p * (hit_latency_us.size() - 1))];
+  };
+
+  auto elapsed = std::max<uint64_t>(ClockMs() - total_metrics.start_time_, 1);
+  fmt::print("<<< BEGIN\n");
+  fmt::print("miss: {}\n", total_metrics.scan_cnt_ / static_cast<double>(elapsed) * 1000);
+  fmt::print("hit: {}\n", total_metrics.get_cnt_ / static_cast<double>(elapsed) * 1000);
+  fmt::print("hit_avg_us: {:.3f}\n", hit_latency_us.empty() ? 0 : sum / static_cast<double>(hit_latency_us.size()));
+  fmt::print("hit_p50_us: {}\n", percentile(0.5));
+  fmt::print("hit_p99_us: {}\n", percentile(0.99));
+  fmt::print("hit_max_us: {}\n", percentile(1.0));
+  fmt::print(">>> END\n");
+}
+
+/**
+ * Measure the pure hit path: the working set is half of the pool and is brought in up front, so every fetch is a hit
+ * and no thread ever waits for the disk or an eviction. Runs with 1, 2, 4, ..., BUSTUB_MAX_SCALING_THREAD threads
+ * like RunScaling().
+ */
+void RunHitOnly(bustub::BufferPoolManager *bpm, const std::vector<bustub::page_id_t> &page_ids, size_t bpm_size,
+                uint64_t duration_ms) {
+  using bustub::AccessType;
+
+  size_t hot_cnt = std::min(std::max<size_t>(bpm_size / 2, 1), page_ids.size());
+  for (size_t i = 0; i < hot_cnt; i++) {
+    if (bpm->FetchPage(page_ids[i], AccessType::Get) == nullptr) {
+      throw std::runtime_error("cannot fetch hot page");
+    }
+    bpm->UnpinPage(page_ids[i], false, AccessType::Get);
+  }
+
+  size_t steps = 0;
+  for (size_t thread_cnt = 1; thread_cnt <= BUSTUB_MAX_SCALING_THREAD; thread_cnt *= 2) {
+    steps++;
+  }
+  uint64_t step_ms = std::max<uint64_t>(duration_ms / steps, 1);
+  double base_throughput = 0;
+
+  fmt::print("<<< BEGIN\n");
+  for (size_t thread_cnt = 1; thread_cnt <= BUSTUB_MAX_SCALING_THREAD; thread_cnt *= 2) {
+    BpmTotalMetrics total_metrics;
+    total_metrics.Begin();
+
+    std::vector<std::thread> threads;
+    for (size_t thread_id = 0; thread_id < thread_cnt; thread_id++) {
+      threads.emplace_back([bpm, &page_ids, hot_cnt, step_ms, &total_metrics] {
+        std::random_device r;
+        std::default_random_engine gen(r());
+        std::uniform_int_distribution<size_t> dist(0, hot_cnt - 1);
+
+        uint64_t cnt = 0;
+        uint64_t start = ClockMs();
+        while (ClockMs() - start < step_ms) {
+          auto *page = bpm->FetchPage(page_ids[dist(gen)], AccessType::Get);
+          if (page == nullptr) {
+            throw std::runtime_error("hot page is not resident");
+          }
+          bpm->UnpinPage(page->GetPageId(), false, AccessType::Get);
+          cnt++;
+        }
+
+        total_metrics.ReportGet(cnt);
+      });
+    }
+
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    auto elapsed = std::max<uint64_t>(ClockMs() - total_metrics.start_time_, 1);
+    auto throughput = total_metrics.get_cnt_ / static_cast<double>(elapsed) * 1000;
+    if (thread_cnt == 1) {
+      base_throughput = throughput;
+    }
+    fmt::print("threads={:<3} hit: {:<12.3f} speedup: {:.2f}x\n", thread_cnt, throughput,
+               base_throughput > 0 ? throughput / base_throughput : 0);
+  }
+  fmt::print(">>> END\n");
+}
+
+/**
+ * Measure the hit rate of zipfian point lookups while one thread keeps scanning all pages. The scan runs once with
+ * regular accesses and once with AccessType::Scan.
+ */
+void RunScanResistance(bustub::BufferPoolManager *bpm, const std::vector<bustub::page_id_t> &page_ids,
+                       uint64_t duration_ms) {
+  using bustub::AccessType;
+
+  fmt::print("<<< BEGIN\n");
+  for (auto scan_type : {AccessType::Get, AccessType::Scan}) {
+    std::atomic<bool> stop = false;
+    std::atomic<uint64_t> scan_cnt = 0;
+    std::thread scan_thread([bpm, &page_ids, scan_type, &stop, &scan_cnt] {
+      size_t page_idx = 0;
+      while (!stop) {
+        auto *page = bpm->FetchPage(page_ids[page_idx], scan_type);
+        page_idx = (page_idx + 1) % page_ids.size();
+        if (page == nullptr) {
+          continue;
+        }
+        bpm->UnpinPage(page->GetPageId(), false, scan_type);
+        scan_cnt++;
+      }
+    });
+
+    std::atomic<uint64_t> get_cnt = 0;
+    std::atomic<uint64_t> hit_cnt = 0;
+    std::vector<std::thread> threads;
+    for (size_t thread_id = 0; thread_id < BUSTUB_GET_THREAD; thread_id++) {
+      threads.emplace_back([bpm, &page_ids, duration_ms, &get_cnt, &hit_cnt] {
+        std::random_device r;
+        std::default_random_engine gen(r());
+        zipfian_int_distribution<size_t> dist(0, page_ids.size() - 1, 0.8);
+
+        uint64_t cnt = 0;
+        uint64_t hits = 0;
+        uint64_t start = ClockMs();
+        while (ClockMs() - start < duration_ms / 2) {
+          bustub::page_id_t page_id = page_ids[dist(gen)];
+          auto reads = Reads(page_id);
+          auto *page = bpm->FetchPage(page_id, AccessType::Get);
+          if (page == nullptr) {
+            continue;
+          }
+          hits += Reads(page_id) == reads ? 1 : 0;
+          bpm->UnpinPage(page->GetPageId(), false, AccessType::Get);
+          cnt++;
+        }
+
+        get_cnt += cnt;
+        hit_cnt += hits;
+      });
+    }
+
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    stop = true;
+    scan_thread.join();
+
+    fmt::print("scan_access={:<5} get: {:<10} scan: {:<10} hit_rate: {:.4f}\n",
+               scan_type == AccessType::Scan ? "scan" : "get", get_cnt.load(), scan_cnt.load(),
+               get_cnt > 0 ? hit_cnt / static_cast<double>(get_cnt) : 0);
+  }
+  fmt::print(">>> END\n");
+}
+
+/**
+ * Compare the replacement policies on the same single-threaded traces: zipfian point lookups, and the same lookups
+ * interleaved with a sequential scan that does not announce itself with AccessType::Scan. Every policy gets the same
+ * random sequence and an equal share of the duration.
+ */
+void RunPolicyComparison(bustub::BufferPoolManager *bpm, const std::vector<bustub::page_id_t> &page_ids,
+                         uint64_t duration_ms) {
+  using bustub::AccessType;
+  using bustub::ReplacerPolicy;
+
+  const std::vector<ReplacerPolicy> policies{ReplacerPolicy::LRUK, ReplacerPolicy::LRU, ReplacerPolicy::Clock,
+                                             ReplacerPolicy::TwoQueue, ReplacerPolicy::ARC};
+  uint64_t step_ms = std::max<uint64_t>(duration_ms / (policies.size() * 2), 1);
+
+  fmt::print("<<< BEGIN\n");
+  for (const char *trace : {"zipfian", "scan-mixed"}) {
+    bool with_scan = std::string(trace) == "scan-mixed";
+    for (auto policy : policies) {
+      bpm->SetReplacerPolicy(policy);
+      std::default_random_engine gen(42);
+      zipfian_int_distribution<size_t> dist(0, page_ids.size() - 1, 0.8);
+      std::bernoulli_distribution scan_dist(0.5);
+
+      uint64_t cnt = 0;
+      uint64_t hits = 0;
+      size_t scan_idx = 0;
+      uint64_t start = ClockMs();
+      while (ClockMs() - start < step_ms) {
+        size_t page_idx;
+        if (with_scan && scan_dist(gen)) {
+          page_idx = scan_idx;
+          scan_idx = (scan_idx + 1) % page_ids.size();
+        } else {
+          page_idx = dist(gen);
+        }
+
+        auto reads = Reads(page_ids[page_idx]);
+        auto *page = bpm->FetchPage(page_ids[page_idx], AccessType::Get);
+        if (page == nullptr) {
+          continue;
+        }
+        hits += Reads(page_ids[page_idx]) == reads ? 1 : 0;
+        bpm->UnpinPage(page->GetPageId(), false, AccessType::Get);
+        cnt++;
+      }
+
+      auto elapsed = std::max<uint64_t>(ClockMs() - start, 1);
+      fmt::print("trace={:<10} policy={:<5} ops: {:<12.3f} hit_rate: {:.4f}\n", trace,
+                 bustub::ReplacerPolicyName(policy), cnt / static_cast<double>(elapsed) * 1000,
+                 cnt > 0 ? hits / static_cast<double>(cnt) : 0);
+    }
+  }
+  fmt::print(">>> END\n");
+}
+
+/**
+ * Measure the throughput of a single sequential scan, once fetching page by page and once keeping
+ * scan_prefetch_window pages in flight with BufferPoolManager::Prefetch(). Meant to be run with --latency.
+ */
+void RunReadAhead(bustub::BufferPoolManager *bpm, const std::vector<bustub::page_id_t> &page_ids,
+                  uint64_t duration_ms) {
+  using bustub::AccessType;
+
+  fmt::print("<<< BEGIN\n");
+  for (size_t window : {static_cast<size_t>(0), bustub::scan_prefetch_window}) {
+    uint64_t cnt = 0;
+    size_t page_idx = 0;
+    size_t prefetch_idx = 0;
+    uint64_t start = ClockMs();
+    while (ClockMs() - start < duration_ms / 2) {
+      if (prefetch_idx <= page_idx) {
+        prefetch_idx = page_idx + 1;
+      }
+      std::vector<bustub::page_id_t> upcoming;
+      for (; prefetch_idx <= page_idx + window; prefetch_idx++) {
+        upcoming.push_back(page_ids[prefetch_idx % page_ids.size()]);
+      }
+      bpm->Prefetch(upcoming, AccessType::Scan);
+
+      auto *page = bpm->FetchPage(page_ids[page_idx % page_ids.size()], AccessType::Scan);
+      page_idx++;
+      if (page == nullptr) {
+        continue;
+      }
+      bpm->UnpinPage(page->GetPageId(), false, AccessType::Scan);
+      cnt++;
+    }
+
+    auto elapsed = std::max<uint64_t>(ClockMs() - start, 1);
+    fmt::print("window={:<3} scan: {}\n", window, cnt / static_cast<double>(elapsed) * 1000);
+  }
+  fmt::print(">>> END\n");
+}
+
 // NOLINTNEXTLINE
 auto main(int argc, char **argv) -> int {
   using bustub::AccessType;
   using bustub::BufferPoolManager;
+  using bustub::BufferPoolStat;
   using bustub::DiskManagerUnlimitedMemory;
   using bustub::page_id_t;
 
   argparse::ArgumentParser program("bustub-bpm-bench");
   program.add_argument("--duration").help("run bpm bench for n milliseconds");
   program.add_argument("--latency").help("set disk latency to n milliseconds");
+  program.add_argument("--bpm-size").help("number of frames in the buffer pool");
+  program.add_argument("--shards").help("number of buffer pool shards");
+  program.add_argument("--bg-writer")
+      .help("number of frames per shard the background writer keeps clean, 0 (default) disables it");
+  program.add_argument("--frame-alloc").help("frame allocation: per-frame, arena or huge-page-arena");
+  program.add_argument("--replacer").help("replacement policy: lru-k (default), lru, clock, 2q or arc");
+  program.add_argument("--pages").help("number of pages the benchmark creates and accesses");
+  program.add_argument("--db-file").help("keep the pages in this file instead of memory, the file is recreated");
+  program.add_argument("--direct-io")
+      .help("read and write the db file with O_DIRECT, bypassing the OS page cache")
+      .default_value(false)
+      .implicit_value(true);
+  program.add_argument("--stats-json").help("write the buffer pool statistics to this file as JSON when done");
+  program.add_argument("--mode").help(
+      "benchmark to run: mixed (default), scaling, hit-latency, hit-only, scan-resistance, read-ahead or policies");
 
   try {
     program.parse_args(argc, argv);
@@ -129,14 +598,104 @@ auto main(int argc, char **argv) -> int {
     latency_ms = std::stoi(program.get("--latency"));
   }
 
-  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
-  auto bpm = std::make_unique<BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
+  size_t bpm_size = BUSTUB_BPM_SIZE;
+  if (program.present("--bpm-size")) {
+    bpm_size = std::stoi(program.get("--bpm-size"));
+  }
+
+  size_t num_shards = 1;
+  if (program.present("--shards")) {
+    num_shards = std::stoi(program.get("--shards"));
+  }
+
+  size_t bg_writer_clean_frames = 0;
+  if (program.present("--bg-writer")) {
+    bg_writer_clean_frames = std::stoi(program.get("--bg-writer"));
+  }
+
+  auto frame_allocation = bustub::DEFAULT_FRAME_ALLOCATION;
+  if (program.present("--frame-alloc")) {
+    auto name = program.get("--frame-alloc");
+    if (name == "per-frame") {
+      frame_allocation = bustub::FrameAllocation::PerFrame;
+    } else if (name == "arena") {
+      frame_allocation = bustub::FrameAllocation::Arena;
+    } else if (name == "huge-page-arena") {
+      frame_allocation = bustub::FrameAllocation::HugePageArena;
+    } else {
+      std::cerr << "unknown frame allocation: " << name << std::endl;
+      return 1;
+    }
+  }
+
+  auto replacer_policy = bustub::DEFAULT_REPLACER_POLICY;
+  if (program.present("--replacer")) {
+    auto name = program.get("--replacer");
+    if (!bustub::ParseReplacerPolicy(name, &replacer_policy)) {
+      std::cerr << "unknown replacement policy: " << name << std::endl;
+      return 1;
+    }
+  }
+
+  size_t page_cnt = BUSTUB_PAGE_CNT;
+  if (program.present("--pages")) {
+    page_cnt = std::stoul(program.get("--pages"));
+  }
+
+  std::string db_file;
+  if (program.present("--db-file")) {
+    db_file = program.get("--db-file");
+  }
+  auto io_mode = program.get<bool>("--direct-io") ? bustub::DiskIOMode::Direct : bustub::DiskIOMode::Buffered;
+  if (io_mode == bustub::DiskIOMode::Direct && db_file.empty()) {
+    std::cerr << "--direct-io needs --db-file" << std::endl;
+    return 1;
+  }
+
+  std::string stats_json;
+  if (program.present("--stats-json")) {
+    stats_json = program.get("--stats-json");
+  }
+
+  std::string mode = "mixed";
+  if (program.present("--mode")) {
+    mode = program.get("--mode");
+  }
+  if (mode != "mixed" && mode != "scaling" && mode != "hit-latency" && mode != "hit-only" &&
+      mode != "scan-resistance" && mode != "read-ahead" && mode != "policies") {
+    std::cerr << "unknown mode: " << mode << std::endl;
+    return 1;
+  }
+
+  reads_of_page = std::make_unique<std::atomic<uint64_t>[]>(page_cnt);
+  reads_of_page_cnt = page_cnt;
+
+  std::unique_ptr<bustub::DiskManager> disk_manager;
+  CountingDiskManager<DiskManagerUnlimitedMemory> *memory_disk_manager = nullptr;
+  if (db_file.empty()) {
+    auto manager = std::make_unique<CountingDiskManager<DiskManagerUnlimitedMemory>>();
+    memory_disk_manager = manager.get();
+    disk_manager = std::move(manager);
+  } else {
+    // start from an empty file, together with the side files of the disk manager
+    for (const auto *suffix : {"", ".alloc", ".warm"}) {
+      std::remove((db_file + suffix).c_str());
+    }
+    disk_manager = std::make_unique<CountingDiskManager<bustub::DiskManager>>(db_file, io_mode);
+    io_mode = disk_manager->GetIOMode();
+  }
+  auto bpm = std::make_unique<BufferPoolManager>(bpm_size, disk_manager.get(), LRU_K_SIZE, nullptr, num_shards,
+                                                 frame_allocation, replacer_policy);
   std::vector<page_id_t> page_ids;
 
-  fmt::print(stderr, "[info] total_page={}, duration_ms={}, latency_ms={}, lru_k_size={}, bpm_size={}\n",
-             BUSTUB_PAGE_CNT, duration_ms, latency_ms, LRU_K_SIZE, BUSTUB_BPM_SIZE);
+  fmt::print(stderr,
+             "[info] mode={}, total_page={}, duration_ms={}, latency_ms={}, lru_k_size={}, bpm_size={}, shards={}, "
+             "bg_writer={}, replacer={}, db_file={}, io_mode={}\n",
+             mode, page_cnt, duration_ms, latency_ms, LRU_K_SIZE, bpm_size, bpm->GetNumShards(),
+             bg_writer_clean_frames, bustub::ReplacerPolicyName(replacer_policy), db_file.empty() ? "memory" : db_file,
+             io_mode == bustub::DiskIOMode::Direct ? "direct" : "buffered");
 
-  for (size_t i = 0; i < BUSTUB_PAGE_CNT; i++) {
+  for (size_t i = 0; i < page_cnt; i++) {
     page_id_t page_id;
     auto *page = bpm->NewPage(&page_id);
     if (page == nullptr) {
@@ -149,11 +708,58 @@ auto main(int argc, char **argv) -> int {
     page_ids.push_back(page_id);
   }
 
-  // enable disk latency after creating all pages
-  disk_manager->SetLatency(latency_ms);
+  // enable disk latency after creating all pages, a db file has the latency of the device it is on
+  if (memory_disk_manager != nullptr) {
+    memory_disk_manager->SetLatency(latency_ms);
+  }
+  if (bg_writer_clean_frames > 0) {
+    bpm->StartBackgroundWriter(bg_writer_clean_frames);
+  }
 
   fmt::print(stderr, "[info] benchmark start\n");
 
+  auto dump_stats = [&bpm, &stats_json] {
+    auto stats = bpm->GetStats();
+    fmt::print(stderr, "[info] hit_rate={:.4f}, evictions={}, foreground_writes={}, background_writes={}\n",
+               stats.HitRate(), stats.Get(BufferPoolStat::Eviction), stats.Get(BufferPoolStat::ForegroundWrite),
+               stats.Get(BufferPoolStat::BackgroundWrite));
+    if (!stats_json.empty()) {
+      std::ofstream out(stats_json);
+      out << stats.ToJson() << std::endl;
+    }
+  };
+
+  if (mode == "scaling") {
+    RunScaling(bpm.get(), page_ids, duration_ms);
+    dump_stats();
+    return 0;
+  }
+  if (mode == "hit-latency") {
+    RunHitLatency(bpm.get(), page_ids, bpm_size, duration_ms);
+    dump_stats();
+    return 0;
+  }
+  if (mode == "hit-only") {
+    RunHitOnly(bpm.get(), page_ids, bpm_size, duration_ms);
+    dump_stats();
+    return 0;
+  }
+  if (mode == "scan-resistance") {
+    RunScanResistance(bpm.get(), page_ids, duration_ms);
+    dump_stats();
+    return 0;
+  }
+  if (mode == "policies") {
+    RunPolicyComparison(bpm.get(), page_ids, duration_ms);
+    dump_stats();
+    return 0;
+  }
+  if (mode == "read-ahead") {
+    RunReadAhead(bpm.get(), page_ids, duration_ms);
+    dump_stats();
+    return 0;
+  }
+
   BpmTotalMetrics total_metrics;
   total_metrics.Begin();
 
@@ -164,7 +770,7 @@ auto main(int argc, char **argv) -> int {
       BpmMetrics metrics(fmt::format("scan {:>2}", thread_id), duration_ms);
       metrics.Begin();
 
-      size_t page_idx = BUSTUB_PAGE_CNT * thread_id / BUSTUB_SCAN_THREAD;
+      size_t page_idx = page_ids.size() * thread_id / BUSTUB_SCAN_THREAD;
 
       while (!metrics.ShouldFinish()) {
         auto *page = bpm->FetchPage(page_ids[page_idx], AccessType::Scan);
@@ -181,7 +787,7 @@ auto main(int argc, char **argv) -> int {
         page->WUnlatch();
 
         bpm->UnpinPage(page->GetPageId(), true, AccessType::Scan);
-        page_idx = (page_idx + 1) % BUSTUB_PAGE_CNT;
+        page_idx = (page_idx + 1) % page_ids.size();
         metrics.Tick();
         metrics.Report();
       }
@@ -194,7 +800,7 @@ auto main(int argc, char **argv) -> int {
     threads.emplace_back(std::thread([thread_id, &page_ids, &bpm, duration_ms, &total_metrics] {
       std::random_device r;
       std::default_random_engine gen(r());
-      zipfian_int_distribution<size_t> dist(0, BUSTUB_PAGE_CNT - 1, 0.8);
+      zipfian_int_distribution<size_t> dist(0, page_ids.size() - 1, 0.8);
 
       BpmMetrics metrics(fmt::format("get  {:>2}", thread_id), duration_ms);
       metrics.Begin();
@@ -227,6 +833,7 @@ auto main(int argc, char **argv) -> int {
   }
 
   total_metrics.Report();
+  dump_stats();
 
   return 0;
 }
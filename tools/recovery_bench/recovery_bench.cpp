@@ -0,0 +1,235 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "fmt/core.h"
+#include "recovery/checkpoint_manager.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_recovery.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+/** @return the files the disk manager keeps for db_file, with the log segments that exist */
+auto DatabaseFiles(const std::string &db_file) -> std::vector<std::string> {
+  auto base = db_file.substr(0, db_file.rfind('.'));
+  std::vector<std::string> files{db_file, base + ".alloc", base + ".warm", base + ".master"};
+  std::filesystem::path log_path(base + ".log");
+  std::string prefix = log_path.filename().string() + ".";
+  for (const auto &entry :
+       std::filesystem::directory_iterator(log_path.has_parent_path() ? log_path.parent_path() : ".")) {
+    std::string name = entry.path().filename().string();
+    if (name.rfind(prefix, 0) == 0) {
+      files.push_back(log_path.string() + name.substr(prefix.size() - 1));
+    }
+  }
+  return files;
+}
+
+/** Copy the files of a database, replacing the ones at the destination. */
+void CopyDatabase(const std::string &from_db_file, const std::string &to_db_file) {
+  for (const auto &file : DatabaseFiles(to_db_file)) {
+    std::filesystem::remove(file);
+  }
+  auto from_base = from_db_file.substr(0, from_db_file.rfind('.'));
+  auto to_base = to_db_file.substr(0, to_db_file.rfind('.'));
+  for (const auto &file : DatabaseFiles(from_db_file)) {
+    if (std::filesystem::exists(file)) {
+      std::filesystem::copy_file(file, to_base + file.substr(from_base.size()));
+    }
+  }
+}
+
+/**
+ * Fill a table through the write-ahead log until the log holds log_size bytes, committing every txn_size inserts, then
+ * leave num_losers transactions of txn_size inserts uncommitted and crash: the log is on disk, the dirty pages of the
+ * buffer pool are lost. With a checkpoint interval, fuzzy checkpoints are taken in the background meanwhile.
+ */
+void Crash(const std::string &db_file, size_t bpm_size, size_t log_size, size_t record_size, size_t txn_size,
+           size_t num_losers, uint64_t checkpoint_interval_ms) {
+  for (const auto &file : DatabaseFiles(db_file)) {
+    std::remove(file.c_str());
+  }
+  auto disk_manager = std::make_unique<bustub::DiskManager>(db_file);
+  auto log_manager = std::make_unique<bustub::LogManager>(disk_manager.get());
+  auto lock_manager = std::make_unique<bustub::LockManager>();
+  auto txn_manager = std::make_unique<bustub::TransactionManager>(lock_manager.get(), log_manager.get());
+  lock_manager->txn_manager_ = txn_manager.get();
+  auto bpm = std::make_unique<bustub::BufferPoolManager>(bpm_size, disk_manager.get(), bustub::LRUK_REPLACER_K,
+                                                         log_manager.get());
+  auto checkpoint_manager =
+      std::make_unique<bustub::CheckpointManager>(txn_manager.get(), log_manager.get(), bpm.get());
+  log_manager->RunFlushThread();
+  if (checkpoint_interval_ms != 0) {
+    bustub::checkpoint_interval = std::chrono::milliseconds(checkpoint_interval_ms);
+    checkpoint_manager->RunCheckpointThread();
+  }
+  auto table_heap = std::make_unique<bustub::TableHeap>(bpm.get(), log_manager.get());
+
+  // header, rid, tuple size and the offset and length of the varchar take 40 bytes of an insert record
+  bustub::Schema schema({bustub::Column("payload", bustub::TypeId::VARCHAR, record_size)});
+  bustub::Tuple tuple({bustub::ValueFactory::GetVarcharValue(std::string(record_size - 40, 'x'))}, &schema);
+  std::vector<bustub::Tuple> batch(bustub::TUPLE_BATCH_SIZE, tuple);
+  auto insert = [&table_heap, &batch, txn_size](bustub::Transaction *txn) {
+    for (size_t inserted = 0; inserted < txn_size; inserted += batch.size()) {
+      table_heap->InsertTuples({bustub::INVALID_TXN_ID, bustub::INVALID_TXN_ID, false}, batch, nullptr, txn);
+    }
+  };
+
+  uint64_t start = ClockMs();
+  while (disk_manager->GetLogFileSize() < log_size) {
+    auto *txn = txn_manager->Begin();
+    insert(txn);
+    txn_manager->Commit(txn);
+    delete txn;
+  }
+  // the losers stay active until the checkpoints stop
+  std::vector<std::unique_ptr<bustub::Transaction>> losers;
+  for (size_t i = 0; i < num_losers; i++) {
+    losers.emplace_back(txn_manager->Begin());
+    insert(losers.back().get());
+  }
+  checkpoint_manager->StopCheckpointThread();
+  log_manager->WaitUntilPersistent(log_manager->GetNextLSN() - 1);
+  log_manager->StopFlushThread();
+  fmt::print(stderr, "[info] wrote {} MB of log in {} ms\n", disk_manager->GetLogFileSize() >> 20,
+             ClockMs() - start);
+
+  table_heap.reset();
+  bpm.reset();
+  disk_manager->ShutDown();
+}
+
+/** Recover the crashed database with redo_threads redo workers and report how long each phase took. */
+void Recover(const std::string &db_file, size_t bpm_size, size_t redo_threads) {
+  auto disk_manager = std::make_unique<bustub::DiskManager>(db_file);
+  auto log_manager = std::make_unique<bustub::LogManager>(disk_manager.get());
+  auto bpm = std::make_unique<bustub::BufferPoolManager>(bpm_size, disk_manager.get(), bustub::LRUK_REPLACER_K,
+                                                         log_manager.get());
+  bustub::LogRecovery recovery(disk_manager.get(), bpm.get(), log_manager.get(), redo_threads);
+
+  uint64_t start = ClockMs();
+  recovery.Redo();
+  uint64_t redo_ms = ClockMs() - start;
+  size_t num_losers = recovery.GetNumLosers();
+  start = ClockMs();
+  recovery.Undo();
+  uint64_t undo_ms = ClockMs() - start;
+
+  fmt::print(
+      "redo_threads={:<3} log_mb={:<6} start_mb={:<6} records={:<10} redone={:<10} losers={:<3} undone={:<8} "
+      "redo_ms={:<8} undo_ms={:<8} redo_mb_per_sec={:.1f}\n",
+      redo_threads, recovery.GetLogSize() >> 20, recovery.GetRedoStart() >> 20, recovery.GetNumRecords(),
+      recovery.GetNumRedone(), num_losers, recovery.GetNumUndone(), redo_ms, undo_ms,
+      redo_ms == 0 ? 0
+                   : static_cast<double>((recovery.GetLogSize() - recovery.GetRedoStart()) >> 20) /
+                         static_cast<double>(redo_ms) * 1000);
+
+  bpm.reset();
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-recovery-bench");
+  program.add_argument("--log-size").help("size of the log to recover in MB, default 1024");
+  program.add_argument("--threads").help("comma separated numbers of redo threads, default 1,2,4,8");
+  program.add_argument("--bpm-size").help("frames of the buffer pool before the crash and during recovery");
+  program.add_argument("--record-size").help("size of the insert records, default 128 bytes");
+  program.add_argument("--txn-size").help("inserts per transaction, default 1024");
+  program.add_argument("--losers").help("transactions left uncommitted by the crash, default 4");
+  program.add_argument("--checkpoint-interval").help("milliseconds between fuzzy checkpoints, default 0 for none");
+  program.add_argument("--db-file").help("database file, the log is written next to it (default recovery_bench.db)");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  size_t log_size = size_t{1024} << 20;
+  if (program.present("--log-size")) {
+    log_size = std::stoul(program.get("--log-size")) << 20;
+  }
+
+  std::vector<size_t> thread_counts{1, 2, 4, 8};
+  if (program.present("--threads")) {
+    thread_counts.clear();
+    std::stringstream threads(program.get("--threads"));
+    for (std::string count; std::getline(threads, count, ',');) {
+      thread_counts.push_back(std::stoul(count));
+    }
+  }
+
+  size_t bpm_size = 4096;
+  if (program.present("--bpm-size")) {
+    bpm_size = std::stoul(program.get("--bpm-size"));
+  }
+
+  size_t record_size = 128;
+  if (program.present("--record-size")) {
+    record_size = std::stoul(program.get("--record-size"));
+  }
+  if (record_size <= 40 || record_size > static_cast<size_t>(bustub::BUSTUB_PAGE_SIZE / 2)) {
+    std::cerr << "record size out of range" << std::endl;
+    return 1;
+  }
+
+  size_t txn_size = 1024;
+  if (program.present("--txn-size")) {
+    txn_size = std::stoul(program.get("--txn-size"));
+  }
+
+  size_t num_losers = 4;
+  if (program.present("--losers")) {
+    num_losers = std::stoul(program.get("--losers"));
+  }
+
+  uint64_t checkpoint_interval_ms = 0;
+  if (program.present("--checkpoint-interval")) {
+    checkpoint_interval_ms = std::stoul(program.get("--checkpoint-interval"));
+  }
+
+  std::string db_file = "recovery_bench.db";
+  if (program.present("--db-file")) {
+    db_file = program.get("--db-file");
+  }
+  // every run recovers the same crash, so the crashed files are kept aside
+  std::string crash_db_file = db_file.substr(0, db_file.rfind('.')) + "-crash.db";
+
+  fmt::print(stderr,
+             "[info] db_file={}, log_size_mb={}, bpm_size={}, record_size={}, txn_size={}, losers={}, "
+             "checkpoint_interval_ms={}\n",
+             db_file, log_size >> 20, bpm_size, record_size, txn_size, num_losers, checkpoint_interval_ms);
+
+  Crash(db_file, bpm_size, log_size, record_size, txn_size, num_losers, checkpoint_interval_ms);
+  CopyDatabase(db_file, crash_db_file);
+  for (auto redo_threads : thread_counts) {
+    CopyDatabase(crash_db_file, db_file);
+    Recover(db_file, bpm_size, redo_threads);
+  }
+  for (const auto &file : DatabaseFiles(crash_db_file)) {
+    std::remove(file.c_str());
+  }
+  return 0;
+}
@@ -6,6 +6,10 @@
 #include "common/util/string_util.h"
 #include "libfort/lib/fort.hpp"
 #include "linenoise/linenoise.h"
+#include "recovery/checkpoint_manager.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_recovery.h"
+#include "storage/disk/disk_manager.h"
 #include "utf8proc/utf8proc.h"
 
 auto GetWidthOfUtf8(const void *beg, const void *end, size_t *width) -> int {
@@ -27,22 +31,38 @@ auto GetWidthOfUtf8(const void *beg, const void *end, size_t *width) -> int {
 auto main(int argc, char **argv) -> int {
   ft_set_u8strwid_func(&GetWidthOfUtf8);
 
-  auto bustub = std::make_unique<bustub::BustubInstance>("test.db");
-
   auto default_prompt = "bustub> ";
   auto emoji_prompt = "\U0001f6c1> ";  // the bathtub emoji
   bool use_emoji_prompt = false;
   bool disable_tty = false;
+  auto io_mode = bustub::DiskIOMode::Buffered;
+  bool enable_wal = false;
 
   for (int i = 1; i < argc; i++) {
     if (strcmp(argv[i], "--emoji-prompt") == 0) {
       use_emoji_prompt = true;
-      break;
     }
     if (strcmp(argv[i], "--disable-tty") == 0) {
       disable_tty = true;
-      break;
     }
+    if (strcmp(argv[i], "--direct-io") == 0) {
+      io_mode = bustub::DiskIOMode::Direct;
+    }
+    if (strcmp(argv[i], "--wal") == 0) {
+      enable_wal = true;
+    }
+  }
+
+  auto bustub = std::make_unique<bustub::BustubInstance>("test.db", io_mode);
+  if (enable_wal) {
+    // bring the pages back to the state test.log leaves them in, then every commit waits until its commit record is
+    // in test.log and checkpoints bound what the next start has to read of it
+    bustub::LogRecovery recovery(bustub->disk_manager_.get(), bustub->buffer_pool_manager_.get(),
+                                 bustub->log_manager_.get());
+    recovery.Redo();
+    recovery.Undo();
+    bustub->log_manager_->RunFlushThread();
+    bustub->checkpoint_manager_->RunCheckpointThread();
   }
 
   bustub->GenerateMockTable();
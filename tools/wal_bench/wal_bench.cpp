@@ -0,0 +1,183 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "common/config.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "fmt/core.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "type/value_factory.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+/** Start from an empty log. */
+void RemoveLog(const std::string &db_file) {
+  // the disk manager drops the log segments of a db file it creates
+  std::remove(db_file.c_str());
+}
+
+/**
+ * Append insert records of record_size bytes from the given number of threads for duration_ms, without waiting for
+ * them to be persistent, and report the records appended per second.
+ */
+void RunAppends(const std::string &db_file, size_t num_threads, size_t record_size, uint64_t duration_ms) {
+  RemoveLog(db_file);
+  auto disk_manager = std::make_unique<bustub::DiskManager>(db_file);
+  auto log_manager = std::make_unique<bustub::LogManager>(disk_manager.get());
+  log_manager->RunFlushThread();
+
+  // header, rid, tuple size and the offset and length of the varchar take 40 bytes of a record
+  bustub::Schema schema({bustub::Column("payload", bustub::TypeId::VARCHAR, record_size)});
+  bustub::Tuple tuple({bustub::ValueFactory::GetVarcharValue(std::string(record_size - 40, 'x'))}, &schema);
+
+  std::atomic<uint64_t> appends = 0;
+  std::vector<std::thread> threads;
+  uint64_t start = ClockMs();
+  for (size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+    threads.emplace_back([&log_manager, &appends, &tuple, thread_id, start, duration_ms] {
+      uint64_t cnt = 0;
+      while (ClockMs() - start < duration_ms) {
+        bustub::LogRecord record(static_cast<bustub::txn_id_t>(thread_id), bustub::INVALID_LSN,
+                                 bustub::LogRecordType::INSERT,
+                                 bustub::RID(static_cast<bustub::page_id_t>(thread_id), static_cast<uint32_t>(cnt)),
+                                 tuple);
+        log_manager->AppendLogRecord(&record);
+        cnt++;
+      }
+      appends += cnt;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  uint64_t elapsed_ms = ClockMs() - start;
+
+  log_manager->StopFlushThread();
+  fmt::print("threads={:<3} appends={:<10} appends_per_sec={:<12.1f} log_writes={}\n", num_threads, appends.load(),
+             appends / static_cast<double>(elapsed_ms) * 1000, disk_manager->GetNumFlushes());
+  disk_manager->ShutDown();
+}
+
+/**
+ * Commit empty transactions from the given number of threads for duration_ms against a fresh log, and report the
+ * commits per second and how many commits shared one log write.
+ */
+void RunCommits(const std::string &db_file, size_t num_threads, uint64_t duration_ms) {
+  RemoveLog(db_file);
+  auto disk_manager = std::make_unique<bustub::DiskManager>(db_file);
+  auto log_manager = std::make_unique<bustub::LogManager>(disk_manager.get());
+  auto lock_manager = std::make_unique<bustub::LockManager>();
+  auto txn_manager = std::make_unique<bustub::TransactionManager>(lock_manager.get(), log_manager.get());
+  lock_manager->txn_manager_ = txn_manager.get();
+  log_manager->RunFlushThread();
+
+  std::atomic<uint64_t> commits = 0;
+  std::vector<std::thread> threads;
+  uint64_t start = ClockMs();
+  for (size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+    threads.emplace_back([&txn_manager, &commits, start, duration_ms] {
+      uint64_t cnt = 0;
+      while (ClockMs() - start < duration_ms) {
+        auto *txn = txn_manager->Begin();
+        txn_manager->Commit(txn);
+        cnt++;
+      }
+      commits += cnt;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  uint64_t elapsed_ms = ClockMs() - start;
+
+  log_manager->StopFlushThread();
+  auto flushes = static_cast<uint64_t>(disk_manager->GetNumFlushes());
+  fmt::print("threads={:<3} commits={:<9} commits_per_sec={:<10.1f} log_writes={:<7} commits_per_write={:.2f}\n",
+             num_threads, commits.load(), commits / static_cast<double>(elapsed_ms) * 1000, flushes,
+             flushes == 0 ? 0 : commits / static_cast<double>(flushes));
+  disk_manager->ShutDown();
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-wal-bench");
+  program.add_argument("--duration").help("run every thread count for n milliseconds");
+  program.add_argument("--threads").help("comma separated numbers of committing threads, default 1,2,4,8,16,32,64");
+  program.add_argument("--mode").help(
+      "benchmark to run: commit (default) commits empty transactions, append appends records without committing");
+  program.add_argument("--record-size").help("size of the records appended by the append mode, default 128 bytes");
+  program.add_argument("--db-file").help("database file, the log is written next to it (default wal_bench.db)");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  uint64_t duration_ms = 5000;
+  if (program.present("--duration")) {
+    duration_ms = std::stoi(program.get("--duration"));
+  }
+
+  std::vector<size_t> thread_counts{1, 2, 4, 8, 16, 32, 64};
+  if (program.present("--threads")) {
+    thread_counts.clear();
+    std::stringstream threads(program.get("--threads"));
+    for (std::string count; std::getline(threads, count, ',');) {
+      thread_counts.push_back(std::stoul(count));
+    }
+  }
+
+  std::string db_file = "wal_bench.db";
+  if (program.present("--db-file")) {
+    db_file = program.get("--db-file");
+  }
+
+  std::string mode = "commit";
+  if (program.present("--mode")) {
+    mode = program.get("--mode");
+  }
+  if (mode != "commit" && mode != "append") {
+    std::cerr << "unknown mode: " << mode << std::endl;
+    return 1;
+  }
+
+  size_t record_size = 128;
+  if (program.present("--record-size")) {
+    record_size = std::stoul(program.get("--record-size"));
+  }
+  if (record_size <= 40 || record_size > static_cast<size_t>(bustub::LOG_BUFFER_SIZE)) {
+    std::cerr << "record size out of range" << std::endl;
+    return 1;
+  }
+
+  fmt::print(stderr, "[info] mode={}, db_file={}, duration_ms={}, log_buffer_size={}, log_timeout_ms={}\n", mode,
+             db_file, duration_ms, bustub::LOG_BUFFER_SIZE,
+             std::chrono::duration_cast<std::chrono::milliseconds>(bustub::log_timeout).count());
+
+  for (auto num_threads : thread_counts) {
+    if (mode == "append") {
+      RunAppends(db_file, num_threads, record_size, duration_ms);
+    } else {
+      RunCommits(db_file, num_threads, duration_ms);
+    }
+  }
+  return 0;
+}